@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include "bkpt_index.h"
+
+struct bkpt_index_node
+{
+    U64 address;
+    unsigned int length;
+    void *data;
+    struct bkpt_index_node *next;
+};
+
+struct bkpt_index
+{
+    struct bkpt_index_node **bucket;
+    unsigned int mask;          ///< The count of buckets - 1
+    unsigned int count;
+    unsigned int max_length;    ///< The longest item ever inserted
+};
+
+static unsigned int
+bkpt_index_hash (struct bkpt_index *idx, U64 page)
+{
+    page ^= page >> 29;
+    return (unsigned int)(page * 0x9E3779B97F4A7C15ULL >> 32) & idx->mask;
+}
+
+struct bkpt_index *
+bkpt_index_create (void)
+{
+    struct bkpt_index *idx;
+
+    idx = calloc (1, sizeof (struct bkpt_index));
+    if (idx == NULL) {
+        return NULL;
+    }
+    idx->bucket = calloc (BKPT_INDEX_MIN_BUCKETS, sizeof (struct bkpt_index_node *));
+    if (idx->bucket == NULL) {
+        free (idx);
+        return NULL;
+    }
+    idx->mask = BKPT_INDEX_MIN_BUCKETS - 1;
+    return idx;
+}
+
+void
+bkpt_index_destroy (struct bkpt_index *idx)
+{
+    unsigned int i;
+
+    if (idx == NULL) {
+        return;
+    }
+    for (i = 0; i <= idx->mask; i++) {
+        struct bkpt_index_node *n = idx->bucket[i], *next;
+
+        for (; n; n = next) {
+            next = n->next;
+            free (n);
+        }
+    }
+    free (idx->bucket);
+    free (idx);
+}
+
+/* Double the buckets, keep the old ones if out of memory.  */
+static void
+bkpt_index_grow (struct bkpt_index *idx)
+{
+    struct bkpt_index_node **old = idx->bucket, *n, *next;
+    unsigned int i, old_mask = idx->mask;
+
+    idx->bucket = calloc ((size_t)(old_mask + 1) * 2, sizeof (struct bkpt_index_node *));
+    if (idx->bucket == NULL) {
+        idx->bucket = old;
+        return;
+    }
+    idx->mask = old_mask * 2 + 1;
+    for (i = 0; i <= old_mask; i++) {
+        for (n = old[i]; n; n = next) {
+            unsigned int h = bkpt_index_hash (idx, n->address >> BKPT_INDEX_PAGE_SHIFT);
+
+            next = n->next;
+            n->next = idx->bucket[h];
+            idx->bucket[h] = n;
+        }
+    }
+    free (old);
+}
+
+int
+bkpt_index_insert (struct bkpt_index *idx, U64 address, unsigned int length, void *data)
+{
+    struct bkpt_index_node *n;
+    unsigned int h;
+
+    if (idx == NULL || bkpt_index_find (idx, address) != NULL) {
+        return -1;
+    }
+    n = malloc (sizeof (struct bkpt_index_node));
+    if (n == NULL) {
+        return -1;
+    }
+    if (idx->count >= idx->mask + 1) {
+        bkpt_index_grow (idx);
+    }
+    h = bkpt_index_hash (idx, address >> BKPT_INDEX_PAGE_SHIFT);
+    n->address = address;
+    n->length = length ? length : 1;
+    n->data = data;
+    n->next = idx->bucket[h];
+    idx->bucket[h] = n;
+    idx->count++;
+    if (n->length > idx->max_length) {
+        idx->max_length = n->length;
+    }
+    return 0;
+}
+
+void *
+bkpt_index_find (struct bkpt_index *idx, U64 address)
+{
+    struct bkpt_index_node *n;
+
+    if (idx == NULL) {
+        return NULL;
+    }
+    n = idx->bucket[bkpt_index_hash (idx, address >> BKPT_INDEX_PAGE_SHIFT)];
+    for (; n; n = n->next) {
+        if (n->address == address) {
+            return n->data;
+        }
+    }
+    return NULL;
+}
+
+void *
+bkpt_index_remove (struct bkpt_index *idx, U64 address)
+{
+    struct bkpt_index_node **pn, *n;
+    void *data;
+
+    if (idx == NULL) {
+        return NULL;
+    }
+    pn = &idx->bucket[bkpt_index_hash (idx, address >> BKPT_INDEX_PAGE_SHIFT)];
+    for (; *pn; pn = &(*pn)->next) {
+        if ((*pn)->address == address) {
+            n = *pn;
+            *pn = n->next;
+            data = n->data;
+            free (n);
+            idx->count--;
+            return data;
+        }
+    }
+    return NULL;
+}
+
+int
+bkpt_index_foreach (struct bkpt_index *idx, bkpt_index_visit_t visit, void *priv)
+{
+    struct bkpt_index_node *n, *next;
+    unsigned int i;
+    int visited = 0;
+
+    if (idx == NULL || visit == NULL) {
+        return 0;
+    }
+    for (i = 0; i <= idx->mask; i++) {
+        /* The visitor may remove the current item.  */
+        for (n = idx->bucket[i]; n; n = next) {
+            next = n->next;
+            visited++;
+            if (visit (priv, n->address, n->data)) {
+                return visited;
+            }
+        }
+    }
+    return visited;
+}
+
+int
+bkpt_index_foreach_range (struct bkpt_index *idx, U64 address, unsigned int size,
+                          bkpt_index_visit_t visit, void *priv)
+{
+    struct bkpt_index_node *n, *next;
+    U64 lo, end, page, first, last;
+    int visited = 0;
+
+    if (idx == NULL || visit == NULL || size == 0 || idx->count == 0) {
+        return 0;
+    }
+    /* Items starting before the range may still reach into it.  */
+    end = address + size;
+    lo = address >= idx->max_length - 1 ? address - (idx->max_length - 1) : 0;
+    first = lo >> BKPT_INDEX_PAGE_SHIFT;
+    last = (end - 1) >> BKPT_INDEX_PAGE_SHIFT;
+
+    if (last - first > idx->mask) {
+        /* The range is larger than the table, scan it all.  */
+        unsigned int i;
+
+        for (i = 0; i <= idx->mask; i++) {
+            for (n = idx->bucket[i]; n; n = next) {
+                next = n->next;
+                if (n->address < end && n->address + n->length > address) {
+                    visited++;
+                    if (visit (priv, n->address, n->data)) {
+                        return visited;
+                    }
+                }
+            }
+        }
+        return visited;
+    }
+
+    for (page = first; page <= last; page++) {
+        n = idx->bucket[bkpt_index_hash (idx, page)];
+        for (; n; n = next) {
+            next = n->next;
+            if ((n->address >> BKPT_INDEX_PAGE_SHIFT) != page) {
+                continue;
+            }
+            if (n->address < end && n->address + n->length > address) {
+                visited++;
+                if (visit (priv, n->address, n->data)) {
+                    return visited;
+                }
+            }
+        }
+    }
+    return visited;
+}
+
+unsigned int
+bkpt_index_count (struct bkpt_index *idx)
+{
+    return idx ? idx->count : 0;
+}
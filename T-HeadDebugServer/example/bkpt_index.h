@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: bkpt_index.h
+// function description: address index of breakpoints and watchpoints, hashed
+//                       by small address pages so exact and range lookups
+//                       do not scan all of them.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_BKPT_INDEX_H__
+#define __DEBUGGER_SERVER_EXAMPLE_BKPT_INDEX_H__
+
+#include "dbg-target.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BKPT_INDEX_PAGE_SHIFT   6       ///< Items are hashed by (address >> 6)
+#define BKPT_INDEX_MIN_BUCKETS  64      ///< Initial buckets, must be power of 2
+
+/**
+  \brief        The callback for items of the index
+  \param[in]    priv, the private data of the caller
+  \param[in]    address, the address of the item
+  \param[in]    data, the data of the item
+  \return       zero to continue, non-zero to stop
+*/
+typedef int (*bkpt_index_visit_t) (void *priv, U64 address, void *data);
+
+/// definition for index, see bkpt_index.c
+struct bkpt_index;
+
+/**
+  \brief        Create an empty index
+  \return       A handle for success, otherwise return NULL
+*/
+struct bkpt_index *bkpt_index_create (void);
+
+/**
+  \brief        Destroy the index, data of items are not freed
+  \param[in]    idx, the handle of index
+  \return       None
+*/
+void bkpt_index_destroy (struct bkpt_index *idx);
+
+/**
+  \brief        Insert an item
+  \param[in]    idx, the handle of index
+  \param[in]    address, the address of the item, it is the key
+  \param[in]    length, the length of the item, used by range lookups
+  \param[in]    data, the data of the item
+  \return       zero for success, negative for error or the address exists
+*/
+int bkpt_index_insert (struct bkpt_index *idx, U64 address, unsigned int length, void *data);
+
+/**
+  \brief        Find the item at the address
+  \param[in]    idx, the handle of index
+  \param[in]    address, the address of the item
+  \return       The data of the item, NULL for not found
+*/
+void *bkpt_index_find (struct bkpt_index *idx, U64 address);
+
+/**
+  \brief        Remove the item at the address
+  \param[in]    idx, the handle of index
+  \param[in]    address, the address of the item
+  \return       The data of the item removed, NULL for not found
+*/
+void *bkpt_index_remove (struct bkpt_index *idx, U64 address);
+
+/**
+  \brief        Visit items overlapping [address, address + size)
+  \param[in]    idx, the handle of index
+  \param[in]    address, the start of the range
+  \param[in]    size, the size of the range
+  \param[in]    visit, called for each item, the order is not defined
+  \param[in]    priv, passed to visit
+  \return       The count of items visited
+*/
+int bkpt_index_foreach_range (struct bkpt_index *idx, U64 address, unsigned int size,
+                              bkpt_index_visit_t visit, void *priv);
+
+/**
+  \brief        Visit all items, the order is not defined
+  \param[in]    idx, the handle of index
+  \param[in]    visit, called for each item
+  \param[in]    priv, passed to visit
+  \return       The count of items visited
+*/
+int bkpt_index_foreach (struct bkpt_index *idx, bkpt_index_visit_t visit, void *priv);
+
+/**
+  \brief        Get the count of items
+  \param[in]    idx, the handle of index
+  \return       The count of items
+*/
+unsigned int bkpt_index_count (struct bkpt_index *idx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_BKPT_INDEX_H__
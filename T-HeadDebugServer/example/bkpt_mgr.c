@@ -0,0 +1,889 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bkpt_mgr.h"
+#include "bkpt_index.h"
+#include "mem_access.h"
+#include "mem_iov.h"
+
+/* Opcodes of the trap instructions, little endian.  */
+#define CSKY_BKPT16         0x0000u         // bkpt
+#define RV_EBREAK16         0x9002u         // c.ebreak
+#define RV_EBREAK32         0x00100073u     // ebreak
+
+/* A breakpoint in the manager.  bp.set is the state on the target, it
+   differs from want only for lazy soft breakpoints before sync.  */
+struct bkpt_entry
+{
+    struct breakpoint bp;
+    int want;                   ///< The breakpoint should be on the target
+};
+
+struct bkpt_mgr
+{
+    struct target *tgt;
+    enum debug_arch_type arch;
+    int lazy;                   ///< Soft breakpoints are written by bkpt_mgr_sync
+    int cache_flush;            ///< The cache flush setting of the caller
+    int flush_once;             ///< Cache flush is on only for the next run
+    struct bkpt_index *bkpts;
+    struct bkpt_index *wpts;
+    struct bkpt_mgr_stats stats;
+};
+
+struct bkpt_mgr *
+bkpt_mgr_create (struct target *tgt)
+{
+    struct bkpt_mgr *m;
+
+    if (tgt == NULL) {
+        return NULL;
+    }
+    m = calloc (1, sizeof (struct bkpt_mgr));
+    if (m == NULL) {
+        return NULL;
+    }
+    m->tgt = tgt;
+    m->arch = target_get_debug_arch_type (tgt);
+    m->bkpts = bkpt_index_create ();
+    m->wpts = bkpt_index_create ();
+    if (m->bkpts == NULL || m->wpts == NULL) {
+        bkpt_mgr_destroy (m);
+        return NULL;
+    }
+    return m;
+}
+
+static int
+bkpt_mgr_free_item (void *priv, U64 address, void *data)
+{
+    free (data);
+    return 0;
+}
+
+void
+bkpt_mgr_destroy (struct bkpt_mgr *m)
+{
+    if (m == NULL) {
+        return;
+    }
+    /* The run which flush_once is for never comes.  */
+    bkpt_mgr_run_done (m);
+    bkpt_index_foreach (m->bkpts, bkpt_mgr_free_item, NULL);
+    bkpt_index_foreach (m->wpts, bkpt_mgr_free_item, NULL);
+    bkpt_index_destroy (m->bkpts);
+    bkpt_index_destroy (m->wpts);
+    free (m);
+}
+
+/* Get the trap instruction of the length, little endian.  */
+static int
+bkpt_mgr_trap (struct bkpt_mgr *m, unsigned int length, unsigned char *code)
+{
+    unsigned int op;
+    unsigned int i;
+
+    if (length == 2) {
+        op = m->arch == DEBUG_ARCH_RISCV ? RV_EBREAK16 : CSKY_BKPT16;
+    } else if (length == 4) {
+        /* Two 16-bit bkpt for C-SKY.  */
+        op = m->arch == DEBUG_ARCH_RISCV ? RV_EBREAK32 : (CSKY_BKPT16 << 16 | CSKY_BKPT16);
+    } else {
+        return -1;
+    }
+    for (i = 0; i < length; i++) {
+        code[i] = (op >> (i * 8)) & 0xff;
+    }
+    return 0;
+}
+
+/* The patched code must be fetched again.  Cache flush is turned on
+   for the next run only, bkpt_mgr_run_done turns it back.  */
+static void
+bkpt_mgr_flush_once (struct bkpt_mgr *m)
+{
+    if (!m->cache_flush && !m->flush_once
+        && target_enable_cache_flush (m->tgt, 1) >= 0) {
+        m->flush_once = 1;
+    }
+}
+
+static int
+bkpt_mgr_insert_soft (struct bkpt_mgr *m, struct breakpoint *bp)
+{
+    unsigned char orig[4], code[4];
+    unsigned int i;
+
+    if (bkpt_mgr_trap (m, bp->length, code) < 0) {
+        return -1;
+    }
+    if (mem_access_read (m->tgt, bp->address, orig, bp->length) < 0) {
+        return -1;
+    }
+    bp->orig_instr = 0;
+    for (i = 0; i < bp->length; i++) {
+        bp->orig_instr |= (unsigned int)orig[i] << (i * 8);
+    }
+    if (mem_access_write (m->tgt, bp->address, code, bp->length) < 0) {
+        return -1;
+    }
+    bkpt_mgr_flush_once (m);
+    bp->set = 1;
+    return 0;
+}
+
+static int
+bkpt_mgr_remove_soft (struct bkpt_mgr *m, struct breakpoint *bp)
+{
+    unsigned char orig[4];
+    unsigned int i;
+
+    for (i = 0; i < bp->length; i++) {
+        orig[i] = (bp->orig_instr >> (i * 8)) & 0xff;
+    }
+    if (mem_access_write (m->tgt, bp->address, orig, bp->length) < 0) {
+        return -1;
+    }
+    bkpt_mgr_flush_once (m);
+    bp->set = 0;
+    return 0;
+}
+
+#define BKPT_MGR_OVERLAP_MAX    8
+
+struct bkpt_mgr_overlap
+{
+    int found;                  ///< A wanted breakpoint overlaps
+    int count;
+    struct bkpt_entry *stale[BKPT_MGR_OVERLAP_MAX];  ///< Pending removal
+};
+
+static int
+bkpt_mgr_found (void *priv, U64 address, void *data)
+{
+    struct bkpt_mgr_overlap *ov = priv;
+    struct bkpt_entry *e = data;
+
+    if (e->want || ov->count == BKPT_MGR_OVERLAP_MAX) {
+        ov->found = 1;
+        return 1;
+    }
+    ov->stale[ov->count++] = e;
+    return 0;
+}
+
+static int bkpt_mgr_drop (struct bkpt_mgr *m, struct bkpt_entry *e);
+
+/* The original instruction of a soft breakpoint would be lost if
+   another one is written over it.  Ones pending removal do not count,
+   bkpt_mgr_sync removes them before writing new ones; without lazy they
+   are only left by a failed sync, so they are dropped here.  */
+static int
+bkpt_mgr_overlaps (struct bkpt_mgr *m, U64 address, unsigned int length)
+{
+    struct bkpt_mgr_overlap ov;
+    int i;
+
+    memset (&ov, 0, sizeof (ov));
+    bkpt_index_foreach_range (m->bkpts, address, length, bkpt_mgr_found, &ov);
+    if (ov.found) {
+        return 1;
+    }
+    for (i = 0; !m->lazy && i < ov.count; i++) {
+        if (bkpt_mgr_drop (m, ov.stale[i]) < 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Take the breakpoint off the target and out of the manager.  */
+static int
+bkpt_mgr_drop (struct bkpt_mgr *m, struct bkpt_entry *e)
+{
+    int ret = 0;
+
+    if (e->bp.set) {
+        if (e->bp.type == BKPT_SOFT) {
+            ret = bkpt_mgr_remove_soft (m, &e->bp);
+        } else {
+            ret = breakpoint_remove (m->tgt, e->bp.address);
+        }
+        if (ret < 0) {
+            return ret;
+        }
+    }
+    bkpt_index_remove (m->bkpts, e->bp.address);
+    free (e);
+    return 0;
+}
+
+int
+bkpt_mgr_breakpoint_add (struct bkpt_mgr *m, U64 address,
+                         unsigned int length, enum bkpt_type type)
+{
+    struct bkpt_entry *e;
+    int ret = 0;
+
+    if (m == NULL || (length != 2 && length != 4)
+        || (type != BKPT_SOFT && type != BKPT_HARD)) {
+        return -1;
+    }
+    e = bkpt_index_find (m->bkpts, address);
+    if (e) {
+        if (e->want) {
+            return -1;
+        }
+        /* Removed and added again before resuming, nothing to write.  */
+        if (e->bp.length == length && e->bp.type == type) {
+            e->want = 1;
+            m->stats.skipped++;
+            return 0;
+        }
+        if (bkpt_mgr_drop (m, e) < 0) {
+            return -1;
+        }
+    }
+    if (bkpt_mgr_overlaps (m, address, length)) {
+        return -1;
+    }
+    e = calloc (1, sizeof (struct bkpt_entry));
+    if (e == NULL) {
+        return -1;
+    }
+    e->bp.address = address;
+    e->bp.length = length;
+    e->bp.type = type;
+    e->bp.index = -1;
+    e->want = 1;
+
+    if (type == BKPT_SOFT) {
+        /* Lazy ones are written by bkpt_mgr_sync.  */
+        if (!m->lazy) {
+            ret = bkpt_mgr_insert_soft (m, &e->bp);
+        }
+    } else {
+        ret = breakpoint_add (m->tgt, address, length, BKPT_HARD);
+        if (ret >= 0) {
+            struct breakpoint *hw = breakpoint_find (m->tgt, address);
+
+            e->bp.set = 1;
+            e->bp.index = hw ? hw->index : -1;
+        }
+    }
+    if (ret < 0 || bkpt_index_insert (m->bkpts, address, length, e) < 0) {
+        if (ret >= 0 && e->bp.set) {
+            if (type == BKPT_SOFT) {
+                bkpt_mgr_remove_soft (m, &e->bp);
+            } else {
+                breakpoint_remove (m->tgt, address);
+            }
+        }
+        free (e);
+        return -1;
+    }
+    return 0;
+}
+
+int
+bkpt_mgr_breakpoint_remove (struct bkpt_mgr *m, U64 address)
+{
+    struct bkpt_entry *e;
+
+    if (m == NULL) {
+        return -1;
+    }
+    e = bkpt_index_find (m->bkpts, address);
+    if (e == NULL || !e->want) {
+        return -1;
+    }
+    /* Lazy ones stay on the target until bkpt_mgr_sync.  */
+    if (m->lazy && e->bp.type == BKPT_SOFT && e->bp.set) {
+        e->want = 0;
+        return 0;
+    }
+    return bkpt_mgr_drop (m, e);
+}
+
+struct breakpoint *
+bkpt_mgr_breakpoint_find (struct bkpt_mgr *m, U64 address)
+{
+    struct bkpt_entry *e;
+
+    if (m == NULL) {
+        return NULL;
+    }
+    m->stats.finds++;
+    e = bkpt_index_find (m->bkpts, address);
+    return e && e->want ? &e->bp : NULL;
+}
+
+struct bkpt_mgr_clear_ctx
+{
+    struct bkpt_mgr *m;
+    int failed;
+};
+
+static int
+bkpt_mgr_clear_breakpoint (void *priv, U64 address, void *data)
+{
+    struct bkpt_mgr_clear_ctx *ctx = priv;
+    struct bkpt_entry *e = data;
+
+    if (e->want && bkpt_mgr_breakpoint_remove (ctx->m, address) < 0) {
+        ctx->failed++;
+    }
+    return 0;
+}
+
+int
+bkpt_mgr_breakpoint_clear (struct bkpt_mgr *m)
+{
+    struct bkpt_mgr_clear_ctx ctx = {m, 0};
+
+    if (m == NULL) {
+        return -1;
+    }
+    bkpt_index_foreach (m->bkpts, bkpt_mgr_clear_breakpoint, &ctx);
+    return ctx.failed ? -1 : 0;
+}
+
+/*----- Batched soft breakpoints -----*/
+
+struct bkpt_batch_item
+{
+    struct bkpt_entry *e;       ///< The breakpoint in the manager
+    int index;                  ///< Index in the caller's array
+};
+
+struct bkpt_batch
+{
+    struct bkpt_batch_item *items;
+    int count;
+};
+
+static int
+bkpt_batch_compare (const void *a, const void *b)
+{
+    const struct bkpt_batch_item *ia = a;
+    const struct bkpt_batch_item *ib = b;
+
+    if (ia->e->bp.address != ib->e->bp.address)
+        return ia->e->bp.address < ib->e->bp.address ? -1 : 1;
+    return ia->index < ib->index ? -1 : (ia->index > ib->index);
+}
+
+static int
+bkpt_batch_init (struct bkpt_batch *batch, int count)
+{
+    batch->count = 0;
+    batch->items = malloc (sizeof (struct bkpt_batch_item) * (count ? count : 1));
+    return batch->items ? 0 : -1;
+}
+
+static void
+bkpt_batch_add (struct bkpt_batch *batch, struct bkpt_entry *e, int index)
+{
+    batch->items[batch->count].e = e;
+    batch->items[batch->count].index = index;
+    batch->count++;
+}
+
+/* Insert or remove the soft breakpoints of the batch, they must be
+   sorted by address and not overlap.  Breakpoints are grouped by
+   BKPT_BATCH_PAGE_SIZE pages, each page is read and written once from
+   the first breakpoint to the end of the last one.  bp.set is updated
+   for the breakpoints done, the count of failed ones is returned.  */
+static int
+bkpt_batch_apply (struct bkpt_mgr *m, struct bkpt_batch *batch, int insert)
+{
+    enum target_continuous_mem_op_state op = TARGET_CONTINUOUS_MEM_OPERATION_START;
+    struct mem_iov *spans;
+    int *span_of, *span_failed;
+    unsigned char *buff = NULL;
+    unsigned int total = 0;
+    int i, nspans = 0, failed = 0;
+
+    if (batch->count == 0) {
+        return 0;
+    }
+    spans = malloc (sizeof (struct mem_iov) * batch->count);
+    span_of = malloc (sizeof (int) * batch->count);
+    span_failed = calloc (batch->count, sizeof (int));
+    if (spans == NULL || span_of == NULL || span_failed == NULL) {
+        failed = batch->count;
+        goto out;
+    }
+
+    for (i = 0; i < batch->count; i++) {
+        struct breakpoint *bp = &batch->items[i].e->bp;
+        struct mem_iov *span = &spans[nspans - 1];
+
+        if (nspans == 0 || bp->address / BKPT_BATCH_PAGE_SIZE
+                           != span->addr / BKPT_BATCH_PAGE_SIZE) {
+            span = &spans[nspans++];
+            span->addr = bp->address;
+            span->size = 0;
+        }
+        if (bp->address + bp->length - span->addr > span->size) {
+            span->size = (unsigned int)(bp->address + bp->length - span->addr);
+        }
+        span_of[i] = nspans - 1;
+    }
+    for (i = 0; i < nspans; i++) {
+        total += spans[i].size;
+    }
+    buff = malloc (total);
+    if (buff == NULL) {
+        failed = batch->count;
+        goto out;
+    }
+    for (i = 0, total = 0; i < nspans; i++) {
+        spans[i].buff = buff + total;
+        total += spans[i].size;
+    }
+
+    /* The bytes between breakpoints are written back unchanged.  */
+    m->stats.batch_reads += nspans;
+    if (target_read_memory_v (m->tgt, spans, nspans) < 0) {
+        failed = batch->count;
+        goto out;
+    }
+    for (i = 0; i < batch->count; i++) {
+        struct breakpoint *bp = &batch->items[i].e->bp;
+        unsigned char *p = spans[span_of[i]].buff + (bp->address - spans[span_of[i]].addr);
+        unsigned int j;
+
+        if (insert) {
+            bp->orig_instr = 0;
+            for (j = 0; j < bp->length; j++) {
+                bp->orig_instr |= (unsigned int)p[j] << (j * 8);
+            }
+            bkpt_mgr_trap (m, bp->length, p);
+        } else {
+            for (j = 0; j < bp->length; j++) {
+                p[j] = (bp->orig_instr >> (j * 8)) & 0xff;
+            }
+        }
+    }
+
+    target_config_target (m->tgt, TARGET_CONFIG_CONTINUOUS_MEM_OPERATION, &op);
+    for (i = 0; i < nspans; i++) {
+        m->stats.batch_writes++;
+        if (mem_access_write (m->tgt, spans[i].addr, spans[i].buff, spans[i].size) < 0) {
+            span_failed[i] = 1;
+        }
+    }
+    op = TARGET_CONTINUOUS_MEM_OPERATION_END;
+    target_config_target (m->tgt, TARGET_CONFIG_CONTINUOUS_MEM_OPERATION, &op);
+
+    bkpt_mgr_flush_once (m);
+
+    for (i = 0; i < batch->count; i++) {
+        if (span_failed[span_of[i]]) {
+            failed++;
+        } else {
+            batch->items[i].e->bp.set = insert;
+        }
+    }
+
+out:
+    free (spans);
+    free (span_of);
+    free (span_failed);
+    free (buff);
+    return failed;
+}
+
+int
+bkpt_mgr_breakpoint_add_batch (struct bkpt_mgr *m, struct breakpoint *bps, int count)
+{
+    struct bkpt_batch batch;
+    int i, n, failed = 0;
+
+    if (m == NULL || (bps == NULL && count != 0) || count < 0) {
+        return -1;
+    }
+    if (bkpt_batch_init (&batch, count) < 0) {
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        struct bkpt_entry *e;
+
+        bps[i].set = 0;
+        bps[i].next = NULL;
+        /* Hard breakpoints are limited resources, lazy soft ones are
+           only recorded.  Add them one by one.  */
+        if (bps[i].type != BKPT_SOFT || m->lazy) {
+            if (bkpt_mgr_breakpoint_add (m, bps[i].address, bps[i].length, bps[i].type) < 0) {
+                failed++;
+            } else {
+                bps[i] = *bkpt_mgr_breakpoint_find (m, bps[i].address);
+            }
+            continue;
+        }
+        if ((bps[i].length != 2 && bps[i].length != 4)
+            || bkpt_mgr_overlaps (m, bps[i].address, bps[i].length)) {
+            failed++;
+            continue;
+        }
+        e = calloc (1, sizeof (struct bkpt_entry));
+        if (e == NULL) {
+            failed++;
+            continue;
+        }
+        e->bp = bps[i];
+        e->bp.index = -1;
+        e->want = 1;
+        bkpt_batch_add (&batch, e, i);
+    }
+
+    /* Sort, breakpoints overlapping the previous one are dropped.  */
+    qsort (batch.items, batch.count, sizeof (struct bkpt_batch_item), bkpt_batch_compare);
+    for (i = 0, n = 0; i < batch.count; i++) {
+        struct breakpoint *prev = n ? &batch.items[n - 1].e->bp : NULL;
+
+        if (prev && batch.items[i].e->bp.address < prev->address + prev->length) {
+            free (batch.items[i].e);
+            failed++;
+            continue;
+        }
+        batch.items[n++] = batch.items[i];
+    }
+    batch.count = n;
+
+    bkpt_batch_apply (m, &batch, 1);
+    for (i = 0; i < batch.count; i++) {
+        struct bkpt_entry *e = batch.items[i].e;
+
+        if (!e->bp.set || bkpt_index_insert (m->bkpts, e->bp.address, e->bp.length, e) < 0) {
+            free (e);
+            failed++;
+            continue;
+        }
+        bps[batch.items[i].index] = e->bp;
+    }
+
+    free (batch.items);
+    return -failed;
+}
+
+int
+bkpt_mgr_breakpoint_remove_batch (struct bkpt_mgr *m, const U64 *addresses, int count)
+{
+    struct bkpt_batch batch;
+    int i, failed = 0;
+
+    if (m == NULL || (addresses == NULL && count != 0) || count < 0) {
+        return -1;
+    }
+    if (bkpt_batch_init (&batch, count) < 0) {
+        return -1;
+    }
+
+    /* Soft breakpoints on the target are patched together, the rest are
+       removed one by one.  */
+    for (i = 0; i < count; i++) {
+        struct bkpt_entry *e = bkpt_index_find (m->bkpts, addresses[i]);
+
+        if (e == NULL || !e->want) {
+            failed++;
+        } else if (e->bp.type != BKPT_SOFT || !e->bp.set || m->lazy) {
+            if (bkpt_mgr_breakpoint_remove (m, addresses[i]) < 0) {
+                failed++;
+            }
+        } else {
+            e->want = 0;
+            bkpt_batch_add (&batch, e, i);
+        }
+    }
+
+    qsort (batch.items, batch.count, sizeof (struct bkpt_batch_item), bkpt_batch_compare);
+    failed += bkpt_batch_apply (m, &batch, 0);
+    for (i = 0; i < batch.count; i++) {
+        struct bkpt_entry *e = batch.items[i].e;
+
+        if (e->bp.set) {
+            e->want = 1;
+        } else {
+            bkpt_index_remove (m->bkpts, e->bp.address);
+            free (e);
+        }
+    }
+
+    free (batch.items);
+    return -failed;
+}
+
+/*----- Lazy soft breakpoints -----*/
+
+struct bkpt_mgr_sync_ctx
+{
+    struct bkpt_batch insert;
+    struct bkpt_batch remove;
+};
+
+static int
+bkpt_mgr_collect (void *priv, U64 address, void *data)
+{
+    struct bkpt_mgr_sync_ctx *ctx = priv;
+    struct bkpt_entry *e = data;
+
+    if (e->bp.type != BKPT_SOFT || e->want == e->bp.set) {
+        return 0;
+    }
+    if (e->want) {
+        bkpt_batch_add (&ctx->insert, e, 0);
+    } else {
+        bkpt_batch_add (&ctx->remove, e, 0);
+    }
+    return 0;
+}
+
+int
+bkpt_mgr_sync (struct bkpt_mgr *m)
+{
+    struct bkpt_mgr_sync_ctx ctx;
+    unsigned int count;
+    int i, failed = 0;
+
+    if (m == NULL) {
+        return -1;
+    }
+    count = bkpt_index_count (m->bkpts);
+    if (bkpt_batch_init (&ctx.insert, count) < 0) {
+        return -1;
+    }
+    if (bkpt_batch_init (&ctx.remove, count) < 0) {
+        free (ctx.insert.items);
+        return -1;
+    }
+    bkpt_index_foreach (m->bkpts, bkpt_mgr_collect, &ctx);
+
+    /* Removed ones go first, a new breakpoint may overlap them.  */
+    qsort (ctx.remove.items, ctx.remove.count, sizeof (struct bkpt_batch_item), bkpt_batch_compare);
+    failed += bkpt_batch_apply (m, &ctx.remove, 0);
+    for (i = 0; i < ctx.remove.count; i++) {
+        struct bkpt_entry *e = ctx.remove.items[i].e;
+
+        if (!e->bp.set) {
+            bkpt_index_remove (m->bkpts, e->bp.address);
+            free (e);
+        }
+    }
+
+    qsort (ctx.insert.items, ctx.insert.count, sizeof (struct bkpt_batch_item), bkpt_batch_compare);
+    failed += bkpt_batch_apply (m, &ctx.insert, 1);
+
+    m->stats.synced += ctx.insert.count + ctx.remove.count;
+    free (ctx.insert.items);
+    free (ctx.remove.items);
+    return -failed;
+}
+
+int
+bkpt_mgr_set_lazy (struct bkpt_mgr *m, int en)
+{
+    int ret = 0;
+
+    if (m == NULL) {
+        return -1;
+    }
+    if (m->lazy && !en) {
+        ret = bkpt_mgr_sync (m);
+    }
+    m->lazy = en ? 1 : 0;
+    return ret;
+}
+
+int
+bkpt_mgr_enable_cache_flush (struct bkpt_mgr *m, int en)
+{
+    if (m == NULL) {
+        return -1;
+    }
+    m->cache_flush = en ? 1 : 0;
+    /* Still on for the pending run, it is set after the run.  */
+    if (m->flush_once && !m->cache_flush) {
+        return 0;
+    }
+    m->flush_once = 0;
+    return target_enable_cache_flush (m->tgt, m->cache_flush);
+}
+
+void
+bkpt_mgr_run_done (struct bkpt_mgr *m)
+{
+    if (m == NULL || !m->flush_once) {
+        return;
+    }
+    target_enable_cache_flush (m->tgt, m->cache_flush);
+    m->flush_once = 0;
+}
+
+int
+bkpt_mgr_flush_pending (struct bkpt_mgr *m)
+{
+    return m ? m->flush_once : 0;
+}
+
+int
+bkpt_mgr_watchpoint_add (struct bkpt_mgr *m, U64 address, unsigned int length,
+                         int value, enum watchpoint_type rw)
+{
+    struct watchpoint *wp;
+
+    if (m == NULL || length == 0 || bkpt_index_find (m->wpts, address) != NULL) {
+        return -1;
+    }
+    wp = calloc (1, sizeof (struct watchpoint));
+    if (wp == NULL) {
+        return -1;
+    }
+    wp->address = address;
+    wp->length = length;
+    wp->value = value;
+    wp->rw = rw;
+    wp->index = -1;
+    if (watchpoint_add (m->tgt, address, length, value, rw) < 0) {
+        free (wp);
+        return -1;
+    }
+    wp->set = 1;
+    if (bkpt_index_insert (m->wpts, address, length, wp) < 0) {
+        watchpoint_remove (m->tgt, address);
+        free (wp);
+        return -1;
+    }
+    return 0;
+}
+
+int
+bkpt_mgr_watchpoint_remove (struct bkpt_mgr *m, U64 address)
+{
+    struct watchpoint *wp;
+
+    if (m == NULL) {
+        return -1;
+    }
+    wp = bkpt_index_find (m->wpts, address);
+    if (wp == NULL) {
+        return -1;
+    }
+    if (watchpoint_remove (m->tgt, address) < 0) {
+        return -1;
+    }
+    bkpt_index_remove (m->wpts, address);
+    free (wp);
+    return 0;
+}
+
+static int
+bkpt_mgr_first_item (void *priv, U64 address, void *data)
+{
+    *(void **)priv = data;
+    return 1;
+}
+
+struct watchpoint *
+bkpt_mgr_watchpoint_find (struct bkpt_mgr *m, U64 address)
+{
+    struct watchpoint *wp = NULL;
+
+    if (m == NULL) {
+        return NULL;
+    }
+    m->stats.finds++;
+    bkpt_index_foreach_range (m->wpts, address, 1, bkpt_mgr_first_item, &wp);
+    return wp;
+}
+
+static int
+bkpt_mgr_clear_watchpoint (void *priv, U64 address, void *data)
+{
+    struct bkpt_mgr_clear_ctx *ctx = priv;
+
+    if (bkpt_mgr_watchpoint_remove (ctx->m, address) < 0) {
+        ctx->failed++;
+    }
+    return 0;
+}
+
+int
+bkpt_mgr_watchpoint_clear (struct bkpt_mgr *m)
+{
+    struct bkpt_mgr_clear_ctx ctx = {m, 0};
+
+    if (m == NULL) {
+        return -1;
+    }
+    bkpt_index_foreach (m->wpts, bkpt_mgr_clear_watchpoint, &ctx);
+    return ctx.failed ? -1 : 0;
+}
+
+struct bkpt_mgr_mask_ctx
+{
+    struct bkpt_mgr *m;
+    U64 address;
+    unsigned char *data;
+    unsigned int length;
+};
+
+static int
+bkpt_mgr_mask_item (void *priv, U64 address, void *data)
+{
+    struct bkpt_mgr_mask_ctx *ctx = priv;
+    struct breakpoint *bp = &((struct bkpt_entry *)data)->bp;
+    unsigned int i;
+
+    if (bp->type != BKPT_SOFT || !bp->set) {
+        return 0;
+    }
+    for (i = 0; i < bp->length; i++) {
+        if (bp->address + i >= ctx->address
+            && bp->address + i < ctx->address + ctx->length) {
+            ctx->data[bp->address + i - ctx->address] = (bp->orig_instr >> (i * 8)) & 0xff;
+        }
+    }
+    ctx->m->stats.masked++;
+    return 0;
+}
+
+void
+bkpt_mgr_check_mem_read (struct bkpt_mgr *m, U64 address,
+                         unsigned char *data, unsigned int length)
+{
+    struct bkpt_mgr_mask_ctx ctx = {m, address, data, length};
+
+    if (m == NULL || data == NULL) {
+        return;
+    }
+    bkpt_index_foreach_range (m->bkpts, address, length, bkpt_mgr_mask_item, &ctx);
+}
+
+void
+bkpt_mgr_get_stats (struct bkpt_mgr *m, struct bkpt_mgr_stats *stats)
+{
+    if (m == NULL || stats == NULL) {
+        return;
+    }
+    *stats = m->stats;
+    stats->breakpoints = bkpt_index_count (m->bkpts);
+    stats->watchpoints = bkpt_index_count (m->wpts);
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: bkpt_mgr.h
+// function description: breakpoint and watchpoint manager indexed by address.
+//                       Soft breakpoints are patched by the host, hard
+//                       breakpoints and watchpoints use the target interfaces.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_BKPT_MGR_H__
+#define __DEBUGGER_SERVER_EXAMPLE_BKPT_MGR_H__
+
+#include "dbg-target.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BKPT_BATCH_PAGE_SIZE    4096    ///< Soft breakpoints in one page are patched by one write
+
+/**
+\brief The statistics of breakpoint manager
+*/
+struct bkpt_mgr_stats
+{
+    unsigned int breakpoints;   ///< Breakpoints in the manager
+    unsigned int watchpoints;   ///< Watchpoints in the manager
+    unsigned int finds;         ///< Lookups by address
+    unsigned int masked;        ///< Breakpoints restored in read data
+    unsigned int batch_reads;   ///< Spans read by the batch interfaces
+    unsigned int batch_writes;  ///< Spans written by the batch interfaces
+    unsigned int synced;        ///< Lazy soft breakpoints inserted or removed by sync
+    unsigned int skipped;       ///< Lazy soft breakpoints removed and added again
+};
+
+/// definition for breakpoint manager, see bkpt_mgr.c
+struct bkpt_mgr;
+
+/**
+  \brief        Create an empty breakpoint manager for the target
+  \param[in]    tgt, the handle of target
+  \return       A handle for success, otherwise return NULL
+*/
+struct bkpt_mgr *bkpt_mgr_create (struct target *tgt);
+
+/**
+  \brief        Destroy the manager, breakpoints are left on the target
+  \param[in]    m, the handle of breakpoint manager
+  \return       None
+*/
+void bkpt_mgr_destroy (struct bkpt_mgr *m);
+
+/**
+  \brief        Add breakpoint, see breakpoint_add
+  \param[in]    m, the handle of breakpoint manager
+  \param[in]    address, the address of breakpoint
+  \param[in]    length, the breakpoint length, it could be 2 or 4
+  \param[in]    type, BKPT_SOFT or BKPT_HARD
+  \return       zero for success, negative for error
+*/
+int bkpt_mgr_breakpoint_add (struct bkpt_mgr *m, U64 address,
+                             unsigned int length, enum bkpt_type type);
+
+/**
+  \brief        Remove breakpoint, see breakpoint_remove
+  \param[in]    m, the handle of breakpoint manager
+  \param[in]    address, the address of breakpoint
+  \return       zero for success, negative for error
+*/
+int bkpt_mgr_breakpoint_remove (struct bkpt_mgr *m, U64 address);
+
+/**
+  \brief        Find breakpoint, see breakpoint_find
+  \param[in]    m, the handle of breakpoint manager
+  \param[in]    address, the address of breakpoint
+  \return       a breakpoint found, NULL for not found
+*/
+struct breakpoint *bkpt_mgr_breakpoint_find (struct bkpt_mgr *m, U64 address);
+
+/**
+  \brief        Remove all breakpoints, see breakpoint_clear
+  \param[in]    m, the handle of breakpoint manager
+  \return       zero for success, negative for error
+*/
+int bkpt_mgr_breakpoint_clear (struct bkpt_mgr *m);
+
+/**
+  \brief        Add breakpoints in one batch. Soft breakpoints are sorted, the
+                original instructions are read with coalesced reads and the
+                traps are written page by page.
+  \param[in]    m, the handle of breakpoint manager
+  \param[in,out] bps, the breakpoints, address, length and type must set
+                before calling, set and orig_instr are filled for success
+  \param[in]    count, the count of breakpoints
+  \return       zero for success, negative for the count of failed breakpoints
+*/
+int bkpt_mgr_breakpoint_add_batch (struct bkpt_mgr *m, struct breakpoint *bps, int count);
+
+/**
+  \brief        Remove breakpoints in one batch, see bkpt_mgr_breakpoint_add_batch
+  \param[in]    m, the handle of breakpoint manager
+  \param[in]    addresses, the addresses of breakpoints
+  \param[in]    count, the count of addresses
+  \return       zero for success, negative for the count of failed breakpoints
+*/
+int bkpt_mgr_breakpoint_remove_batch (struct bkpt_mgr *m, const U64 *addresses, int count);
+
+/**
+  \brief        Enable or disable lazy soft breakpoints. When enabled, adding
+                and removing soft breakpoints only change the wanted state,
+                bkpt_mgr_sync writes the difference to the target. The set of
+                struct breakpoint is the state on the target.
+  \param[in]    m, the handle of breakpoint manager
+  \param[in]    en, bool type, enable(1) or disable(0), it syncs before disabling
+  \return       zero for success, negative for error
+*/
+int bkpt_mgr_set_lazy (struct bkpt_mgr *m, int en);
+
+/**
+  \brief        Insert the wanted and remove the unwanted soft breakpoints in
+                one batch, the unchanged ones are not touched
+  \param[in]    m, the handle of breakpoint manager
+  \return       zero for success, negative for the count of failed breakpoints
+*/
+int bkpt_mgr_sync (struct bkpt_mgr *m);
+
+/**
+  \brief        Enable or disable cache flush while doing single-step or
+                resuming, see target_enable_cache_flush. The manager turns it
+                on for one run after patching soft breakpoints, so it must be
+                changed through this function while the manager is used.
+  \param[in]    m, the handle of breakpoint manager
+  \param[in]    en, bool type, enable(1) or disable(0), disabled by default
+  \return       zero for success, negative for error
+*/
+int bkpt_mgr_enable_cache_flush (struct bkpt_mgr *m, int en);
+
+/**
+  \brief        Tell the manager the target has been resumed or stepped, the
+                cache flush turned on for the patched code is turned back
+  \param[in]    m, the handle of breakpoint manager
+  \return       None
+*/
+void bkpt_mgr_run_done (struct bkpt_mgr *m);
+
+/**
+  \brief        Check whether the cache flush is turned on for the next run
+                only, the run must go through target_resume or
+                target_single_step to flush
+  \param[in]    m, the handle of breakpoint manager
+  \return       bool type, pending(1) or not(0)
+*/
+int bkpt_mgr_flush_pending (struct bkpt_mgr *m);
+
+/**
+  \brief        Add watchpoint, see watchpoint_add
+  \return       zero for success, negative for error
+*/
+int bkpt_mgr_watchpoint_add (struct bkpt_mgr *m, U64 address, unsigned int length,
+                             int value, enum watchpoint_type rw);
+
+/**
+  \brief        Remove watchpoint, see watchpoint_remove
+  \return       zero for success, negative for error
+*/
+int bkpt_mgr_watchpoint_remove (struct bkpt_mgr *m, U64 address);
+
+/**
+  \brief        Find the watchpoint which covers the address
+  \param[in]    m, the handle of breakpoint manager
+  \param[in]    address, the address accessed
+  \return       a watchpoint found, NULL for not found
+*/
+struct watchpoint *bkpt_mgr_watchpoint_find (struct bkpt_mgr *m, U64 address);
+
+/**
+  \brief        Remove all watchpoints, see watchpoint_clear
+  \return       zero for success, negative for error
+*/
+int bkpt_mgr_watchpoint_clear (struct bkpt_mgr *m);
+
+/**
+  \brief        Restore the original instructions of soft breakpoints in the
+                data read from the target, see ck_check_mem_read
+  \param[in]    m, the handle of breakpoint manager
+  \param[in]    address, the address of the data
+  \param[in,out] data, the data of the memory
+  \param[in]    length, the length of data
+  \return       None
+*/
+void bkpt_mgr_check_mem_read (struct bkpt_mgr *m, U64 address,
+                              unsigned char *data, unsigned int length);
+
+/**
+  \brief        Get the statistics of breakpoint manager
+  \param[in]    m, the handle of breakpoint manager
+  \param[out]   stats, save the statistics
+  \return       None
+*/
+void bkpt_mgr_get_stats (struct bkpt_mgr *m, struct bkpt_mgr_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_BKPT_MGR_H__
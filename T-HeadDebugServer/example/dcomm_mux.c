@@ -0,0 +1,470 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if defined _WIN32 && !defined (__CYGWIN)
+#include <winsock2.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#endif /* _WIN32 & !__CYGWIN */
+#include <stdlib.h>
+#include <string.h>
+#include "dcomm_mux.h"
+#include "host_os.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/* The state of frame parser.  */
+enum dcomm_mux_state
+{
+    MUX_STATE_TEXT = 0,
+    MUX_STATE_SYNC1,
+    MUX_STATE_CHANNEL,
+    MUX_STATE_LEN0,
+    MUX_STATE_LEN1,
+    MUX_STATE_PAYLOAD,
+    MUX_STATE_SUM,
+};
+
+struct dcomm_channel
+{
+    struct dcomm_sink sink;
+    /* The ring, written by the drain thread and read by one reader, which
+       is the writer thread for file and socket sinks.  */
+    char *ring;
+    volatile unsigned int head;
+    volatile unsigned int tail;
+};
+
+struct dcomm_mux
+{
+    struct dcomm_channel channel[DCOMM_MUX_CHANNELS];
+    unsigned int mask;
+    hostMutex mutex;            ///< Protects stats
+    struct dcomm_mux_stats stats;
+
+    /* Writes file and socket sinks, away from the lock of target.  */
+    hostThread thread;
+    semVar kick;
+    volatile int stop;
+
+    enum dcomm_mux_state state;
+    unsigned char hdr[DCOMM_MUX_HEADER_SIZE];   ///< The header bytes received
+    int cur;                    ///< The channel of the frame
+    unsigned int len;           ///< The payload length of the frame
+    unsigned int pos;           ///< The payload bytes received
+    unsigned char sum;
+    unsigned int frame_max;     ///< Longer frames are taken as text
+    char *frame;
+};
+
+static unsigned int
+dcomm_ring_push (struct dcomm_mux *mux, struct dcomm_channel *c, const char *data,
+                 unsigned int size)
+{
+    unsigned int head = c->head;
+    unsigned int space = mux->mask + 1 - (head - c->tail);
+    unsigned int off = head & mux->mask, first;
+
+    if (size > space) {
+        size = space;
+    }
+    first = size < mux->mask + 1 - off ? size : mux->mask + 1 - off;
+    memcpy (c->ring + off, data, first);
+    memcpy (c->ring, data + first, size - first);
+    HOST_MEMORY_BARRIER ();
+    c->head = head + size;
+    return size;
+}
+
+static int
+dcomm_sink_send (int sock, const char *data, unsigned int size)
+{
+    while (size > 0) {
+        int n = send (sock, data, size, MSG_NOSIGNAL);
+
+        if (n <= 0) {
+            return -1;
+        }
+        data += n;
+        size -= n;
+    }
+    return 0;
+}
+
+/* Write what the ring of a file or socket sink holds, in the writer thread.  */
+static void
+dcomm_mux_write_sink (struct dcomm_mux *mux, int channel)
+{
+    struct dcomm_channel *c = &mux->channel[channel];
+    unsigned int tail = c->tail, avail = c->head - tail, off, first, done;
+    U64 dropped = 0;
+
+    HOST_MEMORY_BARRIER ();
+    if (avail == 0) {
+        return;
+    }
+    while (avail > 0) {
+        off = tail & mux->mask;
+        first = avail < mux->mask + 1 - off ? avail : mux->mask + 1 - off;
+        if (c->sink.type == DCOMM_SINK_FILE) {
+            done = (unsigned int)fwrite (c->ring + off, 1, first, c->sink.fp);
+        } else {
+            done = dcomm_sink_send (c->sink.sock, c->ring + off, first) < 0 ? 0 : first;
+        }
+        if (done < first) {
+            /* The sink is broken, drop the rest.  */
+            dropped = avail - done;
+            tail += avail;
+            break;
+        }
+        tail += first;
+        avail -= first;
+    }
+    if (c->sink.type == DCOMM_SINK_FILE) {
+        fflush (c->sink.fp);
+    }
+    HOST_MEMORY_BARRIER ();
+    c->tail = tail;
+
+    if (dropped) {
+        LOCK (&mux->mutex);
+        mux->stats.channel[channel].dropped += dropped;
+        UNLOCK (&mux->mutex);
+    }
+}
+
+static void *
+dcomm_mux_writer (void *arg)
+{
+    struct dcomm_mux *mux = arg;
+    int i;
+
+    while (!mux->stop) {
+        host_sem_wait (&mux->kick, DCOMM_MUX_WRITE_MS);
+        for (i = 0; i < DCOMM_MUX_CHANNELS; i++) {
+            if (mux->channel[i].sink.type == DCOMM_SINK_FILE
+                || mux->channel[i].sink.type == DCOMM_SINK_SOCKET) {
+                dcomm_mux_write_sink (mux, i);
+            }
+        }
+    }
+    /* The output is over, write the rest.  */
+    for (i = 0; i < DCOMM_MUX_CHANNELS; i++) {
+        if (mux->channel[i].sink.type == DCOMM_SINK_FILE
+            || mux->channel[i].sink.type == DCOMM_SINK_SOCKET) {
+            dcomm_mux_write_sink (mux, i);
+        }
+    }
+    return NULL;
+}
+
+/* Pass the payload of a frame, or a run of text, to the sink. It may run
+   under the lock of target, so file and socket sinks only go to the ring
+   here and the writer thread does the blocking part.  */
+static void
+dcomm_mux_deliver (struct dcomm_mux *mux, int channel, const char *data, unsigned int size)
+{
+    struct dcomm_channel *c = &mux->channel[channel];
+    unsigned int done = size;
+    int idle;
+
+    switch (c->sink.type) {
+    case DCOMM_SINK_RING:
+        done = dcomm_ring_push (mux, c, data, size);
+        break;
+    case DCOMM_SINK_CALLBACK:
+        c->sink.output (c->sink.priv, data, size);
+        break;
+    case DCOMM_SINK_FILE:
+    case DCOMM_SINK_SOCKET:
+        idle = c->head == c->tail;
+        done = dcomm_ring_push (mux, c, data, size);
+        if (idle && done) {
+            WAKEUP (mux->kick);
+        }
+        break;
+    }
+
+    LOCK (&mux->mutex);
+    mux->stats.channel[channel].frames++;
+    mux->stats.channel[channel].bytes += size;
+    mux->stats.channel[channel].dropped += size - done;
+    UNLOCK (&mux->mutex);
+}
+
+/* The header is not a frame: its first byte is text, and the bytes after
+   it are parsed again, since a frame could start in them.  */
+static void
+dcomm_mux_resync (struct dcomm_mux *mux, unsigned int got)
+{
+    unsigned char hdr[DCOMM_MUX_HEADER_SIZE];
+
+    memcpy (hdr, mux->hdr, got);
+    LOCK (&mux->mutex);
+    mux->stats.bad_frames++;
+    UNLOCK (&mux->mutex);
+    dcomm_mux_deliver (mux, 0, (const char *)hdr, 1);
+    mux->state = MUX_STATE_TEXT;
+    dcomm_mux_on_output (mux, (const char *)hdr + 1, got - 1);
+}
+
+void
+dcomm_mux_on_output (void *priv, const char *buf, size_t len)
+{
+    struct dcomm_mux *mux = priv;
+    const unsigned char *p = (const unsigned char *)buf;
+    size_t i = 0, j;
+
+    if (mux == NULL || buf == NULL) {
+        return;
+    }
+    while (i < len) {
+        switch (mux->state) {
+        case MUX_STATE_TEXT:
+            for (j = i; j < len && p[j] != DCOMM_MUX_SYNC0; j++)
+                ;
+            if (j > i) {
+                dcomm_mux_deliver (mux, 0, buf + i, (unsigned int)(j - i));
+            }
+            if (j < len) {
+                mux->state = MUX_STATE_SYNC1;
+                j++;
+            }
+            i = j;
+            break;
+        case MUX_STATE_SYNC1:
+            if (p[i] == DCOMM_MUX_SYNC1) {
+                mux->hdr[0] = DCOMM_MUX_SYNC0;
+                mux->hdr[1] = DCOMM_MUX_SYNC1;
+                mux->state = MUX_STATE_CHANNEL;
+                i++;
+            } else {
+                /* Not a frame, the byte before is text.  */
+                dcomm_mux_deliver (mux, 0, "\xa5", 1);
+                mux->state = MUX_STATE_TEXT;
+            }
+            break;
+        case MUX_STATE_CHANNEL:
+            mux->hdr[2] = p[i++];
+            mux->cur = mux->hdr[2];
+            if (mux->cur <= 0 || mux->cur >= DCOMM_MUX_CHANNELS) {
+                dcomm_mux_resync (mux, 3);
+                break;
+            }
+            mux->state = MUX_STATE_LEN0;
+            break;
+        case MUX_STATE_LEN0:
+            mux->hdr[3] = p[i++];
+            mux->len = mux->hdr[3];
+            mux->state = MUX_STATE_LEN1;
+            break;
+        case MUX_STATE_LEN1:
+            mux->hdr[4] = p[i++];
+            mux->len |= mux->hdr[4] << 8;
+            if (mux->len > mux->frame_max) {
+                dcomm_mux_resync (mux, DCOMM_MUX_HEADER_SIZE);
+                break;
+            }
+            mux->pos = 0;
+            mux->sum = 0;
+            mux->state = mux->len ? MUX_STATE_PAYLOAD : MUX_STATE_SUM;
+            break;
+        case MUX_STATE_PAYLOAD:
+            for (; i < len && mux->pos < mux->len; i++) {
+                mux->frame[mux->pos++] = buf[i];
+                mux->sum ^= p[i];
+            }
+            if (mux->pos == mux->len) {
+                mux->state = MUX_STATE_SUM;
+            }
+            break;
+        case MUX_STATE_SUM:
+            if (p[i] == mux->sum) {
+                dcomm_mux_deliver (mux, mux->cur, mux->frame, mux->len);
+            } else {
+                LOCK (&mux->mutex);
+                mux->stats.bad_frames++;
+                UNLOCK (&mux->mutex);
+            }
+            mux->state = MUX_STATE_TEXT;
+            i++;
+            break;
+        }
+    }
+}
+
+static void
+dcomm_mux_free (struct dcomm_mux *mux)
+{
+    int i;
+
+    for (i = 0; i < DCOMM_MUX_CHANNELS; i++) {
+        free (mux->channel[i].ring);
+    }
+    free (mux->frame);
+    free (mux);
+}
+
+struct dcomm_mux *
+dcomm_mux_create (unsigned int ring_size, unsigned int frame_max)
+{
+    struct dcomm_mux *mux;
+    int i;
+
+    if (ring_size == 0) {
+        ring_size = DCOMM_MUX_RING_SIZE;
+    }
+    if (frame_max == 0) {
+        frame_max = DCOMM_MUX_FRAME_MAX;
+    }
+    if (ring_size & (ring_size - 1) || frame_max > DCOMM_MUX_FRAME_MAX) {
+        return NULL;
+    }
+    mux = calloc (1, sizeof (struct dcomm_mux));
+    if (mux == NULL) {
+        return NULL;
+    }
+    mux->mask = ring_size - 1;
+    mux->frame_max = frame_max;
+    mux->frame = malloc (frame_max);
+    if (mux->frame == NULL) {
+        dcomm_mux_free (mux);
+        return NULL;
+    }
+    for (i = 0; i < DCOMM_MUX_CHANNELS; i++) {
+        mux->channel[i].ring = malloc (ring_size);
+        if (mux->channel[i].ring == NULL) {
+            dcomm_mux_free (mux);
+            return NULL;
+        }
+    }
+    if (host_mutex_init (&mux->mutex) < 0) {
+        dcomm_mux_free (mux);
+        return NULL;
+    }
+    if (host_sem_init (&mux->kick, 0) < 0) {
+        host_mutex_destroy (&mux->mutex);
+        dcomm_mux_free (mux);
+        return NULL;
+    }
+    if (host_thread_create (&mux->thread, dcomm_mux_writer, mux) < 0) {
+        host_sem_destroy (&mux->kick);
+        host_mutex_destroy (&mux->mutex);
+        dcomm_mux_free (mux);
+        return NULL;
+    }
+    return mux;
+}
+
+void
+dcomm_mux_destroy (struct dcomm_mux *mux)
+{
+    int i;
+
+    if (mux == NULL) {
+        return;
+    }
+    mux->stop = 1;
+    WAKEUP (mux->kick);
+    host_thread_join (mux->thread);
+    for (i = 0; i < DCOMM_MUX_CHANNELS; i++) {
+        if (mux->channel[i].sink.type == DCOMM_SINK_FILE) {
+            fflush (mux->channel[i].sink.fp);
+        }
+    }
+    host_sem_destroy (&mux->kick);
+    host_mutex_destroy (&mux->mutex);
+    dcomm_mux_free (mux);
+}
+
+int
+dcomm_mux_set_sink (struct dcomm_mux *mux, int channel, const struct dcomm_sink *sink)
+{
+    if (mux == NULL || sink == NULL || channel < 0 || channel >= DCOMM_MUX_CHANNELS) {
+        return -1;
+    }
+    if ((sink->type == DCOMM_SINK_CALLBACK && sink->output == NULL)
+        || (sink->type == DCOMM_SINK_FILE && sink->fp == NULL)
+        || (sink->type == DCOMM_SINK_SOCKET && sink->sock < 0)
+        || sink->type > DCOMM_SINK_SOCKET) {
+        return -1;
+    }
+    mux->channel[channel].sink = *sink;
+    return 0;
+}
+
+int
+dcomm_mux_read (struct dcomm_mux *mux, int channel, char *buf, int max)
+{
+    struct dcomm_channel *c;
+    unsigned int tail, avail, off, first;
+
+    if (mux == NULL || buf == NULL || max < 0 || channel < 0 || channel >= DCOMM_MUX_CHANNELS
+        || mux->channel[channel].sink.type != DCOMM_SINK_RING) {
+        return -1;
+    }
+    c = &mux->channel[channel];
+    tail = c->tail;
+    avail = c->head - tail;
+    HOST_MEMORY_BARRIER ();
+    if (avail > (unsigned int)max) {
+        avail = max;
+    }
+    off = tail & mux->mask;
+    first = avail < mux->mask + 1 - off ? avail : mux->mask + 1 - off;
+    memcpy (buf, c->ring + off, first);
+    memcpy (buf + first, c->ring, avail - first);
+    HOST_MEMORY_BARRIER ();
+    c->tail = tail + avail;
+    return avail;
+}
+
+int
+dcomm_mux_encode (int channel, const char *payload, unsigned int len, char *frame)
+{
+    unsigned char sum = 0;
+    unsigned int i;
+
+    if (channel <= 0 || channel >= DCOMM_MUX_CHANNELS || len > DCOMM_MUX_FRAME_MAX
+        || (payload == NULL && len) || frame == NULL) {
+        return -1;
+    }
+    frame[0] = (char)DCOMM_MUX_SYNC0;
+    frame[1] = (char)DCOMM_MUX_SYNC1;
+    frame[2] = (char)channel;
+    frame[3] = (char)(len & 0xff);
+    frame[4] = (char)(len >> 8);
+    for (i = 0; i < len; i++) {
+        frame[DCOMM_MUX_HEADER_SIZE + i] = payload[i];
+        sum ^= (unsigned char)payload[i];
+    }
+    frame[DCOMM_MUX_HEADER_SIZE + len] = (char)sum;
+    return DCOMM_MUX_HEADER_SIZE + len + 1;
+}
+
+void
+dcomm_mux_get_stats (struct dcomm_mux *mux, struct dcomm_mux_stats *stats)
+{
+    if (mux == NULL || stats == NULL) {
+        return;
+    }
+    LOCK (&mux->mutex);
+    *stats = mux->stats;
+    UNLOCK (&mux->mutex);
+}
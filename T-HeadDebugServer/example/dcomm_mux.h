@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: dcomm_mux.h
+// function description: channels multiplexed over the DCC/LDCC output, frames
+//                       are routed to per-channel sinks or ring buffers.
+//
+// Frame: 0xa5 0x5a, channel, u16 length (little endian), payload, the xor of
+// the payload. Bytes out of frames belong to channel 0, so the plain text
+// of firmware keeps working.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_DCOMM_MUX_H__
+#define __DEBUGGER_SERVER_EXAMPLE_DCOMM_MUX_H__
+
+#include <stdio.h>
+#include "dbg-target.h"
+#include "dcomm_out.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DCOMM_MUX_CHANNELS      8           ///< Channels, 0 is the plain text
+#define DCOMM_MUX_RING_SIZE     0x10000     ///< Default bytes of each ring, must be power of 2
+#define DCOMM_MUX_SYNC0         0xa5
+#define DCOMM_MUX_SYNC1         0x5a
+#define DCOMM_MUX_HEADER_SIZE   5
+#define DCOMM_MUX_FRAME_MAX     0xffff      ///< Payload bytes of a frame at most
+#define DCOMM_MUX_WRITE_MS      10          ///< Max delay of file and socket sinks
+
+/*----- The type of channel sink -----*/
+enum dcomm_sink_type
+{
+	DCOMM_SINK_RING = 0,        ///<kept in the ring of channel, see dcomm_mux_read
+	DCOMM_SINK_CALLBACK,        ///<passed to a dcomm_output_t
+	DCOMM_SINK_FILE,            ///<written to a FILE by the writer thread, through the ring
+	DCOMM_SINK_SOCKET,          ///<sent to a connected socket by the writer thread, through the ring
+};
+
+/**
+\brief The sink of a channel
+*/
+struct dcomm_sink
+{
+    enum dcomm_sink_type type;  ///< The type of sink
+    dcomm_output_t output;      ///< For DCOMM_SINK_CALLBACK
+    void *priv;                 ///< For DCOMM_SINK_CALLBACK
+    FILE *fp;                   ///< For DCOMM_SINK_FILE, owned by the caller
+    int sock;                   ///< For DCOMM_SINK_SOCKET, owned by the caller
+};
+
+/**
+\brief The statistics of a channel
+*/
+struct dcomm_channel_stats
+{
+    unsigned int frames;        ///< Frames received, or runs of plain text for channel 0
+    U64 bytes;                  ///< Payload bytes
+    U64 dropped;                ///< Bytes dropped since the ring is full or the sink failed
+};
+
+/**
+\brief The statistics of multiplexer
+*/
+struct dcomm_mux_stats
+{
+    struct dcomm_channel_stats channel[DCOMM_MUX_CHANNELS];     ///< By channel
+    unsigned int bad_frames;    ///< Frames with a wrong channel, length or checksum
+};
+
+/// definition for multiplexer, see dcomm_mux.c
+struct dcomm_mux;
+
+/**
+  \brief        Create the multiplexer, all channels go to their rings. A header
+                with a wrong channel or a length over frame_max is taken as text
+                of channel 0
+  \param[in]    ring_size, bytes of each ring, power of 2. Zero for DCOMM_MUX_RING_SIZE
+  \param[in]    frame_max, payload bytes of a frame at most, up to DCOMM_MUX_FRAME_MAX.
+                Zero for DCOMM_MUX_FRAME_MAX
+  \return       A handle for success, otherwise return NULL
+*/
+struct dcomm_mux *dcomm_mux_create (unsigned int ring_size, unsigned int frame_max);
+
+/**
+  \brief        Destroy the multiplexer
+  \param[in]    mux, the handle of multiplexer
+  \return       None
+*/
+void dcomm_mux_destroy (struct dcomm_mux *mux);
+
+/**
+  \brief        Set the sink of a channel, it must be done before the output
+                is received
+  \param[in]    mux, the handle of multiplexer
+  \param[in]    channel, the channel
+  \param[in]    sink, the sink
+  \return       zero for success, negative for error
+*/
+int dcomm_mux_set_sink (struct dcomm_mux *mux, int channel, const struct dcomm_sink *sink);
+
+/**
+  \brief        Receive the output of target, it is a dcomm_output_t, pass
+                the multiplexer as priv of dcomm_out_cfg
+  \param[in]    priv, the handle of multiplexer
+  \param[in]    buf, the output of target
+  \param[in]    len, the length of output
+  \return       None
+*/
+void dcomm_mux_on_output (void *priv, const char *buf, size_t len);
+
+/**
+  \brief        Read a channel whose sink is DCOMM_SINK_RING, only one thread
+                could read a channel
+  \param[in]    mux, the handle of multiplexer
+  \param[in]    channel, the channel
+  \param[out]   buf, save the data
+  \param[in]    max, the size of buf
+  \return       The count of bytes read, negative for error
+*/
+int dcomm_mux_read (struct dcomm_mux *mux, int channel, char *buf, int max);
+
+/**
+  \brief        Encode a frame, the reference of the firmware side
+  \param[in]    channel, the channel, 1 to DCOMM_MUX_CHANNELS - 1
+  \param[in]    payload, the payload
+  \param[in]    len, the length of payload, up to DCOMM_MUX_FRAME_MAX
+  \param[out]   frame, save the frame, len + DCOMM_MUX_HEADER_SIZE + 1 bytes
+  \return       The length of frame, negative for error
+*/
+int dcomm_mux_encode (int channel, const char *payload, unsigned int len, char *frame);
+
+/**
+  \brief        Get the statistics of multiplexer
+  \param[in]    mux, the handle of multiplexer
+  \param[out]   stats, save the statistics
+  \return       None
+*/
+void dcomm_mux_get_stats (struct dcomm_mux *mux, struct dcomm_mux_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_DCOMM_MUX_H__
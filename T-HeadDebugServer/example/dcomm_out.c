@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "dcomm_out.h"
+
+struct dcomm_out
+{
+    struct target *tgt;
+    hostMutex *lock;            ///< The lock of target access
+    struct dcomm_out_cfg cfg;
+    hostMutex mutex;            ///< Protects buf, len, first_us and stats
+    hostMutex flush_lock;       ///< Serializes the delivery of out
+    semVar kick;                ///< Wakes the thread up to stop
+    hostThread thread;
+    volatile int stop;
+
+    char buf[DCOMM_OUT_BUF_SIZE];   ///< Filled by dcomm_out_putc
+    size_t len;
+    U64 first_us;               ///< When the oldest character in buf came
+    char out[DCOMM_OUT_BUF_SIZE];   ///< Being delivered
+    struct dcomm_out_stats stats;
+};
+
+/* The character hook has no context.  */
+static struct dcomm_out *dcomm_active;
+
+void
+dcomm_out_flush (struct dcomm_out *dout)
+{
+    size_t len;
+
+    if (dout == NULL) {
+        return;
+    }
+    LOCK (&dout->flush_lock);
+    LOCK (&dout->mutex);
+    len = dout->len;
+    memcpy (dout->out, dout->buf, len);
+    dout->len = 0;
+    if (len) {
+        dout->stats.outputs++;
+    }
+    UNLOCK (&dout->mutex);
+    if (len) {
+        dout->cfg.on_target_output (dout->cfg.priv, dout->out, len);
+    }
+    UNLOCK (&dout->flush_lock);
+}
+
+int
+dcomm_out_putc (char ch)
+{
+    struct dcomm_out *dout = dcomm_active;
+    int full;
+
+    if (dout == NULL) {
+        return -1;
+    }
+    LOCK (&dout->mutex);
+    if (dout->len == 0) {
+        dout->first_us = host_time_us ();
+    }
+    dout->buf[dout->len++] = ch;
+    dout->stats.bytes++;
+    full = dout->len == DCOMM_OUT_BUF_SIZE || (dout->cfg.line_buffered && ch == '\n');
+    UNLOCK (&dout->mutex);
+
+    if (full) {
+        dcomm_out_flush (dout);
+    }
+    return 0;
+}
+
+static void *
+dcomm_out_thread (void *arg)
+{
+    struct dcomm_out *dout = arg;
+    unsigned int interval = DCOMM_POLL_MIN_MS;
+
+    while (!dout->stop) {
+        U64 start, before;
+        int got, due, polls;
+
+        LOCK (&dout->mutex);
+        start = dout->stats.bytes;
+        UNLOCK (&dout->mutex);
+
+        /* Drain a bounded round per lock hold, so the debugger is not starved.  */
+        if (dout->lock) {
+            LOCK (dout->lock);
+        }
+        for (polls = 0, got = 0; polls < DCOMM_DRAIN_POLLS; polls++) {
+            LOCK (&dout->mutex);
+            before = dout->stats.bytes;
+            UNLOCK (&dout->mutex);
+
+            target_do_dcomm (dout->tgt);
+
+            LOCK (&dout->mutex);
+            dout->stats.polls++;
+            got = dout->stats.bytes != before;
+            if (got) {
+                dout->stats.busy_polls++;
+            }
+            before = dout->stats.bytes;
+            UNLOCK (&dout->mutex);
+            if (!got || before - start >= DCOMM_DRAIN_BYTES) {
+                break;
+            }
+        }
+        if (dout->lock) {
+            UNLOCK (dout->lock);
+        }
+
+        LOCK (&dout->mutex);
+        /* Deliver when the output stops, or keeps coming for too long.  */
+        due = dout->len
+              && (!got || host_time_us () - dout->first_us >= (U64)dout->cfg.flush_ms * 1000);
+        UNLOCK (&dout->mutex);
+        if (due) {
+            dcomm_out_flush (dout);
+        }
+
+        if (got) {
+            /* Drain again soon while the target is printing, but let the
+               lock go to the debugger first.  */
+            interval = DCOMM_POLL_MIN_MS;
+            host_sleep_ms (0);
+            continue;
+        }
+        host_sem_wait (&dout->kick, interval);
+        interval = interval * 2 > DCOMM_POLL_MAX_MS ? DCOMM_POLL_MAX_MS : interval * 2;
+    }
+    dcomm_out_flush (dout);
+    return NULL;
+}
+
+struct dcomm_out *
+dcomm_out_create (struct target *tgt, hostMutex *lock, const struct dcomm_out_cfg *cfg)
+{
+    struct dcomm_out *dout;
+
+    if (tgt == NULL || cfg == NULL || cfg->on_target_output == NULL || dcomm_active) {
+        return NULL;
+    }
+    dout = calloc (1, sizeof (struct dcomm_out));
+    if (dout == NULL) {
+        return NULL;
+    }
+    dout->tgt = tgt;
+    dout->lock = lock;
+    dout->cfg = *cfg;
+    if (dout->cfg.flush_ms == 0) {
+        dout->cfg.flush_ms = DCOMM_OUT_FLUSH_MS;
+    }
+    if (host_mutex_init (&dout->mutex) < 0) {
+        free (dout);
+        return NULL;
+    }
+    if (host_mutex_init (&dout->flush_lock) < 0) {
+        host_mutex_destroy (&dout->mutex);
+        free (dout);
+        return NULL;
+    }
+    if (host_sem_init (&dout->kick, 0) < 0) {
+        host_mutex_destroy (&dout->flush_lock);
+        host_mutex_destroy (&dout->mutex);
+        free (dout);
+        return NULL;
+    }
+    dcomm_active = dout;
+    if (host_thread_create (&dout->thread, dcomm_out_thread, dout) < 0) {
+        dcomm_active = NULL;
+        host_sem_destroy (&dout->kick);
+        host_mutex_destroy (&dout->flush_lock);
+        host_mutex_destroy (&dout->mutex);
+        free (dout);
+        return NULL;
+    }
+    return dout;
+}
+
+void
+dcomm_out_destroy (struct dcomm_out *dout)
+{
+    if (dout == NULL) {
+        return;
+    }
+    dout->stop = 1;
+    WAKEUP (dout->kick);
+    host_thread_join (dout->thread);
+    if (dout->cfg.prev_output) {
+        target_set_remote_dcomm_output (dout->tgt, dout->cfg.prev_output);
+    }
+    dcomm_active = NULL;
+
+    host_sem_destroy (&dout->kick);
+    host_mutex_destroy (&dout->flush_lock);
+    host_mutex_destroy (&dout->mutex);
+    free (dout);
+}
+
+void
+dcomm_out_get_stats (struct dcomm_out *dout, struct dcomm_out_stats *stats)
+{
+    if (dout == NULL || stats == NULL) {
+        return;
+    }
+    LOCK (&dout->mutex);
+    *stats = dout->stats;
+    UNLOCK (&dout->mutex);
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: dcomm_out.h
+// function description: buffered DCC/LDCC output, a thread drains the debug
+//                       communication and target output is delivered in
+//                       blocks instead of one callback per character.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_DCOMM_OUT_H__
+#define __DEBUGGER_SERVER_EXAMPLE_DCOMM_OUT_H__
+
+#include <stddef.h>
+#include "dbg-target.h"
+#include "host_os.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DCOMM_OUT_BUF_SIZE      0x10000     ///< Output kept before it is delivered
+#define DCOMM_OUT_FLUSH_MS      10          ///< Default max delay of output
+#define DCOMM_POLL_MIN_MS       1           ///< The interval once the output stops
+#define DCOMM_POLL_MAX_MS       50          ///< The interval is doubled up to it
+#define DCOMM_DRAIN_POLLS       16          ///< Max polls per hold of the target lock
+#define DCOMM_DRAIN_BYTES       0x1000      ///< Max output per hold of the target lock
+
+/**
+  \brief        The output callback, called from the drain thread
+  \param[in]    priv, the private data given in dcomm_out_cfg
+  \param[in]    buf, the output of target
+  \param[in]    len, the length of output
+  \return       None
+*/
+typedef void (*dcomm_output_t) (void *priv, const char *buf, size_t len);
+
+/**
+\brief The config of buffered output
+*/
+struct dcomm_out_cfg
+{
+    dcomm_output_t on_target_output;    ///< Where the output goes
+    void *priv;                 ///< The private data of on_target_output
+    unsigned int flush_ms;      ///< Max delay of output, zero for DCOMM_OUT_FLUSH_MS
+    int line_buffered;          ///< Deliver at each newline too, for text logs
+    int (*prev_output) (char ch);   ///< The hook before dcomm_out_putc, set back by
+                                    ///< dcomm_out_destroy. NULL if the caller does it
+};
+
+/**
+\brief The statistics of buffered output
+*/
+struct dcomm_out_stats
+{
+    unsigned int polls;         ///< Calls of target_do_dcomm
+    unsigned int busy_polls;    ///< Calls giving output
+    U64 bytes;                  ///< Bytes of output
+    unsigned int outputs;       ///< Calls of on_target_output
+};
+
+/// definition for buffered output, see dcomm_out.c
+struct dcomm_out;
+
+/**
+  \brief        Create the buffered output and its drain thread. Only one could
+                exist, since the character hook has no context
+  \param[in]    tgt, the handle of target
+  \param[in]    lock, held while calling target_do_dcomm, other threads
+                accessing the target take it too. NULL for no lock
+  \param[in]    cfg, the config of buffered output
+  \return       A handle for success, otherwise return NULL
+*/
+struct dcomm_out *dcomm_out_create (struct target *tgt, hostMutex *lock,
+                                    const struct dcomm_out_cfg *cfg);
+
+/**
+  \brief        Stop the thread, deliver the output left and destroy it.
+                prev_output of dcomm_out_cfg is set back as the hook, without it
+                the caller must set the hook back by target_set_remote_dcomm_output,
+                or the output of target is dropped
+  \param[in]    dout, the handle of buffered output
+  \return       None
+*/
+void dcomm_out_destroy (struct dcomm_out *dout);
+
+/**
+  \brief        The character hook, set it as on_target_stdout of dcomm_cfg
+                before target_open, or by target_set_remote_dcomm_output
+  \param[in]    ch, the character from target
+  \return       zero for success, negative if no buffered output exists
+*/
+int dcomm_out_putc (char ch);
+
+/**
+  \brief        Deliver the output kept now
+  \param[in]    dout, the handle of buffered output
+  \return       None
+*/
+void dcomm_out_flush (struct dcomm_out *dout);
+
+/**
+  \brief        Get the statistics of buffered output
+  \param[in]    dout, the handle of buffered output
+  \param[out]   stats, save the statistics
+  \return       None
+*/
+void dcomm_out_get_stats (struct dcomm_out *dout, struct dcomm_out_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_DCOMM_OUT_H__
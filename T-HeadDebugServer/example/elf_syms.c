@@ -0,0 +1,327 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "elf_syms.h"
+
+#define ELF_SHT_SYMTAB      2
+#define ELF_SHT_DYNSYM      11
+#define ELF_STT_FUNC        2
+#define ELF_SHN_UNDEF       0
+
+struct elf_syms
+{
+    struct elf_sym *list;
+    int count;
+    int capacity;
+    int sorted;
+};
+
+/* The ELF file loaded in memory.  */
+struct elf_image
+{
+    const unsigned char *data;
+    size_t size;
+    int is64;
+    int big_endian;
+};
+
+static U64
+elf_get (const struct elf_image *img, size_t off, int bytes)
+{
+    U64 v = 0;
+    int i;
+
+    if (off + bytes > img->size) {
+        return 0;
+    }
+    for (i = 0; i < bytes; i++) {
+        int shift = img->big_endian ? (bytes - 1 - i) * 8 : i * 8;
+        v |= (U64)img->data[off + i] << shift;
+    }
+    return v;
+}
+
+struct elf_syms *
+elf_syms_create (void)
+{
+    return calloc (1, sizeof (struct elf_syms));
+}
+
+void
+elf_syms_destroy (struct elf_syms *syms)
+{
+    int i;
+
+    if (syms == NULL) {
+        return;
+    }
+    for (i = 0; i < syms->count; i++) {
+        free (syms->list[i].name);
+    }
+    free (syms->list);
+    free (syms);
+}
+
+int
+elf_syms_add (struct elf_syms *syms, const char *name, U64 addr, U64 size)
+{
+    struct elf_sym *sym;
+
+    if (syms == NULL || name == NULL) {
+        return -1;
+    }
+    if (syms->count == syms->capacity) {
+        int capacity = syms->capacity ? syms->capacity * 2 : 256;
+        struct elf_sym *list = realloc (syms->list, sizeof (struct elf_sym) * capacity);
+
+        if (list == NULL) {
+            return -1;
+        }
+        syms->list = list;
+        syms->capacity = capacity;
+    }
+    sym = &syms->list[syms->count];
+    sym->name = malloc (strlen (name) + 1);
+    if (sym->name == NULL) {
+        return -1;
+    }
+    strcpy (sym->name, name);
+    sym->addr = addr;
+    sym->size = size;
+    syms->count++;
+    syms->sorted = 0;
+    return 0;
+}
+
+static int
+elf_sym_compare (const void *a, const void *b)
+{
+    const struct elf_sym *sa = a;
+    const struct elf_sym *sb = b;
+
+    if (sa->addr != sb->addr) {
+        return sa->addr < sb->addr ? -1 : 1;
+    }
+    /* The sized one goes first and is kept.  */
+    return sa->size > sb->size ? -1 : (sa->size < sb->size);
+}
+
+/* Sort by address, drop aliases at the same address and give the symbols
+   without size the range up to the next one.  */
+static void
+elf_syms_sort (struct elf_syms *syms)
+{
+    int i, n = 0;
+
+    qsort (syms->list, syms->count, sizeof (struct elf_sym), elf_sym_compare);
+    for (i = 0; i < syms->count; i++) {
+        if (n > 0 && syms->list[n - 1].addr == syms->list[i].addr) {
+            free (syms->list[i].name);
+            continue;
+        }
+        syms->list[n++] = syms->list[i];
+    }
+    syms->count = n;
+    for (i = 0; i + 1 < n; i++) {
+        if (syms->list[i].size == 0) {
+            syms->list[i].size = syms->list[i + 1].addr - syms->list[i].addr;
+        }
+    }
+    syms->sorted = 1;
+}
+
+static int
+elf_syms_parse (struct elf_syms *syms, const struct elf_image *img)
+{
+    U64 shoff;
+    unsigned int shentsize, shnum, i, type, found = 0;
+
+    if (img->is64) {
+        shoff = elf_get (img, 0x28, 8);
+        shentsize = (unsigned int)elf_get (img, 0x3a, 2);
+        shnum = (unsigned int)elf_get (img, 0x3c, 2);
+    } else {
+        shoff = elf_get (img, 0x20, 4);
+        shentsize = (unsigned int)elf_get (img, 0x2e, 2);
+        shnum = (unsigned int)elf_get (img, 0x30, 2);
+    }
+    if (shoff == 0 || shentsize == 0 || shoff + (U64)shentsize * shnum > img->size) {
+        return -1;
+    }
+
+    /* .symtab first, .dynsym if the file is stripped.  */
+    for (type = ELF_SHT_SYMTAB; !found; type = ELF_SHT_DYNSYM) {
+        for (i = 0; i < shnum; i++) {
+            size_t sh = (size_t)(shoff + (U64)i * shentsize);
+            U64 off, size, entsize, str_off;
+            size_t str_sh;
+            unsigned int link;
+            U64 j;
+
+            if (elf_get (img, sh + 4, 4) != type) {
+                continue;
+            }
+            link = (unsigned int)elf_get (img, sh + (img->is64 ? 0x28 : 0x18), 4);
+            off = elf_get (img, sh + (img->is64 ? 0x18 : 0x10), img->is64 ? 8 : 4);
+            size = elf_get (img, sh + (img->is64 ? 0x20 : 0x14), img->is64 ? 8 : 4);
+            entsize = elf_get (img, sh + (img->is64 ? 0x38 : 0x24), img->is64 ? 8 : 4);
+            if (link >= shnum || entsize == 0 || off + size > img->size) {
+                continue;
+            }
+            str_sh = (size_t)(shoff + (U64)link * shentsize);
+            str_off = elf_get (img, str_sh + (img->is64 ? 0x18 : 0x10), img->is64 ? 8 : 4);
+
+            for (j = 0; j + entsize <= size; j += entsize) {
+                size_t st = (size_t)(off + j);
+                U64 name, value, sz;
+                unsigned int info, shndx;
+
+                name = elf_get (img, st, 4);
+                if (img->is64) {
+                    info = (unsigned int)elf_get (img, st + 4, 1);
+                    shndx = (unsigned int)elf_get (img, st + 6, 2);
+                    value = elf_get (img, st + 8, 8);
+                    sz = elf_get (img, st + 16, 8);
+                } else {
+                    value = elf_get (img, st + 4, 4);
+                    sz = elf_get (img, st + 8, 4);
+                    info = (unsigned int)elf_get (img, st + 12, 1);
+                    shndx = (unsigned int)elf_get (img, st + 14, 2);
+                }
+                if ((info & 0xf) != ELF_STT_FUNC || shndx == ELF_SHN_UNDEF
+                    || str_off + name >= img->size
+                    || memchr (img->data + str_off + name, 0,
+                               (size_t)(img->size - str_off - name)) == NULL) {
+                    continue;
+                }
+                if (elf_syms_add (syms, (const char *)img->data + str_off + name, value, sz) < 0) {
+                    return -1;
+                }
+                found = 1;
+            }
+        }
+        if (type == ELF_SHT_DYNSYM) {
+            break;
+        }
+    }
+    return found ? 0 : -1;
+}
+
+struct elf_syms *
+elf_syms_load (const char *path)
+{
+    struct elf_syms *syms;
+    struct elf_image img;
+    unsigned char *data;
+    FILE *fp;
+    long size;
+    int ret;
+
+    if (path == NULL) {
+        return NULL;
+    }
+    fp = fopen (path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    if (fseek (fp, 0, SEEK_END) != 0 || (size = ftell (fp)) < 0x34
+        || fseek (fp, 0, SEEK_SET) != 0) {
+        fclose (fp);
+        return NULL;
+    }
+    data = malloc (size);
+    if (data == NULL || fread (data, 1, size, fp) != (size_t)size) {
+        free (data);
+        fclose (fp);
+        return NULL;
+    }
+    fclose (fp);
+
+    img.data = data;
+    img.size = size;
+    img.is64 = data[4] == 2;
+    img.big_endian = data[5] == 2;
+    if (memcmp (data, "\177ELF", 4) != 0 || (data[4] != 1 && data[4] != 2)
+        || (img.is64 && size < 0x40)) {
+        free (data);
+        return NULL;
+    }
+
+    syms = elf_syms_create ();
+    ret = syms ? elf_syms_parse (syms, &img) : -1;
+    free (data);
+    if (ret < 0) {
+        elf_syms_destroy (syms);
+        return NULL;
+    }
+    elf_syms_sort (syms);
+    return syms;
+}
+
+int
+elf_syms_find (struct elf_syms *syms, U64 addr)
+{
+    int lo = 0, hi;
+
+    if (syms == NULL || syms->count == 0) {
+        return -1;
+    }
+    if (!syms->sorted) {
+        elf_syms_sort (syms);
+    }
+    /* The last symbol starting at or below the address.  */
+    hi = syms->count - 1;
+    while (lo < hi) {
+        int mid = lo + (hi - lo + 1) / 2;
+
+        if (syms->list[mid].addr <= addr) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    if (syms->list[lo].addr <= addr && addr - syms->list[lo].addr < syms->list[lo].size) {
+        return lo;
+    }
+    return -1;
+}
+
+const struct elf_sym *
+elf_syms_get (struct elf_syms *syms, int index)
+{
+    if (syms == NULL) {
+        return NULL;
+    }
+    if (!syms->sorted) {
+        elf_syms_sort (syms);
+    }
+    return index >= 0 && index < syms->count ? &syms->list[index] : NULL;
+}
+
+int
+elf_syms_count (struct elf_syms *syms)
+{
+    if (syms == NULL) {
+        return 0;
+    }
+    if (!syms->sorted) {
+        elf_syms_sort (syms);
+    }
+    return syms->count;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: elf_syms.h
+// function description: function symbols of an ELF file, sorted by address
+//                       to resolve a PC to the function containing it.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_ELF_SYMS_H__
+#define __DEBUGGER_SERVER_EXAMPLE_ELF_SYMS_H__
+
+#include "dbg-target.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+\brief One function symbol
+*/
+struct elf_sym
+{
+    U64 addr;                   ///< The start address
+    U64 size;                   ///< The size, up to the next symbol if the ELF gives none
+    char *name;                 ///< The name
+};
+
+/// definition for symbol table, see elf_syms.c
+struct elf_syms;
+
+/**
+  \brief        Create an empty symbol table, symbols are added by elf_syms_add
+  \return       A handle for success, otherwise return NULL
+*/
+struct elf_syms *elf_syms_create (void);
+
+/**
+  \brief        Load the function symbols of an ELF file, 32 or 64 bits,
+                little or big endian. .symtab is used, or .dynsym if stripped
+  \param[in]    path, the path of ELF file
+  \return       A handle for success, otherwise return NULL
+*/
+struct elf_syms *elf_syms_load (const char *path);
+
+/**
+  \brief        Destroy the symbol table
+  \param[in]    syms, the handle of symbol table
+  \return       None
+*/
+void elf_syms_destroy (struct elf_syms *syms);
+
+/**
+  \brief        Add a function symbol, such as from a map file
+  \param[in]    syms, the handle of symbol table
+  \param[in]    name, the name, it is copied
+  \param[in]    addr, the start address
+  \param[in]    size, the size, zero for up to the next symbol
+  \return       zero for success, negative for error
+*/
+int elf_syms_add (struct elf_syms *syms, const char *name, U64 addr, U64 size);
+
+/**
+  \brief        Find the function containing the address
+  \param[in]    syms, the handle of symbol table
+  \param[in]    addr, the address, such as a sampled PC
+  \return       The index of the symbol, negative if no function contains it
+*/
+int elf_syms_find (struct elf_syms *syms, U64 addr);
+
+/**
+  \brief        Get the symbol by index, the index is in address order
+  \param[in]    syms, the handle of symbol table
+  \param[in]    index, from 0 to elf_syms_count - 1
+  \return       The symbol, NULL for a wrong index
+*/
+const struct elf_sym *elf_syms_get (struct elf_syms *syms, int index);
+
+/**
+  \brief        Get the count of symbols
+  \param[in]    syms, the handle of symbol table
+  \return       The count of symbols
+*/
+int elf_syms_count (struct elf_syms *syms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_ELF_SYMS_H__
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include "halt_poller.h"
+
+struct halt_poller
+{
+    struct target *tgt;
+    hostMutex *lock;            ///< The lock of target access
+    hostMutex mutex;            ///< Protects the fields below
+    semVar kick;                ///< Wakes the thread when armed, disarmed or stopped
+    semVar halt;                ///< Posted when halt is detected
+    hostThread thread;
+    int armed;
+    int halted;                 ///< Halt detected but not taken by a waiter
+    int stop;
+    struct halt_info info;
+    struct halt_poller_stats stats;
+};
+
+static int
+halt_poller_check (struct halt_poller *hp, struct halt_info *info)
+{
+    int ret;
+
+    if (hp->lock) {
+        LOCK (hp->lock);
+    }
+    ret = target_check_debug (hp->tgt, info);
+    if (hp->lock) {
+        UNLOCK (hp->lock);
+    }
+    return ret >= 0 && info->reason != DBG_REASON_RUNNING;
+}
+
+static void *
+halt_poller_thread (void *arg)
+{
+    struct halt_poller *hp = arg;
+    struct halt_info info;
+    int interval = HALT_POLL_MIN_MS;
+
+    LOCK (&hp->mutex);
+    while (!hp->stop) {
+        if (!hp->armed) {
+            /* Idle, nothing goes to the link.  */
+            UNLOCK (&hp->mutex);
+            host_sem_wait (&hp->kick, -1);
+            LOCK (&hp->mutex);
+            interval = HALT_POLL_MIN_MS;
+            continue;
+        }
+        UNLOCK (&hp->mutex);
+
+        if (halt_poller_check (hp, &info)) {
+            LOCK (&hp->mutex);
+            hp->stats.polls++;
+            /* Disarmed while checking, the result is stale.  */
+            if (hp->armed) {
+                hp->info = info;
+                hp->armed = 0;
+                hp->halted = 1;
+                hp->stats.halts++;
+                WAKEUP (hp->halt);
+            }
+            continue;
+        }
+
+        LOCK (&hp->mutex);
+        hp->stats.polls++;
+        UNLOCK (&hp->mutex);
+
+        /* Fast right after resuming, slower while the target keeps running.  */
+        host_sem_wait (&hp->kick, interval);
+        interval = interval * 2 > HALT_POLL_MAX_MS ? HALT_POLL_MAX_MS : interval * 2;
+        LOCK (&hp->mutex);
+    }
+    UNLOCK (&hp->mutex);
+    return NULL;
+}
+
+struct halt_poller *
+halt_poller_create (struct target *tgt, hostMutex *lock)
+{
+    struct halt_poller *hp;
+
+    if (tgt == NULL) {
+        return NULL;
+    }
+    hp = calloc (1, sizeof (struct halt_poller));
+    if (hp == NULL) {
+        return NULL;
+    }
+    hp->tgt = tgt;
+    hp->lock = lock;
+    if (host_mutex_init (&hp->mutex) < 0) {
+        free (hp);
+        return NULL;
+    }
+    if (host_sem_init (&hp->kick, 0) < 0) {
+        host_mutex_destroy (&hp->mutex);
+        free (hp);
+        return NULL;
+    }
+    if (host_sem_init (&hp->halt, 0) < 0) {
+        host_sem_destroy (&hp->kick);
+        host_mutex_destroy (&hp->mutex);
+        free (hp);
+        return NULL;
+    }
+    if (host_thread_create (&hp->thread, halt_poller_thread, hp) < 0) {
+        host_sem_destroy (&hp->halt);
+        host_sem_destroy (&hp->kick);
+        host_mutex_destroy (&hp->mutex);
+        free (hp);
+        return NULL;
+    }
+    return hp;
+}
+
+void
+halt_poller_destroy (struct halt_poller *hp)
+{
+    if (hp == NULL) {
+        return;
+    }
+    LOCK (&hp->mutex);
+    hp->stop = 1;
+    UNLOCK (&hp->mutex);
+    WAKEUP (hp->kick);
+    host_thread_join (hp->thread);
+
+    host_sem_destroy (&hp->halt);
+    host_sem_destroy (&hp->kick);
+    host_mutex_destroy (&hp->mutex);
+    free (hp);
+}
+
+void
+halt_poller_arm (struct halt_poller *hp)
+{
+    if (hp == NULL) {
+        return;
+    }
+    LOCK (&hp->mutex);
+    /* Drop a halt nobody waited for.  */
+    while (host_sem_wait (&hp->halt, 0) == 0)
+        ;
+    hp->halted = 0;
+    hp->armed = 1;
+    hp->stats.arms++;
+    UNLOCK (&hp->mutex);
+    WAKEUP (hp->kick);
+}
+
+void
+halt_poller_disarm (struct halt_poller *hp)
+{
+    if (hp == NULL) {
+        return;
+    }
+    LOCK (&hp->mutex);
+    hp->armed = 0;
+    UNLOCK (&hp->mutex);
+    WAKEUP (hp->kick);
+}
+
+int
+halt_poller_wait (struct halt_poller *hp, struct halt_info *info, int timeout_ms)
+{
+    if (hp == NULL) {
+        return -1;
+    }
+    LOCK (&hp->mutex);
+    if (!hp->armed && !hp->halted) {
+        UNLOCK (&hp->mutex);
+        return -1;
+    }
+    UNLOCK (&hp->mutex);
+
+    if (host_sem_wait (&hp->halt, timeout_ms) != 0) {
+        return 1;
+    }
+    LOCK (&hp->mutex);
+    hp->halted = 0;
+    if (info) {
+        *info = hp->info;
+    }
+    UNLOCK (&hp->mutex);
+    return 0;
+}
+
+void
+halt_poller_get_stats (struct halt_poller *hp, struct halt_poller_stats *stats)
+{
+    if (hp == NULL || stats == NULL) {
+        return;
+    }
+    LOCK (&hp->mutex);
+    *stats = hp->stats;
+    UNLOCK (&hp->mutex);
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: halt_poller.h
+// function description: background thread checking the target for halt with
+//                       adaptive backoff, waiters are woken by a semaphore.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_HALT_POLLER_H__
+#define __DEBUGGER_SERVER_EXAMPLE_HALT_POLLER_H__
+
+#include "dbg-target.h"
+#include "host_os.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HALT_POLL_MIN_MS    1       ///< The interval right after armed
+#define HALT_POLL_MAX_MS    100     ///< The interval is doubled up to it
+
+/**
+\brief The statistics of halt poller
+*/
+struct halt_poller_stats
+{
+    unsigned int arms;          ///< Times the poller is armed
+    unsigned int polls;         ///< Calls of target_check_debug
+    unsigned int halts;         ///< Halts detected
+};
+
+/// definition for halt poller, see halt_poller.c
+struct halt_poller;
+
+/**
+  \brief        Create the poller and its thread, it is idle until armed
+  \param[in]    tgt, the handle of target
+  \param[in]    lock, held while checking the target, other threads accessing
+                the target take it too. NULL for no lock
+  \return       A handle for success, otherwise return NULL
+*/
+struct halt_poller *halt_poller_create (struct target *tgt, hostMutex *lock);
+
+/**
+  \brief        Stop the thread and destroy the poller
+  \param[in]    hp, the handle of halt poller
+  \return       None
+*/
+void halt_poller_destroy (struct halt_poller *hp);
+
+/**
+  \brief        Start polling, call it after the target is resumed
+  \param[in]    hp, the handle of halt poller
+  \return       None
+*/
+void halt_poller_arm (struct halt_poller *hp);
+
+/**
+  \brief        Stop polling without waiting for halt, such as before reset
+  \param[in]    hp, the handle of halt poller
+  \return       None
+*/
+void halt_poller_disarm (struct halt_poller *hp);
+
+/**
+  \brief        Wait for the target to halt
+  \param[in]    hp, the handle of halt poller
+  \param[out]   info, the halt informations from target_check_debug, could be NULL
+  \param[in]    timeout_ms, negative for waiting forever
+  \return       zero for halted, positive for timeout, negative for not armed
+*/
+int halt_poller_wait (struct halt_poller *hp, struct halt_info *info, int timeout_ms);
+
+/**
+  \brief        Get the statistics of halt poller
+  \param[in]    hp, the handle of halt poller
+  \param[out]   stats, save the statistics
+  \return       None
+*/
+void halt_poller_get_stats (struct halt_poller *hp, struct halt_poller_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_HALT_POLLER_H__
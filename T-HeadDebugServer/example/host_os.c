@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include "host_os.h"
+
+#if defined _WIN32 && !defined (__CYGWIN)
+
+struct host_thread_start
+{
+    void *(*func) (void *);
+    void *arg;
+};
+
+static DWORD WINAPI
+host_thread_entry (LPVOID param)
+{
+    struct host_thread_start start = *(struct host_thread_start *)param;
+
+    free (param);
+    start.func (start.arg);
+    return 0;
+}
+
+int
+host_thread_create (hostThread *thread, void *(*func) (void *), void *arg)
+{
+    struct host_thread_start *start = malloc (sizeof (struct host_thread_start));
+
+    if (start == NULL) {
+        return -1;
+    }
+    start->func = func;
+    start->arg = arg;
+    *thread = CreateThread (NULL, 0, host_thread_entry, start, 0, NULL);
+    if (*thread == NULL) {
+        free (start);
+        return -1;
+    }
+    return 0;
+}
+
+void
+host_thread_join (hostThread thread)
+{
+    WaitForSingleObject (thread, INFINITE);
+    CloseHandle (thread);
+}
+
+int
+host_mutex_init (hostMutex *mutex)
+{
+    InitializeCriticalSection (mutex);
+    return 0;
+}
+
+void
+host_mutex_destroy (hostMutex *mutex)
+{
+    DeleteCriticalSection (mutex);
+}
+
+int
+host_sem_init (semVar *sema, unsigned int value)
+{
+    *sema = CreateSemaphore (NULL, value, 0x7fffffff, NULL);
+    return *sema ? 0 : -1;
+}
+
+void
+host_sem_destroy (semVar *sema)
+{
+    CloseHandle (*sema);
+}
+
+int
+host_sem_wait (semVar *sema, int timeout_ms)
+{
+    DWORD ret = WaitForSingleObject (*sema, timeout_ms < 0 ? INFINITE : (DWORD)timeout_ms);
+    return ret == WAIT_OBJECT_0 ? 0 : 1;
+}
+
+U64
+host_time_us (void)
+{
+    LARGE_INTEGER freq, count;
+
+    QueryPerformanceFrequency (&freq);
+    QueryPerformanceCounter (&count);
+    return (U64)(count.QuadPart / freq.QuadPart) * 1000000
+           + (U64)(count.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+}
+
+void
+host_sleep_ms (unsigned int ms)
+{
+    Sleep (ms);
+}
+
+void *
+host_lib_open (const char *path)
+{
+    return path ? (void *)LoadLibraryA (path) : NULL;
+}
+
+void *
+host_lib_symbol (void *lib, const char *name)
+{
+    return lib ? (void *)GetProcAddress ((HMODULE)lib, name) : NULL;
+}
+
+void
+host_lib_close (void *lib)
+{
+    if (lib) {
+        FreeLibrary ((HMODULE)lib);
+    }
+}
+
+#else /* not _WIN32 */
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+int
+host_thread_create (hostThread *thread, void *(*func) (void *), void *arg)
+{
+    return pthread_create (thread, NULL, func, arg) ? -1 : 0;
+}
+
+void
+host_thread_join (hostThread thread)
+{
+    pthread_join (thread, NULL);
+}
+
+int
+host_mutex_init (hostMutex *mutex)
+{
+    return pthread_mutex_init (mutex, NULL) ? -1 : 0;
+}
+
+void
+host_mutex_destroy (hostMutex *mutex)
+{
+    pthread_mutex_destroy (mutex);
+}
+
+int
+host_sem_init (semVar *sema, unsigned int value)
+{
+    return sem_init (sema, 0, value) ? -1 : 0;
+}
+
+void
+host_sem_destroy (semVar *sema)
+{
+    sem_destroy (sema);
+}
+
+int
+host_sem_wait (semVar *sema, int timeout_ms)
+{
+    struct timespec ts;
+
+    if (timeout_ms < 0) {
+        while (sem_wait (sema) != 0 && errno == EINTR)
+            ;
+        return 0;
+    }
+    clock_gettime (CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    while (sem_timedwait (sema, &ts) != 0) {
+        if (errno != EINTR) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+U64
+host_time_us (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (U64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void
+host_sleep_ms (unsigned int ms)
+{
+    usleep (ms * 1000);
+}
+
+void *
+host_lib_open (const char *path)
+{
+    return path ? dlopen (path, RTLD_NOW | RTLD_LOCAL) : NULL;
+}
+
+void *
+host_lib_symbol (void *lib, const char *name)
+{
+    return lib ? dlsym (lib, name) : NULL;
+}
+
+void
+host_lib_close (void *lib)
+{
+    if (lib) {
+        dlclose (lib);
+    }
+}
+
+#endif /* not _WIN32 */
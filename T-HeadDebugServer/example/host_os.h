@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: host_os.h
+// function description: threads, semaphores, barriers, clocks and shared
+//                       libraries for the examples, linux/windows are different.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_HOST_OS_H__
+#define __DEBUGGER_SERVER_EXAMPLE_HOST_OS_H__
+
+#include "dbg-target.h"
+
+#if defined _WIN32 && !defined (__CYGWIN)
+#define hostThread HANDLE
+#define hostMutex CRITICAL_SECTION
+#define HOST_MEMORY_BARRIER()   MemoryBarrier ()
+#else
+#include <pthread.h>
+#define hostThread pthread_t
+#define hostMutex pthread_mutex_t
+#define HOST_MEMORY_BARRIER()   __sync_synchronize ()
+#endif /* _WIN32 & !__CYGWIN */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+  \brief        Create a thread
+  \param[out]   thread, save the thread handle
+  \param[in]    func, the thread entry
+  \param[in]    arg, the argument of func
+  \return       zero for success, negative for error
+*/
+int host_thread_create (hostThread *thread, void *(*func) (void *), void *arg);
+
+/**
+  \brief        Wait for the thread to exit
+  \param[in]    thread, the thread handle
+  \return       None
+*/
+void host_thread_join (hostThread thread);
+
+/**
+  \brief        Initialize a mutex, lock it with LOCK and UNLOCK
+  \param[out]   mutex, the mutex
+  \return       zero for success, negative for error
+*/
+int host_mutex_init (hostMutex *mutex);
+
+/**
+  \brief        Destroy a mutex
+  \param[in]    mutex, the mutex
+  \return       None
+*/
+void host_mutex_destroy (hostMutex *mutex);
+
+/**
+  \brief        Initialize a semaphore
+  \param[out]   sema, the semaphore
+  \param[in]    value, the initial count
+  \return       zero for success, negative for error
+*/
+int host_sem_init (semVar *sema, unsigned int value);
+
+/**
+  \brief        Destroy a semaphore
+  \param[in]    sema, the semaphore
+  \return       None
+*/
+void host_sem_destroy (semVar *sema);
+
+/**
+  \brief        Wait for a semaphore with timeout
+  \param[in]    sema, the semaphore
+  \param[in]    timeout_ms, negative for waiting forever
+  \return       zero if the semaphore is taken, positive for timeout
+*/
+int host_sem_wait (semVar *sema, int timeout_ms);
+
+/**
+  \brief        Get monotonic time
+  \return       microseconds from an unspecified start point
+*/
+U64 host_time_us (void);
+
+/**
+  \brief        Sleep
+  \param[in]    ms, milliseconds
+  \return       None
+*/
+void host_sleep_ms (unsigned int ms);
+
+/**
+  \brief        Load a shared library, a .dll or a .so
+  \param[in]    path, the path of the library
+  \return       A handle for success, otherwise return NULL
+*/
+void *host_lib_open (const char *path);
+
+/**
+  \brief        Get the address of a symbol exported by the library
+  \param[in]    lib, the handle of library
+  \param[in]    name, the name of the symbol
+  \return       The address, NULL if it is not found
+*/
+void *host_lib_symbol (void *lib, const char *name);
+
+/**
+  \brief        Unload the library
+  \param[in]    lib, the handle of library
+  \return       None
+*/
+void host_lib_close (void *lib);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_HOST_OS_H__
@@ -0,0 +1,320 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "jtag_queue.h"
+
+struct jtag_queue
+{
+    jtag_operator_t op;
+    jtag_batch_t batch;
+    void *handle;
+
+    /* One more for the NOP finishing the last DMI op.  */
+    struct jtag_scan scans[JTAG_QUEUE_MAX_SCANS + 1];
+    unsigned char *out[JTAG_QUEUE_MAX_SCANS + 1];   ///< Where dr_r goes
+    U32 *dmi_value[JTAG_QUEUE_MAX_SCANS + 1];       ///< The read finished by the scan
+    char dmi[JTAG_QUEUE_MAX_SCANS + 1];             ///< It is a DMI scan
+    int count;
+
+    int dmi_open;               ///< The status of the last DMI op is not seen yet
+    int dmi_abits;
+    U32 *dmi_pending;           ///< The last DMI op is a read
+    int idle;                   ///< Run-Test/Idle cycles after DMI scans
+
+    struct jtag_queue_stats stats;
+};
+
+struct jtag_queue *
+jtag_queue_create (jtag_operator_t op, jtag_batch_t batch, void *handle)
+{
+    struct jtag_queue *q;
+
+    if (op == NULL && batch == NULL) {
+        return NULL;
+    }
+    q = calloc (1, sizeof (struct jtag_queue));
+    if (q == NULL) {
+        return NULL;
+    }
+    q->op = op;
+    q->batch = batch;
+    q->handle = handle;
+    return q;
+}
+
+void
+jtag_queue_destroy (struct jtag_queue *q)
+{
+    free (q);
+}
+
+static struct jtag_scan *
+jtag_queue_add (struct jtag_queue *q, int ir_len, const unsigned char *ir,
+                int dr_len, const unsigned char *dr_w, unsigned char *dr_r)
+{
+    struct jtag_scan *scan = &q->scans[q->count];
+
+    scan->ir_len = ir_len;
+    memcpy (scan->ir, ir, ir_len);
+    scan->dr_len = dr_len;
+    memcpy (scan->dr_w, dr_w, dr_len);
+    scan->read = dr_r != NULL;
+    scan->idle = 0;
+    q->out[q->count] = dr_r;
+    q->dmi_value[q->count] = NULL;
+    q->dmi[q->count] = 0;
+    q->count++;
+    q->stats.scans++;
+    return scan;
+}
+
+int
+jtag_queue_scan (struct jtag_queue *q, int ir_len, const unsigned char *ir,
+                 int dr_len, const unsigned char *dr_w, unsigned char *dr_r)
+{
+    if (q == NULL || ir == NULL || dr_w == NULL || ir_len <= 0 || ir_len > JTAG_SCAN_MAX_IR
+        || dr_len <= 0 || dr_len > JTAG_SCAN_MAX_DR) {
+        return -1;
+    }
+    if (q->count == JTAG_QUEUE_MAX_SCANS && jtag_queue_flush (q) < 0) {
+        return -1;
+    }
+    jtag_queue_add (q, ir_len, ir, dr_len, dr_w, dr_r);
+    return 0;
+}
+
+/* DR of DMI: op[1:0], data[33:2], address[abits+33:34].  */
+static void
+jtag_queue_dmi (struct jtag_queue *q, int abits, U32 addr, U32 data, int op)
+{
+    struct jtag_scan *scan;
+    unsigned char ir = JTAG_DTM_IR_DMI, dr[JTAG_SCAN_MAX_DR];
+    U64 value = (U64)addr << 34 | (U64)data << 2 | op;
+    int i, len = (abits + 34 + 7) / 8;
+
+    for (i = 0; i < len; i++) {
+        dr[i] = (unsigned char)(value >> (i * 8));
+    }
+    scan = jtag_queue_add (q, 1, &ir, len, dr, NULL);
+    scan->read = 1;
+    scan->idle = q->idle;
+    q->dmi[q->count - 1] = 1;
+    q->dmi_value[q->count - 1] = q->dmi_pending;
+    q->dmi_pending = NULL;
+    q->dmi_open = op != JTAG_DMI_OP_NOP;
+    q->dmi_abits = abits;
+}
+
+static int
+jtag_queue_dmi_check (struct jtag_queue *q, int abits)
+{
+    if (q == NULL || abits <= 0 || abits > 30) {
+        return -1;
+    }
+    if (q->count == JTAG_QUEUE_MAX_SCANS && jtag_queue_flush (q) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+int
+jtag_queue_dmi_write (struct jtag_queue *q, int abits, U32 addr, U32 data)
+{
+    if (jtag_queue_dmi_check (q, abits) < 0) {
+        return -1;
+    }
+    jtag_queue_dmi (q, abits, addr, data, JTAG_DMI_OP_WRITE);
+    return 0;
+}
+
+int
+jtag_queue_dmi_read (struct jtag_queue *q, int abits, U32 addr, U32 *value)
+{
+    if (value == NULL || jtag_queue_dmi_check (q, abits) < 0) {
+        return -1;
+    }
+    jtag_queue_dmi (q, abits, addr, 0, JTAG_DMI_OP_READ);
+    q->dmi_pending = value;
+    return 0;
+}
+
+/* Scans one by one are a transfer each, far longer than any idle cycles
+   needed, so only the batch gets idle.  */
+static int
+jtag_queue_execute (struct jtag_queue *q, int first)
+{
+    struct jtag_scan *scan;
+    int i;
+
+    if (q->batch) {
+        q->stats.transfers++;
+        return q->batch (q->handle, q->scans + first, q->count - first);
+    }
+    for (i = first; i < q->count; i++) {
+        scan = &q->scans[i];
+        q->stats.transfers++;
+        if (q->op (q->handle, scan->ir_len, scan->ir, scan->dr_len, scan->dr_r,
+                   scan->dr_w, scan->read) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* One DTMCS scan at once, outside of the queued scans.  */
+static int
+jtag_queue_dtmcs (struct jtag_queue *q, U32 in, U32 *out)
+{
+    struct jtag_scan scan;
+
+    memset (&scan, 0, sizeof (scan));
+    scan.ir_len = 1;
+    scan.ir[0] = JTAG_DTM_IR_DTMCS;
+    scan.dr_len = 4;
+    scan.dr_w[0] = (unsigned char)in;
+    scan.dr_w[1] = (unsigned char)(in >> 8);
+    scan.dr_w[2] = (unsigned char)(in >> 16);
+    scan.dr_w[3] = (unsigned char)(in >> 24);
+    scan.read = 1;
+    q->stats.transfers++;
+    if (q->batch ? q->batch (q->handle, &scan, 1) < 0
+                 : q->op (q->handle, scan.ir_len, scan.ir, scan.dr_len, scan.dr_r,
+                          scan.dr_w, 1) < 0) {
+        return -1;
+    }
+    if (out) {
+        *out = scan.dr_r[0] | scan.dr_r[1] << 8 | scan.dr_r[2] << 16 | (U32)scan.dr_r[3] << 24;
+    }
+    return 0;
+}
+
+int
+jtag_queue_read_dtmcs (struct jtag_queue *q, U32 *dtmcs)
+{
+    U32 value;
+
+    if (q == NULL || jtag_queue_flush (q) < 0 || jtag_queue_dtmcs (q, 0, &value) < 0) {
+        return -1;
+    }
+    q->idle = JTAG_DTMCS_IDLE (value);
+    q->stats.idle = q->idle;
+    if (dtmcs) {
+        *dtmcs = value;
+    }
+    return 0;
+}
+
+/* Check the results of scans from FIRST, the output of scan SKIP is of an
+   op done before and is not checked again. Returns the scan to replay from
+   after a busy op, count for done, negative for a failed op.  */
+static int
+jtag_queue_results (struct jtag_queue *q, int first, int skip)
+{
+    struct jtag_scan *scan;
+    U64 value;
+    int i, j, prev = -1;
+
+    for (i = first; i < q->count; i++) {
+        scan = &q->scans[i];
+        if (q->out[i]) {
+            memcpy (q->out[i], scan->dr_r, scan->dr_len);
+        }
+        if (!q->dmi[i] || i == skip) {
+            prev = q->dmi[i] ? i : prev;
+            continue;
+        }
+        for (j = scan->dr_len - 1, value = 0; j >= 0; j--) {
+            value = value << 8 | scan->dr_r[j];
+        }
+        if ((value & 0x3) == JTAG_DMI_STATUS_BUSY) {
+            /* The op of this scan is ignored, so are the ops after it. The
+               op before it is done, but the value read by it is lost.  */
+            q->stats.dmi_errors++;
+            if (prev >= 0 && (q->scans[prev].dr_w[0] & 0x3) == JTAG_DMI_OP_READ) {
+                return prev;
+            }
+            return i;
+        }
+        /* DMI results after a failed op are not trusted.  */
+        if ((value & 0x3) == JTAG_DMI_STATUS_FAILED) {
+            q->stats.dmi_errors++;
+            return -1;
+        }
+        if (q->dmi_value[i]) {
+            *q->dmi_value[i] = (U32)(value >> 2);
+        }
+        prev = i;
+    }
+    return q->count;
+}
+
+int
+jtag_queue_flush (struct jtag_queue *q)
+{
+    int i, first = 0, skip = -1, retry = 0, ret = 0;
+
+    if (q == NULL) {
+        return -1;
+    }
+    /* The result of a DMI op comes out of the next DMI scan.  */
+    if (q->dmi_open) {
+        jtag_queue_dmi (q, q->dmi_abits, 0, 0, JTAG_DMI_OP_NOP);
+    }
+    if (q->count == 0) {
+        return 0;
+    }
+    q->stats.flushes++;
+
+    while (1) {
+        if (jtag_queue_execute (q, first) < 0) {
+            ret = -1;
+            break;
+        }
+        i = jtag_queue_results (q, first, skip);
+        if (i < 0 || i == q->count) {
+            ret = i < 0 ? -1 : 0;
+            break;
+        }
+        /* Busy: clear it, wait longer after each DMI scan and replay.  */
+        if (retry++ == JTAG_QUEUE_MAX_RETRIES
+            || jtag_queue_dtmcs (q, JTAG_DTMCS_DMIRESET, NULL) < 0) {
+            ret = -1;
+            break;
+        }
+        q->idle = q->idle * 2 + 1 > JTAG_QUEUE_MAX_IDLE ? JTAG_QUEUE_MAX_IDLE : q->idle * 2 + 1;
+        q->stats.idle = q->idle;
+        q->stats.busy_retries++;
+        for (first = i; i < q->count; i++) {
+            if (q->dmi[i]) {
+                q->scans[i].idle = q->idle;
+            }
+        }
+        /* The output of the first scan is the status of an op checked before.  */
+        skip = q->dmi[first] ? first : -1;
+    }
+    q->count = 0;
+    return ret;
+}
+
+void
+jtag_queue_get_stats (struct jtag_queue *q, struct jtag_queue_stats *stats)
+{
+    if (q && stats) {
+        *stats = q->stats;
+    }
+}
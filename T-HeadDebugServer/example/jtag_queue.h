@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: jtag_queue.h
+// function description: queued IR/DR scans on top of link_jtag_operator,
+//                       executed in one transfer by jtag_queue_flush with
+//                       the results filled in afterwards.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_JTAG_QUEUE_H__
+#define __DEBUGGER_SERVER_EXAMPLE_JTAG_QUEUE_H__
+
+#include "dbg-target.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JTAG_QUEUE_MAX_SCANS    256     ///< Scans of one flush, the queue is flushed when full
+#define JTAG_QUEUE_MAX_RETRIES  8       ///< Replays of one flush after busy DMI ops
+#define JTAG_QUEUE_MAX_IDLE     1024    ///< Run-Test/Idle cycles after a DMI scan at most
+#define JTAG_SCAN_MAX_IR        4       ///< The max length of IR in bytes
+#define JTAG_SCAN_MAX_DR        16      ///< The max length of DR in bytes
+
+/* RISC-V DTM.  */
+#define JTAG_DTM_IR_IDCODE      0x01
+#define JTAG_DTM_IR_DTMCS       0x10
+#define JTAG_DTM_IR_DMI         0x11
+
+/* The fields of dtmcs.  */
+#define JTAG_DTMCS_ABITS(v)     (((v) >> 4) & 0x3f)
+#define JTAG_DTMCS_IDLE(v)      (((v) >> 12) & 0x7)
+#define JTAG_DTMCS_DMIRESET     (1 << 16)
+
+/* The op of DMI scans, it is the status of the previous op in the output.  */
+#define JTAG_DMI_OP_NOP         0
+#define JTAG_DMI_OP_READ        1
+#define JTAG_DMI_OP_WRITE       2
+#define JTAG_DMI_STATUS_FAILED  2
+#define JTAG_DMI_STATUS_BUSY    3
+
+/**
+\brief One IR/DR scan, values are in bytes, LSB first
+*/
+struct jtag_scan
+{
+    int ir_len;                             ///< The length of IR in bytes
+    unsigned char ir[JTAG_SCAN_MAX_IR];     ///< The value of IR
+    int dr_len;                             ///< The length of DR in bytes
+    unsigned char dr_w[JTAG_SCAN_MAX_DR];   ///< The DR shifted in
+    unsigned char dr_r[JTAG_SCAN_MAX_DR];   ///< The DR shifted out
+    int read;                               ///< dr_r is needed
+    int idle;                               ///< Run-Test/Idle cycles after the DR scan
+};
+
+/**
+  \brief        Do one JTAG transfer, it is the type of link_jtag_operator
+  \param[in]    handle, the handle of link
+  \param[in]    ir_len, the length of IR in bytes
+  \param[in]    ir, the value of IR
+  \param[in]    dr_len, the length of DR in bytes
+  \param[out]   dr_r, the DR output
+  \param[in]    dr_w, the DR input
+  \param[in]    read, save the DR output to dr_r or not
+  \return       zero for success, negative for error
+*/
+typedef int (*jtag_operator_t) (void *handle, int ir_len, unsigned char *ir,
+                                int dr_len, unsigned char *dr_r, unsigned char *dr_w, int read);
+
+/**
+  \brief        Do many scans in one transfer, for links which support it. The
+                TAP stays idle cycles in Run-Test/Idle after each scan
+  \param[in]    handle, the handle of link
+  \param[in]    scans, the scans, dr_r is filled if read is set
+  \param[in]    count, the count of scans
+  \return       zero for success, negative for error
+*/
+typedef int (*jtag_batch_t) (void *handle, struct jtag_scan *scans, int count);
+
+/**
+\brief The statistics of JTAG queue
+*/
+struct jtag_queue_stats
+{
+    unsigned int scans;         ///< Scans queued, including the NOP to finish a DMI read
+    unsigned int flushes;       ///< Flushes with scans
+    unsigned int transfers;     ///< Calls of the link
+    unsigned int dmi_errors;    ///< DMI ops which are failed or busy
+    unsigned int busy_retries;  ///< Replays after busy DMI ops
+    int idle;                   ///< Run-Test/Idle cycles after DMI scans now
+};
+
+/// definition for JTAG queue, see jtag_queue.c
+struct jtag_queue;
+
+/**
+  \brief        Create a JTAG queue
+  \param[in]    op, the JTAG operator of link, such as link_jtag_operator
+  \param[in]    batch, the batch operator of link, NULL if the link has not it,
+                then the scans are done one by one at flush
+  \param[in]    handle, the handle of link
+  \return       A handle for success, otherwise return NULL
+*/
+struct jtag_queue *jtag_queue_create (jtag_operator_t op, jtag_batch_t batch, void *handle);
+
+/**
+  \brief        Destroy the JTAG queue, queued scans are dropped
+  \param[in]    q, the handle of JTAG queue
+  \return       None
+*/
+void jtag_queue_destroy (struct jtag_queue *q);
+
+/**
+  \brief        Queue an IR/DR scan
+  \param[in]    q, the handle of JTAG queue
+  \param[in]    ir_len, the length of IR in bytes
+  \param[in]    ir, the value of IR
+  \param[in]    dr_len, the length of DR in bytes
+  \param[in]    dr_w, the DR input
+  \param[out]   dr_r, filled with the DR output after flush, could be NULL.
+                It must be valid until then
+  \return       zero for success, negative for error
+*/
+int jtag_queue_scan (struct jtag_queue *q, int ir_len, const unsigned char *ir,
+                     int dr_len, const unsigned char *dr_w, unsigned char *dr_r);
+
+/**
+  \brief        Queue a DMI write of RISC-V DTM
+  \param[in]    q, the handle of JTAG queue
+  \param[in]    abits, the address bits of DMI
+  \param[in]    addr, the address of DM register
+  \param[in]    data, the value
+  \return       zero for success, negative for error
+*/
+int jtag_queue_dmi_write (struct jtag_queue *q, int abits, U32 addr, U32 data);
+
+/**
+  \brief        Queue a DMI read of RISC-V DTM, the value comes from the next
+                DMI scan, a NOP is queued for it at flush if needed
+  \param[in]    q, the handle of JTAG queue
+  \param[in]    abits, the address bits of DMI
+  \param[in]    addr, the address of DM register
+  \param[out]   value, filled after flush, it must be valid until then
+  \return       zero for success, negative for error
+*/
+int jtag_queue_dmi_read (struct jtag_queue *q, int abits, U32 addr, U32 *value);
+
+/**
+  \brief        Read dtmcs of RISC-V DTM at once, queued scans are flushed first.
+                DMI scans stay dtmcs.idle cycles in Run-Test/Idle from now on
+  \param[in]    q, the handle of JTAG queue
+  \param[out]   dtmcs, save the value of dtmcs, could be NULL
+  \return       zero for success, negative for error
+*/
+int jtag_queue_read_dtmcs (struct jtag_queue *q, U32 *dtmcs);
+
+/**
+  \brief        Execute the queued scans and fill in the results. After a busy
+                DMI op, the DMI is reset by dtmcs.dmireset, the idle cycles are
+                raised and the scans are done again from the first op which is
+                lost. A read of a register with side effects may be done twice
+  \param[in]    q, the handle of JTAG queue
+  \return       zero for success, negative for error of the link, a failed DMI
+                op or busy after JTAG_QUEUE_MAX_RETRIES replays
+*/
+int jtag_queue_flush (struct jtag_queue *q);
+
+/**
+  \brief        Get the statistics of JTAG queue
+  \param[in]    q, the handle of JTAG queue
+  \param[out]   stats, save the statistics
+  \return       None
+*/
+void jtag_queue_get_stats (struct jtag_queue *q, struct jtag_queue_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_JTAG_QUEUE_H__
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "link_ops.h"
+#include "host_os.h"
+
+int
+link_ops_copy (struct link_ops *ops, const struct link_ops *link)
+{
+    size_t size;
+
+    if (ops == NULL || link == NULL || link->size < offsetof (struct link_ops, name)) {
+        return -1;
+    }
+    size = link->size < sizeof (struct link_ops) ? link->size : sizeof (struct link_ops);
+    memset (ops, 0, sizeof (struct link_ops));
+    memcpy (ops, link, size);
+    ops->version = LINK_OPS_VERSION;
+    ops->size = sizeof (struct link_ops);
+    return 0;
+}
+
+/* The links built before the table, such as Cklink.dll.  */
+static int
+link_ops_by_name (void *lib, struct link_ops *ops)
+{
+    memset (ops, 0, sizeof (struct link_ops));
+    *(void **)&ops->name = host_lib_symbol (lib, "THE_NAME_OF_LINK");
+    if (ops->name == NULL) {
+        return -1;
+    }
+    *(void **)&ops->init = host_lib_symbol (lib, "link_init");
+    *(void **)&ops->open = host_lib_symbol (lib, "link_open");
+    *(void **)&ops->close = host_lib_symbol (lib, "link_close");
+    *(void **)&ops->config = host_lib_symbol (lib, "link_config");
+    *(void **)&ops->upgrade = host_lib_symbol (lib, "link_upgrade");
+    *(void **)&ops->memory_read = host_lib_symbol (lib, "link_memory_read");
+    *(void **)&ops->memory_write = host_lib_symbol (lib, "link_memory_write");
+    *(void **)&ops->register_read = host_lib_symbol (lib, "link_register_read");
+    *(void **)&ops->register_write = host_lib_symbol (lib, "link_register_write");
+    *(void **)&ops->jtag_operator = host_lib_symbol (lib, "link_jtag_operator");
+    *(void **)&ops->gpio_operator = host_lib_symbol (lib, "link_gpio_operator");
+    *(void **)&ops->show_info = host_lib_symbol (lib, "link_show_info");
+    *(void **)&ops->reset = host_lib_symbol (lib, "link_reset");
+    *(void **)&ops->get_device_list = host_lib_symbol (lib, "link_get_device_list");
+    *(void **)&ops->get_device_list_with_vid_pid = host_lib_symbol (lib,
+                                                   "link_get_device_list_with_vid_pid");
+    ops->version = LINK_OPS_VERSION;
+    ops->size = sizeof (struct link_ops);
+    return 0;
+}
+
+void *
+link_ops_load (const char *path, struct link_ops *ops)
+{
+    link_get_ops_t get_ops;
+    void *lib;
+    int ret;
+
+    if (path == NULL || ops == NULL) {
+        return NULL;
+    }
+    lib = host_lib_open (path);
+    if (lib == NULL) {
+        return NULL;
+    }
+    *(void **)&get_ops = host_lib_symbol (lib, LINK_OPS_ENTRY);
+    if (get_ops) {
+        ret = link_ops_copy (ops, get_ops (LINK_OPS_VERSION));
+    } else {
+        ret = link_ops_by_name (lib, ops);
+    }
+    if (ret < 0 || ops->open == NULL || ops->close == NULL) {
+        host_lib_close (lib);
+        return NULL;
+    }
+    return lib;
+}
+
+void
+link_ops_unload (void *lib)
+{
+    host_lib_close (lib);
+}
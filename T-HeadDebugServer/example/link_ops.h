@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: link_ops.h
+// function description: versioned function table of the link ABI in link.h,
+//                       loaded from any link shared object.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_LINK_OPS_H__
+#define __DEBUGGER_SERVER_EXAMPLE_LINK_OPS_H__
+
+#include "dbg-target.h"
+#include "jtag_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LINK_OPS_VERSION    1               ///< The version of struct link_ops
+#define LINK_OPS_ENTRY      "link_get_ops"  ///< The entry exported by a versioned link
+
+#if defined _WIN32 && !defined (__CYGWIN)
+#define LINK_OPS_API __declspec(dllexport)
+#else
+#define LINK_OPS_API
+#endif
+
+/**
+\brief The functions of a link, see link.h for the meanings. Entries which
+       the link has not are NULL, only name, open and close are required.
+       init must be called before open if the link has it.
+*/
+struct link_ops
+{
+    unsigned int version;       ///< The version the table is built for
+    unsigned int size;          ///< sizeof (struct link_ops) of the link
+    const char *(*name) (void);
+    int (*init) (dbg_server_cfg_t *cfg);
+    void *(*open) (dbg_server_cfg_t *cfg, void *unique);
+    void (*close) (void *handle);
+    int (*config) (void *handle, enum LINK_CONFIG_KEY key, unsigned int value);
+    int (*upgrade) (void *handle, const char *path);
+    int (*memory_read) (void *handle, uint64_t addr, int xlen, uint8_t *buff, int length, int mode);
+    int (*memory_write) (void *handle, uint64_t addr, int xlen, uint8_t *buff, int length, int mode);
+    int (*register_read) (void *handle, int regno, uint8_t *buff, int nbyte);
+    int (*register_write) (void *handle, int regno, uint8_t *buff, int nbyte);
+    jtag_operator_t jtag_operator;
+    jtag_batch_t jtag_batch;    ///< Many scans in one transfer, see jtag_queue.h
+    int (*gpio_operator) (void *handle, int gpio_out, int *gpio_in, int gpio_eo, int gpio_mode);
+    int (*show_info) (void *handle, dbg_server_cfg_t *cfg, void (*func) (const char *, ...));
+    int (*reset) (void *handle, int hard);
+    int (*get_device_list) (struct link_dev *dev, int *count);
+    int (*get_device_list_with_vid_pid) (U16 vid, U16 pid, struct link_dev *dev, int *count);
+};
+
+/**
+  \brief        The type of LINK_OPS_ENTRY
+  \param[in]    version, LINK_OPS_VERSION of the caller
+  \return       The table of the link, NULL if the version is not supported
+*/
+typedef const struct link_ops *(*link_get_ops_t) (unsigned int version);
+
+/**
+  \brief        Load a link shared object. LINK_OPS_ENTRY is used if it is
+                exported, otherwise the functions of link.h are looked up by
+                name, THE_NAME_OF_LINK must be there.
+  \param[in]    path, the path of the shared object, such as Cklink.dll
+  \param[out]   ops, save the table, entries the link has not are NULL
+  \return       A handle for success, otherwise return NULL
+*/
+void *link_ops_load (const char *path, struct link_ops *ops);
+
+/**
+  \brief        Unload the link shared object
+  \param[in]    lib, the handle of link_ops_load
+  \return       None
+*/
+void link_ops_unload (void *lib);
+
+/**
+  \brief        Copy a table of the link, newer entries are dropped and the
+                entries the link has not are NULL
+  \param[out]   ops, save the table
+  \param[in]    link, the table of the link
+  \return       zero for success, negative for error
+*/
+int link_ops_copy (struct link_ops *ops, const struct link_ops *link);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_LINK_OPS_H__
@@ -0,0 +1,441 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "link_sched.h"
+#include "mem_access.h"
+#include "mem_iov.h"
+
+struct link_queue
+{
+    struct link_req *head;
+    struct link_req *tail;
+};
+
+struct link_sched
+{
+    struct target *tgt;
+    hostMutex *lock;            ///< The lock of target access
+    hostMutex mutex;            ///< Protects the queues and statistics
+    semVar kick;                ///< Posted for each request queued
+    hostThread thread;
+    struct link_queue queue[LINK_PRIO_COUNT][MAX_CPU_COUNT];
+    int rr[LINK_PRIO_COUNT];    ///< The cpu served next, round-robin
+    int stop;
+    struct link_sched_stats stats;
+};
+
+static void
+link_queue_push (struct link_queue *q, struct link_req *req)
+{
+    req->next = NULL;
+    if (q->tail) {
+        q->tail->next = req;
+    } else {
+        q->head = req;
+    }
+    q->tail = req;
+}
+
+static struct link_req *
+link_queue_pop (struct link_queue *q)
+{
+    struct link_req *req = q->head;
+
+    if (req) {
+        q->head = req->next;
+        if (q->head == NULL) {
+            q->tail = NULL;
+        }
+        req->next = NULL;
+    }
+    return req;
+}
+
+/* Take the next requests, the highest priority first and cpus in turn.
+   Small memory reads queued behind the first one are taken together.
+   The mutex is held.  */
+static int
+link_sched_pick (struct link_sched *ls, struct link_req **batch)
+{
+    int prio, i, count = 0;
+
+    for (prio = 0; prio < LINK_PRIO_COUNT; prio++) {
+        for (i = 0; i < MAX_CPU_COUNT; i++) {
+            int cpu = (ls->rr[prio] + i) % MAX_CPU_COUNT;
+            struct link_queue *q = &ls->queue[prio][cpu];
+
+            if (q->head == NULL) {
+                continue;
+            }
+            batch[count++] = link_queue_pop (q);
+            if (batch[0]->type == LINK_REQ_READ_MEMORY && prio == LINK_PRIO_NORMAL) {
+                while (count < LINK_SCHED_MERGE_MAX && q->head
+                       && q->head->type == LINK_REQ_READ_MEMORY) {
+                    batch[count++] = link_queue_pop (q);
+                    ls->stats.merged++;
+                }
+            }
+            ls->rr[prio] = (cpu + 1) % MAX_CPU_COUNT;
+            return count;
+        }
+    }
+    return 0;
+}
+
+static int
+link_sched_memory_chunk (struct link_sched *ls, struct link_req *req)
+{
+    unsigned int size = req->size - req->done_size;
+    int ret;
+
+    if (size > LINK_SCHED_CHUNK) {
+        size = LINK_SCHED_CHUNK;
+    }
+    if (req->type == LINK_REQ_READ_MEMORY) {
+        ret = mem_access_read (ls->tgt, req->addr + req->done_size,
+                               req->buff + req->done_size, size);
+    } else {
+        ret = mem_access_write (ls->tgt, req->addr + req->done_size,
+                                req->buff + req->done_size, size);
+    }
+    req->done_size += size;
+    return ret;
+}
+
+/* Do the requests of one cpu, the target lock is held.  Return non-zero
+   if the first request is not finished, only for bulk accesses.  */
+static int
+link_sched_execute (struct link_sched *ls, struct link_req **batch, int count,
+                    int *switched)
+{
+    struct link_req *req = batch[0];
+    int i;
+
+    /* Other holders of the lock may select another cpu, so the current
+       one is read again for each batch.  */
+    if (req->cpu != target_get_current_cpu (ls->tgt)) {
+        *switched = 1;
+        if (target_select_cpu (ls->tgt, req->cpu) < 0) {
+            for (i = 0; i < count; i++) {
+                batch[i]->result = -1;
+            }
+            return 0;
+        }
+    }
+
+    switch (req->type) {
+    case LINK_REQ_READ_MEMORY:
+        if (count > 1) {
+            struct mem_iov iov[LINK_SCHED_MERGE_MAX];
+            int ret;
+
+            for (i = 0; i < count; i++) {
+                iov[i].addr = batch[i]->addr;
+                iov[i].buff = batch[i]->buff;
+                iov[i].size = batch[i]->size;
+            }
+            ret = target_read_memory_v (ls->tgt, iov, count);
+            for (i = 0; i < count; i++) {
+                batch[i]->result = ret < 0 ? -1 : 0;
+            }
+            return 0;
+        }
+        /* fall through */
+    case LINK_REQ_WRITE_MEMORY:
+        req->result = link_sched_memory_chunk (ls, req) < 0 ? -1 : 0;
+        return req->result == 0 && req->done_size < req->size;
+    case LINK_REQ_READ_REG:
+        req->result = target_read_cpu_reg (ls->tgt, req->reg);
+        return 0;
+    case LINK_REQ_WRITE_REG:
+        req->result = target_write_cpu_reg (ls->tgt, req->reg);
+        return 0;
+    case LINK_REQ_HALT:
+        req->result = target_halt (ls->tgt);
+        return 0;
+    case LINK_REQ_RESUME:
+        req->result = target_resume (ls->tgt);
+        return 0;
+    case LINK_REQ_STEP:
+        req->result = target_single_step (ls->tgt);
+        return 0;
+    case LINK_REQ_CALL:
+        req->result = req->call ? req->call (ls->tgt, req->priv) : -1;
+        return 0;
+    default:
+        req->result = -1;
+        return 0;
+    }
+}
+
+static void
+link_latency_add (struct link_sched_latency *lat, struct link_req *req, U64 us)
+{
+    lat->requests++;
+    if (req->type == LINK_REQ_READ_MEMORY || req->type == LINK_REQ_WRITE_MEMORY) {
+        lat->bytes += req->size;
+    }
+    lat->sum_us += us;
+    if (us > lat->max_us) {
+        lat->max_us = us;
+    }
+}
+
+static void *
+link_sched_thread (void *arg)
+{
+    struct link_sched *ls = arg;
+    struct link_req *batch[LINK_SCHED_MERGE_MAX];
+    int i, count, more, switched;
+
+    LOCK (&ls->mutex);
+    for (;;) {
+        count = link_sched_pick (ls, batch);
+        if (count == 0) {
+            if (ls->stop) {
+                break;
+            }
+            UNLOCK (&ls->mutex);
+            host_sem_wait (&ls->kick, -1);
+            LOCK (&ls->mutex);
+            continue;
+        }
+        ls->stats.batches++;
+        UNLOCK (&ls->mutex);
+
+        if (ls->lock) {
+            LOCK (ls->lock);
+        }
+        switched = 0;
+        more = link_sched_execute (ls, batch, count, &switched);
+        if (ls->lock) {
+            UNLOCK (ls->lock);
+        }
+
+        LOCK (&ls->mutex);
+        ls->stats.cpu_switches += switched;
+        if (batch[0]->prio == LINK_PRIO_BULK) {
+            ls->stats.chunks++;
+        }
+        if (more) {
+            /* Behind the others of the same cpu and priority.  */
+            link_queue_push (&ls->queue[batch[0]->prio][batch[0]->cpu], batch[0]);
+            continue;
+        }
+        for (i = 0; i < count; i++) {
+            U64 us = host_time_us () - batch[i]->submit_us;
+
+            link_latency_add (&ls->stats.cpu[batch[i]->cpu], batch[i], us);
+            link_latency_add (&ls->stats.prio[batch[i]->prio], batch[i], us);
+            WAKEUP (*batch[i]->done);
+        }
+    }
+    UNLOCK (&ls->mutex);
+    return NULL;
+}
+
+struct link_sched *
+link_sched_create (struct target *tgt, hostMutex *lock)
+{
+    struct link_sched *ls;
+
+    if (tgt == NULL) {
+        return NULL;
+    }
+    ls = calloc (1, sizeof (struct link_sched));
+    if (ls == NULL) {
+        return NULL;
+    }
+    ls->tgt = tgt;
+    ls->lock = lock;
+    if (host_mutex_init (&ls->mutex) < 0) {
+        free (ls);
+        return NULL;
+    }
+    if (host_sem_init (&ls->kick, 0) < 0) {
+        host_mutex_destroy (&ls->mutex);
+        free (ls);
+        return NULL;
+    }
+    if (host_thread_create (&ls->thread, link_sched_thread, ls) < 0) {
+        host_sem_destroy (&ls->kick);
+        host_mutex_destroy (&ls->mutex);
+        free (ls);
+        return NULL;
+    }
+    return ls;
+}
+
+void
+link_sched_destroy (struct link_sched *ls)
+{
+    if (ls == NULL) {
+        return;
+    }
+    LOCK (&ls->mutex);
+    ls->stop = 1;
+    UNLOCK (&ls->mutex);
+    WAKEUP (ls->kick);
+    host_thread_join (ls->thread);
+
+    host_sem_destroy (&ls->kick);
+    host_mutex_destroy (&ls->mutex);
+    free (ls);
+}
+
+int
+link_sched_submit (struct link_sched *ls, struct link_req *req)
+{
+    semVar done;
+
+    if (ls == NULL || req == NULL || req->cpu < 0 || req->cpu >= MAX_CPU_COUNT) {
+        return -1;
+    }
+    switch (req->type) {
+    case LINK_REQ_READ_MEMORY:
+    case LINK_REQ_WRITE_MEMORY:
+        if (req->buff == NULL && req->size != 0) {
+            return -1;
+        }
+        req->prio = req->size > LINK_SCHED_CHUNK ? LINK_PRIO_BULK : LINK_PRIO_NORMAL;
+        break;
+    case LINK_REQ_READ_REG:
+    case LINK_REQ_WRITE_REG:
+        if (req->reg == NULL) {
+            return -1;
+        }
+        req->prio = LINK_PRIO_NORMAL;
+        break;
+    case LINK_REQ_CALL:
+        req->prio = LINK_PRIO_NORMAL;
+        break;
+    case LINK_REQ_HALT:
+    case LINK_REQ_RESUME:
+    case LINK_REQ_STEP:
+        req->prio = LINK_PRIO_RUN;
+        break;
+    default:
+        return -1;
+    }
+    if (host_sem_init (&done, 0) < 0) {
+        return -1;
+    }
+    req->done = &done;
+    req->done_size = 0;
+    req->result = -1;
+
+    LOCK (&ls->mutex);
+    if (ls->stop) {
+        UNLOCK (&ls->mutex);
+        host_sem_destroy (&done);
+        return -1;
+    }
+    req->submit_us = host_time_us ();
+    link_queue_push (&ls->queue[req->prio][req->cpu], req);
+    UNLOCK (&ls->mutex);
+    WAKEUP (ls->kick);
+
+    host_sem_wait (&done, -1);
+    host_sem_destroy (&done);
+    req->done = NULL;
+    return req->result;
+}
+
+static int
+link_sched_memory (struct link_sched *ls, enum link_req_type type, int cpu,
+                   U64 addr, unsigned char *buff, unsigned int size)
+{
+    struct link_req req;
+
+    memset (&req, 0, sizeof (req));
+    req.type = type;
+    req.cpu = cpu;
+    req.addr = addr;
+    req.buff = buff;
+    req.size = size;
+    return link_sched_submit (ls, &req);
+}
+
+int
+link_sched_read_memory (struct link_sched *ls, int cpu, U64 addr,
+                        unsigned char *buff, unsigned int size)
+{
+    return link_sched_memory (ls, LINK_REQ_READ_MEMORY, cpu, addr, buff, size);
+}
+
+int
+link_sched_write_memory (struct link_sched *ls, int cpu, U64 addr,
+                         unsigned char *buff, unsigned int size)
+{
+    return link_sched_memory (ls, LINK_REQ_WRITE_MEMORY, cpu, addr, buff, size);
+}
+
+static int
+link_sched_reg (struct link_sched *ls, enum link_req_type type, int cpu,
+                struct reg *reg)
+{
+    struct link_req req;
+
+    memset (&req, 0, sizeof (req));
+    req.type = type;
+    req.cpu = cpu;
+    req.reg = reg;
+    return link_sched_submit (ls, &req);
+}
+
+int
+link_sched_read_reg (struct link_sched *ls, int cpu, struct reg *reg)
+{
+    return link_sched_reg (ls, LINK_REQ_READ_REG, cpu, reg);
+}
+
+int
+link_sched_write_reg (struct link_sched *ls, int cpu, struct reg *reg)
+{
+    return link_sched_reg (ls, LINK_REQ_WRITE_REG, cpu, reg);
+}
+
+int
+link_sched_run_control (struct link_sched *ls, int cpu, enum link_req_type type)
+{
+    struct link_req req;
+
+    if (type != LINK_REQ_HALT && type != LINK_REQ_RESUME && type != LINK_REQ_STEP) {
+        return -1;
+    }
+    memset (&req, 0, sizeof (req));
+    req.type = type;
+    req.cpu = cpu;
+    return link_sched_submit (ls, &req);
+}
+
+void
+link_sched_get_stats (struct link_sched *ls, struct link_sched_stats *stats, int reset)
+{
+    if (ls == NULL) {
+        return;
+    }
+    LOCK (&ls->mutex);
+    if (stats) {
+        *stats = ls->stats;
+    }
+    if (reset) {
+        memset (&ls->stats, 0, sizeof (ls->stats));
+    }
+    UNLOCK (&ls->mutex);
+}
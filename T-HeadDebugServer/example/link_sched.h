@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: link_sched.h
+// function description: scheduler of target accesses from per-cpu sessions,
+//                       one worker thread owns the link, run control goes
+//                       before register and memory accesses, bulk memory
+//                       accesses are split and served round-robin.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_LINK_SCHED_H__
+#define __DEBUGGER_SERVER_EXAMPLE_LINK_SCHED_H__
+
+#include "dbg-target.h"
+#include "host_os.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LINK_SCHED_CHUNK        4096    ///< Larger memory accesses are bulk, served by chunks
+#define LINK_SCHED_MERGE_MAX    16      ///< Memory reads of one cpu merged into one batch
+
+/*----- The type of request -----*/
+enum link_req_type
+{
+	LINK_REQ_READ_MEMORY = 0,   ///<target_read_memory
+	LINK_REQ_WRITE_MEMORY,      ///<target_write_memory
+	LINK_REQ_READ_REG,          ///<target_read_cpu_reg
+	LINK_REQ_WRITE_REG,         ///<target_write_cpu_reg
+	LINK_REQ_HALT,              ///<target_halt
+	LINK_REQ_RESUME,            ///<target_resume
+	LINK_REQ_STEP,              ///<target_single_step
+	LINK_REQ_CALL,              ///<call a function with the target
+};
+
+/*----- The priority of request, derived from the type -----*/
+enum link_req_prio
+{
+	LINK_PRIO_RUN = 0,          ///<halt, resume and step
+	LINK_PRIO_NORMAL,           ///<registers, small memory accesses and calls
+	LINK_PRIO_BULK,             ///<memory accesses larger than LINK_SCHED_CHUNK
+	LINK_PRIO_COUNT,
+};
+
+/**
+\brief The request to the scheduler
+*/
+struct link_req
+{
+    enum link_req_type type;    ///< The type of request
+    int cpu;                    ///< The cpu accessed, it is selected before
+    U64 addr;                   ///< The memory address
+    unsigned char *buff;        ///< The memory buffer
+    unsigned int size;          ///< The memory size
+    struct reg *reg;            ///< The register
+    int (*call) (struct target *tgt, void *priv);   ///< For LINK_REQ_CALL
+    void *priv;                 ///< For LINK_REQ_CALL
+    int result;                 ///< The result, zero for success, negative for error
+
+    /* Private to the scheduler.  */
+    enum link_req_prio prio;
+    unsigned int done_size;
+    U64 submit_us;
+    semVar *done;
+    struct link_req *next;
+};
+
+/**
+\brief The latency statistics of a group of requests
+*/
+struct link_sched_latency
+{
+    unsigned int requests;      ///< Requests done
+    U64 bytes;                  ///< Memory bytes accessed
+    U64 sum_us;                 ///< Sum of latency
+    U64 max_us;                 ///< Max latency
+};
+
+/**
+\brief The statistics of scheduler
+*/
+struct link_sched_stats
+{
+    struct link_sched_latency cpu[MAX_CPU_COUNT];       ///< By cpu
+    struct link_sched_latency prio[LINK_PRIO_COUNT];    ///< By priority
+    unsigned int batches;       ///< Turns of the worker
+    unsigned int merged;        ///< Requests merged into another one's batch
+    unsigned int chunks;        ///< Chunks of bulk accesses
+    unsigned int cpu_switches;  ///< Calls of target_select_cpu
+};
+
+/// definition for scheduler, see link_sched.c
+struct link_sched;
+
+/**
+  \brief        Create the scheduler and its worker thread
+  \param[in]    tgt, the handle of target
+  \param[in]    lock, held by the worker while accessing the target, such as
+                the lock of session. NULL for no lock
+  \return       A handle for success, otherwise return NULL
+*/
+struct link_sched *link_sched_create (struct target *tgt, hostMutex *lock);
+
+/**
+  \brief        Stop the worker after the queued requests and destroy the scheduler
+  \param[in]    ls, the handle of scheduler
+  \return       None
+*/
+void link_sched_destroy (struct link_sched *ls);
+
+/**
+  \brief        Queue the request and wait until it is done, it could be
+                called from many threads
+  \param[in]    ls, the handle of scheduler
+  \param[in,out] req, the request, result is set when returned
+  \return       The result of the request
+*/
+int link_sched_submit (struct link_sched *ls, struct link_req *req);
+
+/**
+  \brief        Read memory of the cpu, see target_read_memory
+  \return       zero for success, negative for error
+*/
+int link_sched_read_memory (struct link_sched *ls, int cpu, U64 addr,
+                            unsigned char *buff, unsigned int size);
+
+/**
+  \brief        Write memory of the cpu, see target_write_memory
+  \return       zero for success, negative for error
+*/
+int link_sched_write_memory (struct link_sched *ls, int cpu, U64 addr,
+                             unsigned char *buff, unsigned int size);
+
+/**
+  \brief        Read register of the cpu, see target_read_cpu_reg
+  \return       zero for success, negative for error
+*/
+int link_sched_read_reg (struct link_sched *ls, int cpu, struct reg *reg);
+
+/**
+  \brief        Write register of the cpu, see target_write_cpu_reg
+  \return       zero for success, negative for error
+*/
+int link_sched_write_reg (struct link_sched *ls, int cpu, struct reg *reg);
+
+/**
+  \brief        Run control of the cpu, LINK_REQ_HALT, LINK_REQ_RESUME or LINK_REQ_STEP
+  \return       zero for success, negative for error
+*/
+int link_sched_run_control (struct link_sched *ls, int cpu, enum link_req_type type);
+
+/**
+  \brief        Get the statistics of scheduler
+  \param[in]    ls, the handle of scheduler
+  \param[out]   stats, save the statistics
+  \param[in]    reset, clear the statistics after reading
+  \return       None
+*/
+void link_sched_get_stats (struct link_sched *ls, struct link_sched_stats *stats, int reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_LINK_SCHED_H__
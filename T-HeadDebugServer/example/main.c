@@ -20,8 +20,32 @@
 #include <dbg-target.h>
 
 extern  int test_memory (struct target *target);
+extern  int test_memory_access (struct target *target);
+extern  int test_memory_v (struct target *target);
+extern  int test_memory_cache (struct target *target);
+extern  int test_memory_download (struct target *target);
+extern  int test_memory_region (struct target *target);
 extern  int test_register (struct target *target);
+extern  int test_register_batch (struct target *target);
+extern  int test_register_cache (struct target *target);
 extern  int test_breakpoint (struct target *target);
+extern  int test_breakpoint_index (struct target *target);
+extern  int test_breakpoint_batch (struct target *target);
+extern  int test_breakpoint_lazy (struct target *target);
+extern  int test_halt_wait (struct target *target);
+extern  int test_cpu_states (struct target *target);
+extern  int test_cpu_group (struct target *target);
+extern  int test_link_sched (struct target *target);
+extern  int test_pc_stream (struct target *target);
+extern  int test_pc_profile (struct target *target);
+extern  int test_proc_profile (struct target *target);
+extern  int test_sample_file (struct target *target);
+extern  int test_dcomm_output (struct target *target);
+extern  int test_dcomm_mux (struct target *target);
+extern  int test_semihost_iov (struct target *target);
+extern  int test_semihost (struct target *target);
+extern  int test_jtag_queue (struct target *target);
+extern  int test_link_ops (struct target *target);
 
 /* Try to avoid exiting right now in windows */
 void
@@ -68,12 +92,84 @@ int main(int argc, char **argv)
 	/* Memory access test.  */
 	test_memory(cfg.target);
 
+	/* Widest memory access test.  */
+	test_memory_access(cfg.target);
+
+	/* Vectored memory access test.  */
+	test_memory_v(cfg.target);
+
+	/* Memory cache test.  */
+	test_memory_cache(cfg.target);
+
+	/* Pipelined download test.  */
+	test_memory_download(cfg.target);
+
+	/* Memory access mode by region test, only riscv.  */
+	test_memory_region(cfg.target);
+
 	/* Register access test.  */
 	test_register(cfg.target);
 
+	/* Register batch test.  */
+	test_register_batch(cfg.target);
+
+	/* Register cache test.  */
+	test_register_cache(cfg.target);
+
 	/* Breakpoint test.  */
 	test_breakpoint(cfg.target);
 
+	/* Breakpoint index test.  */
+	test_breakpoint_index(cfg.target);
+
+	/* Breakpoint batch test.  */
+	test_breakpoint_batch(cfg.target);
+
+	/* Lazy breakpoint test.  */
+	test_breakpoint_lazy(cfg.target);
+
+	/* Halt wait test.  */
+	test_halt_wait(cfg.target);
+
+	/* Cpu states test.  */
+	test_cpu_states(cfg.target);
+
+	/* Cpu group test.  */
+	test_cpu_group(cfg.target);
+
+	/* Link scheduler test.  */
+	test_link_sched(cfg.target);
+
+	/* PC stream test.  */
+	test_pc_stream(cfg.target);
+
+	/* PC profile test.  */
+	test_pc_profile(cfg.target);
+
+	/* Per-process profile test.  */
+	test_proc_profile(cfg.target);
+
+	/* Sample file test.  */
+	test_sample_file(cfg.target);
+
+	/* Buffered dcomm output test.  */
+	test_dcomm_output(cfg.target);
+
+	/* Dcomm channels test.  */
+	test_dcomm_mux(cfg.target);
+
+	/* Semihosting vectored write table test.  */
+	test_semihost_iov(cfg.target);
+
+	/* Semihosting test.  */
+	test_semihost(cfg.target);
+
+	/* JTAG queue test.  */
+	test_jtag_queue(cfg.target);
+
+	/* Link function table test.  */
+	test_link_ops(cfg.target);
+
 	/* Resume. */
 	target_resume (cfg.target);
 
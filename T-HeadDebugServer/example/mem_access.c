@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "mem_access.h"
+
+/* Access width in bytes of enum TARGET_MEM_ACCESS_MAX_MODE.  */
+#define MEM_ACCESS_WIDTH(mode)  (8u >> (mode))
+
+#define MEM_ACCESS_TARGET_MAX   8
+
+/* The state of a target, the max mode is per target since several targets
+   may be opened by one process.  */
+struct mem_access_target
+{
+    struct target *tgt;
+    enum TARGET_MEM_ACCESS_MAX_MODE limit;      ///< The configured max mode
+    enum TARGET_MEM_ACCESS_MAX_MODE xlen_mode;  ///< The max mode from XLEN
+    enum TARGET_MEM_ACCESS_MAX_MODE max_mode;   ///< The narrower one of both
+    int configured;             ///< The limit is set by mem_access_set_max_mode
+    int refs;                   ///< Times of mem_access_init
+    mem_access_backend_t backend;   ///< The transfer, NULL for the default one
+    void *backend_priv;
+};
+
+static struct mem_access_target access_targets[MEM_ACCESS_TARGET_MAX];
+static struct mem_access_stats access_stats;
+
+static struct mem_access_target *
+mem_access_lookup (struct target *tgt, int create)
+{
+    struct mem_access_target *free_slot = NULL;
+    int i;
+
+    for (i = 0; i < MEM_ACCESS_TARGET_MAX; i++) {
+        if (access_targets[i].tgt == tgt) {
+            return &access_targets[i];
+        }
+        if (free_slot == NULL && access_targets[i].tgt == NULL) {
+            free_slot = &access_targets[i];
+        }
+    }
+    if (!create || free_slot == NULL) {
+        return NULL;
+    }
+    memset (free_slot, 0, sizeof (struct mem_access_target));
+    free_slot->tgt = tgt;
+    free_slot->limit = MEM_ACCESS_MODE_DWORD;
+    free_slot->xlen_mode = MEM_ACCESS_MODE_WORD;
+    free_slot->max_mode = MEM_ACCESS_MODE_WORD;
+    return free_slot;
+}
+
+static int
+mem_access_default (void *priv, struct target *tgt, U64 addr,
+                    unsigned char *buff, unsigned int size, int write)
+{
+    if (write) {
+        return target_write_memory (tgt, addr, buff, size);
+    }
+    return target_read_memory (tgt, addr, buff, size);
+}
+
+static enum TARGET_MEM_ACCESS_MAX_MODE
+mem_access_mode (unsigned int width)
+{
+    switch (width) {
+    case 8:
+        return MEM_ACCESS_MODE_DWORD;
+    case 4:
+        return MEM_ACCESS_MODE_WORD;
+    case 2:
+        return MEM_ACCESS_MODE_HWORD;
+    default:
+        return MEM_ACCESS_MODE_BYTE;
+    }
+}
+
+static int
+mem_access_config (struct target *tgt, enum TARGET_MEM_ACCESS_MAX_MODE mode)
+{
+    access_stats.mode_switches++;
+    return target_config_target (tgt, TARGET_CONFIG_MEM_MAX_MODE, &mode);
+}
+
+/* The larger enum value is the narrower width.  */
+static void
+mem_access_update (struct mem_access_target *t)
+{
+    t->max_mode = t->limit > t->xlen_mode ? t->limit : t->xlen_mode;
+}
+
+int
+mem_access_init (struct target *tgt)
+{
+    struct mem_access_target *t;
+    int xlen = 0;
+
+    if (tgt == NULL || (t = mem_access_lookup (tgt, 1)) == NULL) {
+        return -1;
+    }
+    if (target_get_target_config (tgt, TARGET_GET_XLEN, &xlen) < 0) {
+        xlen = 32;
+    }
+    t->xlen_mode = xlen == 64 ? MEM_ACCESS_MODE_DWORD : MEM_ACCESS_MODE_WORD;
+    t->refs++;
+    mem_access_update (t);
+    return mem_access_config (tgt, t->max_mode);
+}
+
+void
+mem_access_exit (struct target *tgt)
+{
+    struct mem_access_target *t = mem_access_lookup (tgt, 0);
+
+    if (t == NULL || --t->refs > 0) {
+        return;
+    }
+    /* Leave the target with the configured mode.  */
+    if (t->configured && t->max_mode != t->limit) {
+        mem_access_config (tgt, t->limit);
+    }
+    t->tgt = NULL;
+}
+
+int
+mem_access_set_max_mode (struct target *tgt, enum TARGET_MEM_ACCESS_MAX_MODE mode)
+{
+    struct mem_access_target *t;
+
+    if (tgt == NULL || mode < MEM_ACCESS_MODE_DWORD || mode > MEM_ACCESS_MODE_BYTE
+        || (t = mem_access_lookup (tgt, 1)) == NULL) {
+        return -1;
+    }
+    t->limit = mode;
+    t->configured = 1;
+    mem_access_update (t);
+    return mem_access_config (tgt, t->max_mode);
+}
+
+/* The target stays in its max mode between requests, so an aligned
+   request costs no extra configuration.  */
+static int
+mem_access_xfer (struct target *tgt, U64 addr, unsigned char *buff,
+                 unsigned int size, int write)
+{
+    struct mem_access_target *t;
+    enum TARGET_MEM_ACCESS_MAX_MODE max_mode, cur, mode;
+    mem_access_backend_t backend;
+    void *priv;
+    unsigned int max_width, width, len;
+    int ret = 0;
+
+    if (tgt == NULL || buff == NULL) {
+        return -1;
+    }
+    t = mem_access_lookup (tgt, 0);
+    max_mode = t ? t->max_mode : MEM_ACCESS_MODE_WORD;
+    backend = t && t->backend ? t->backend : mem_access_default;
+    priv = t && t->backend ? t->backend_priv : NULL;
+    max_width = MEM_ACCESS_WIDTH (max_mode);
+    cur = max_mode;
+    access_stats.requests++;
+
+    while (size) {
+        /* The widest width which the address is aligned to and which
+           does not run over the end.  */
+        width = max_width;
+        while (width > 1 && ((addr & (width - 1)) || size < width)) {
+            width >>= 1;
+        }
+        len = width == max_width ? size & ~(max_width - 1) : width;
+
+        mode = mem_access_mode (width);
+        if (mode != cur) {
+            ret = mem_access_config (tgt, mode);
+            if (ret < 0) {
+                break;
+            }
+            cur = mode;
+        }
+
+        ret = backend (priv, tgt, addr, buff, len, write);
+        access_stats.segments++;
+        if (ret < 0) {
+            break;
+        }
+        addr += len;
+        buff += len;
+        size -= len;
+    }
+
+    if (cur != max_mode) {
+        mem_access_config (tgt, max_mode);
+    }
+    return ret;
+}
+
+int
+mem_access_set_backend (struct target *tgt, mem_access_backend_t backend, void *priv)
+{
+    struct mem_access_target *t;
+
+    if (tgt == NULL || (t = mem_access_lookup (tgt, 1)) == NULL) {
+        return -1;
+    }
+    t->backend = backend;
+    t->backend_priv = backend ? priv : NULL;
+    /* Nothing else is kept for the target.  */
+    if (backend == NULL && t->refs <= 0 && !t->configured) {
+        t->tgt = NULL;
+    }
+    return 0;
+}
+
+mem_access_backend_t
+mem_access_get_backend (struct target *tgt, void **priv)
+{
+    struct mem_access_target *t = mem_access_lookup (tgt, 0);
+
+    if (priv) {
+        *priv = t ? t->backend_priv : NULL;
+    }
+    return t ? t->backend : NULL;
+}
+
+int
+mem_access_read (struct target *tgt, U64 addr, unsigned char *buff, unsigned int size)
+{
+    return mem_access_xfer (tgt, addr, buff, size, 0);
+}
+
+int
+mem_access_write (struct target *tgt, U64 addr, unsigned char *buff, unsigned int size)
+{
+    return mem_access_xfer (tgt, addr, buff, size, 1);
+}
+
+void
+mem_access_get_stats (struct mem_access_stats *stats, int reset)
+{
+    if (stats) {
+        *stats = access_stats;
+    }
+    if (reset) {
+        memset (&access_stats, 0, sizeof (access_stats));
+    }
+}
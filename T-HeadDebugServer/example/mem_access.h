@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: mem_access.h
+// function description: split memory access into an unaligned head, an
+//                       aligned body and a tail, each one with the widest
+//                       legal access width.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_MEM_ACCESS_H__
+#define __DEBUGGER_SERVER_EXAMPLE_MEM_ACCESS_H__
+
+#include "dbg-target.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+\brief The statistics of memory access
+*/
+struct mem_access_stats
+{
+    unsigned int requests;      ///< Requests from callers
+    unsigned int segments;      ///< Segments issued to the target
+    unsigned int mode_switches; ///< Times TARGET_CONFIG_MEM_MAX_MODE was set
+};
+
+/**
+  \brief        The transfer under the width splitting, target_read_memory and
+                target_write_memory by default
+  \param[in]    priv, the private data passed to mem_access_set_backend
+  \param[in]    tgt, the handle of target
+  \param[in]    addr, the memory address
+  \param[in]    buff, the memory data
+  \param[in]    size, size of the memory data
+  \param[in]    write, bool type, write(1) or read(0)
+  \return       zero for success, negative for error
+*/
+typedef int (*mem_access_backend_t) (void *priv, struct target *tgt, U64 addr,
+                                     unsigned char *buff, unsigned int size, int write);
+
+/**
+  \brief        Set the max mode of the target from the XLEN of the current cpu,
+                MEM_ACCESS_MODE_DWORD for RV64, MEM_ACCESS_MODE_WORD for others.
+                It never goes wider than the mode set by mem_access_set_max_mode
+  \param[in]    tgt, the handle of target
+  \return       zero for success, negative for error
+*/
+int mem_access_init (struct target *tgt);
+
+/**
+  \brief        Drop a reference taken by mem_access_init, the configured max
+                mode is set back to the target by the last one
+  \param[in]    tgt, the handle of target
+  \return       None
+*/
+void mem_access_exit (struct target *tgt);
+
+/**
+  \brief        Configure TARGET_CONFIG_MEM_MAX_MODE of the target, use it instead
+                of target_config_target. The mode is the upper bound of the
+                width, mem_access_init only narrows it from XLEN
+  \param[in]    tgt, the handle of target
+  \param[in]    mode, the max mode
+  \return       zero for success, negative for error
+*/
+int mem_access_set_max_mode (struct target *tgt, enum TARGET_MEM_ACCESS_MAX_MODE mode);
+
+/**
+  \brief        Replace the transfer under the width splitting of the target
+  \param[in]    tgt, the handle of target
+  \param[in]    backend, the transfer, NULL for the default one
+  \param[in]    priv, the private data for backend
+  \return       zero for success, negative for error
+*/
+int mem_access_set_backend (struct target *tgt, mem_access_backend_t backend, void *priv);
+
+/**
+  \brief        Get the transfer under the width splitting of the target
+  \param[in]    tgt, the handle of target
+  \param[out]   priv, save the private data for backend, can be NULL
+  \return       The transfer, NULL for the default one
+*/
+mem_access_backend_t mem_access_get_backend (struct target *tgt, void **priv);
+
+/**
+  \brief        Read memory from target with the widest legal access width
+  \param[in]    tgt, the handle of target
+  \param[in]    addr, the memory address to be read
+  \param[out]   buff, an address which used to to save the memory data
+  \param[in]    size, size to be read
+  \return       zero for success, negative for error
+*/
+int mem_access_read (struct target *tgt, U64 addr, unsigned char *buff, unsigned int size);
+
+/**
+  \brief        Write memory to target with the widest legal access width
+  \param[in]    tgt, the handle of target
+  \param[in]    addr, the memory address to be written
+  \param[in]    buff, the data which will be written to the target
+  \param[in]    size, size to be written
+  \return       zero for success, negative for error
+*/
+int mem_access_write (struct target *tgt, U64 addr, unsigned char *buff, unsigned int size);
+
+/**
+  \brief        Get the statistics of memory access
+  \param[out]   stats, save the statistics
+  \param[in]    reset, clear the statistics after reading
+  \return       None
+*/
+void mem_access_get_stats (struct mem_access_stats *stats, int reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_MEM_ACCESS_H__
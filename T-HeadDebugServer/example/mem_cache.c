@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "mem_access.h"
+#include "mem_cache.h"
+#include "mem_iov.h"
+
+#define MEM_CACHE_PAGE_MASK     ((U64)MEM_CACHE_PAGE_SIZE - 1)
+
+struct mem_cache_page
+{
+    U64 addr;                   ///< Page aligned address
+    int valid;                  ///< The data is valid or not
+    unsigned char data[MEM_CACHE_PAGE_SIZE];
+};
+
+struct mem_cache
+{
+    struct target *tgt;
+    int enabled;
+    unsigned int count;
+    struct mem_cache_page *pages;
+    struct mem_cache_stats stats;
+};
+
+/* Pages are direct mapped, a page can only live in one slot.  */
+static struct mem_cache_page *
+mem_cache_slot (struct mem_cache *mc, U64 page)
+{
+    return &mc->pages[(page / MEM_CACHE_PAGE_SIZE) % mc->count];
+}
+
+struct mem_cache *
+mem_cache_create (struct target *tgt, unsigned int pages)
+{
+    struct mem_cache *mc;
+
+    if (tgt == NULL) {
+        return NULL;
+    }
+    mc = calloc (1, sizeof (struct mem_cache));
+    if (mc == NULL) {
+        return NULL;
+    }
+    mc->tgt = tgt;
+    mc->count = pages ? pages : MEM_CACHE_PAGE_COUNT;
+    mc->pages = calloc (mc->count, sizeof (struct mem_cache_page));
+    if (mc->pages == NULL) {
+        free (mc);
+        return NULL;
+    }
+    return mc;
+}
+
+void
+mem_cache_destroy (struct mem_cache *mc)
+{
+    if (mc == NULL) {
+        return;
+    }
+    free (mc->pages);
+    free (mc);
+}
+
+void
+mem_cache_enable (struct mem_cache *mc, int en)
+{
+    if (mc == NULL) {
+        return;
+    }
+    mem_cache_invalidate (mc);
+    mc->enabled = en ? 1 : 0;
+}
+
+void
+mem_cache_invalidate (struct mem_cache *mc)
+{
+    unsigned int i;
+
+    if (mc == NULL) {
+        return;
+    }
+    for (i = 0; i < mc->count; i++) {
+        mc->pages[i].valid = 0;
+    }
+    if (mc->enabled) {
+        mc->stats.invalidates++;
+    }
+}
+
+int
+mem_cache_read (struct mem_cache *mc, U64 addr, unsigned char *buff, unsigned int size)
+{
+    struct mem_cache_page *slot;
+    struct mem_iov *iov;
+    U64 first, last, page, start, end;
+    unsigned int npages, nmiss = 0, i;
+    int ret;
+
+    if (mc == NULL || buff == NULL) {
+        return -1;
+    }
+    if (size == 0) {
+        return 0;
+    }
+    if (!mc->enabled) {
+        return mem_access_read (mc->tgt, addr, buff, size);
+    }
+
+    first = addr & ~MEM_CACHE_PAGE_MASK;
+    last = (addr + size - 1) & ~MEM_CACHE_PAGE_MASK;
+    npages = (unsigned int)((last - first) / MEM_CACHE_PAGE_SIZE) + 1;
+
+    /* Larger than the cache itself, the pages would evict each other.  */
+    if (npages > mc->count) {
+        mc->stats.bypasses++;
+        return mem_access_read (mc->tgt, addr, buff, size);
+    }
+
+    iov = malloc (sizeof (struct mem_iov) * npages);
+    if (iov == NULL) {
+        return -1;
+    }
+
+    for (i = 0, page = first; i < npages; i++, page += MEM_CACHE_PAGE_SIZE) {
+        slot = mem_cache_slot (mc, page);
+        if (slot->valid && slot->addr == page) {
+            mc->stats.hits++;
+            continue;
+        }
+        mc->stats.misses++;
+        slot->valid = 0;
+        slot->addr = page;
+        iov[nmiss].addr = page;
+        iov[nmiss].buff = slot->data;
+        iov[nmiss].size = MEM_CACHE_PAGE_SIZE;
+        nmiss++;
+    }
+
+    if (nmiss) {
+        ret = target_read_memory_v (mc->tgt, iov, nmiss);
+        if (ret < 0) {
+            /* Whole pages may cover a hole or an IO window which the exact
+               range does not, so try the range alone without caching.  */
+            free (iov);
+            mc->stats.bypasses++;
+            return mem_access_read (mc->tgt, addr, buff, size);
+        }
+        for (i = 0; i < nmiss; i++) {
+            mem_cache_slot (mc, iov[i].addr)->valid = 1;
+        }
+    }
+    free (iov);
+
+    for (page = first; page <= last; page += MEM_CACHE_PAGE_SIZE) {
+        slot = mem_cache_slot (mc, page);
+        start = page > addr ? page : addr;
+        end = page + MEM_CACHE_PAGE_SIZE < addr + size ? page + MEM_CACHE_PAGE_SIZE : addr + size;
+        memcpy (buff + (start - addr), slot->data + (start - page), (size_t)(end - start));
+    }
+    return 0;
+}
+
+int
+mem_cache_write (struct mem_cache *mc, U64 addr, unsigned char *buff, unsigned int size)
+{
+    struct mem_cache_page *slot;
+    U64 page, start, end;
+    int ret;
+
+    if (mc == NULL || buff == NULL) {
+        return -1;
+    }
+    if (size == 0) {
+        return 0;
+    }
+
+    ret = mem_access_write (mc->tgt, addr, buff, size);
+    if (!mc->enabled) {
+        return ret;
+    }
+    if (ret < 0) {
+        /* Don't know how much has been written.  */
+        mem_cache_invalidate (mc);
+        return ret;
+    }
+
+    for (page = addr & ~MEM_CACHE_PAGE_MASK; page < addr + size; page += MEM_CACHE_PAGE_SIZE) {
+        slot = mem_cache_slot (mc, page);
+        if (!(slot->valid && slot->addr == page)) {
+            continue;
+        }
+        start = page > addr ? page : addr;
+        end = page + MEM_CACHE_PAGE_SIZE < addr + size ? page + MEM_CACHE_PAGE_SIZE : addr + size;
+        memcpy (slot->data + (start - page), buff + (start - addr), (size_t)(end - start));
+    }
+    return 0;
+}
+
+void
+mem_cache_get_stats (struct mem_cache *mc, struct mem_cache_stats *stats)
+{
+    if (mc == NULL || stats == NULL) {
+        return;
+    }
+    *stats = mc->stats;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: mem_cache.h
+// function description: page granular memory read cache, only valid while
+//                       the CPU is halted.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_MEM_CACHE_H__
+#define __DEBUGGER_SERVER_EXAMPLE_MEM_CACHE_H__
+
+#include "dbg-target.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEM_CACHE_PAGE_SIZE     256     ///< Must be power of 2
+#define MEM_CACHE_PAGE_COUNT    64      ///< Default count of cached pages
+
+/**
+\brief The statistics of memory cache
+*/
+struct mem_cache_stats
+{
+    unsigned int hits;          ///< Pages served from the cache
+    unsigned int misses;        ///< Pages read from the target
+    unsigned int invalidates;   ///< Times the whole cache was dropped
+    unsigned int bypasses;      ///< Reads which fall back to uncached access
+};
+
+/// definition for memory cache, see mem_cache.c
+struct mem_cache;
+
+/**
+  \brief        Create a memory cache for the target, it is disabled by default
+  \param[in]    tgt, the handle of target
+  \param[in]    pages, count of pages, zero for MEM_CACHE_PAGE_COUNT
+  \return       A handle for success, otherwise return NULL
+*/
+struct mem_cache *mem_cache_create (struct target *tgt, unsigned int pages);
+
+/**
+  \brief        Destroy the memory cache
+  \param[in]    mc, the handle of memory cache
+  \return       None
+*/
+void mem_cache_destroy (struct mem_cache *mc);
+
+/**
+  \brief        Enable or disable the memory cache, it will be invalidated either way
+  \param[in]    mc, the handle of memory cache
+  \param[in]    en, bool type, enable(1) or disable(0)
+  \return       None
+*/
+void mem_cache_enable (struct mem_cache *mc, int en);
+
+/**
+  \brief        Read memory through the cache, missed pages are filled with one
+                vectored read
+  \param[in]    mc, the handle of memory cache
+  \param[in]    addr, the memory address to be read
+  \param[out]   buff, an address which used to to save the memory data
+  \param[in]    size, size to be read
+  \return       zero for success, negative for error
+*/
+int mem_cache_read (struct mem_cache *mc, U64 addr, unsigned char *buff, unsigned int size);
+
+/**
+  \brief        Write memory to the target and update the cached pages (write-through)
+  \param[in]    mc, the handle of memory cache
+  \param[in]    addr, the memory address to be written
+  \param[in]    buff, the data which will be written to the target
+  \param[in]    size, size to be written
+  \return       zero for success, negative for error
+*/
+int mem_cache_write (struct mem_cache *mc, U64 addr, unsigned char *buff, unsigned int size);
+
+/**
+  \brief        Drop all cached pages, it must be called before the CPU runs
+  \param[in]    mc, the handle of memory cache
+  \return       None
+*/
+void mem_cache_invalidate (struct mem_cache *mc);
+
+/**
+  \brief        Get the statistics of memory cache
+  \param[in]    mc, the handle of memory cache
+  \param[out]   stats, save the statistics
+  \return       None
+*/
+void mem_cache_get_stats (struct mem_cache *mc, struct mem_cache_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_MEM_CACHE_H__
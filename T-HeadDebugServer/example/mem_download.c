@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "mem_download.h"
+#include "mem_access.h"
+#include "host_os.h"
+
+struct download_ctx
+{
+    download_fill_t fill;
+    void *priv;
+    unsigned char *buff[DOWNLOAD_BUFFER_COUNT];
+    int len[DOWNLOAD_BUFFER_COUNT];
+    semVar empty;               ///< Count of buffers the filler could use
+    semVar full;                ///< Count of buffers the writer could use
+    volatile int abort;
+};
+
+static void *
+download_filler (void *arg)
+{
+    struct download_ctx *ctx = arg;
+    U64 offset = 0;
+    int i, n;
+
+    for (i = 0; ; i = (i + 1) % DOWNLOAD_BUFFER_COUNT) {
+        host_sem_wait (&ctx->empty, -1);
+        n = ctx->abort ? 0 : ctx->fill (ctx->priv, offset, ctx->buff[i], DOWNLOAD_CHUNK_SIZE);
+        ctx->len[i] = n;
+        WAKEUP (ctx->full);
+        if (n <= 0) {
+            break;
+        }
+        offset += n;
+    }
+    return NULL;
+}
+
+static void
+download_begin (struct target *tgt, int ddc)
+{
+    enum target_continuous_mem_op_state op = TARGET_CONTINUOUS_MEM_OPERATION_START;
+
+    if (ddc) {
+        target_enable_ddc (tgt, 1);
+    }
+    target_config_target (tgt, TARGET_CONFIG_CONTINUOUS_MEM_OPERATION, &op);
+}
+
+static void
+download_end (struct target *tgt, int ddc, U64 start, struct download_stats *stats)
+{
+    enum target_continuous_mem_op_state op = TARGET_CONTINUOUS_MEM_OPERATION_END;
+
+    target_config_target (tgt, TARGET_CONFIG_CONTINUOUS_MEM_OPERATION, &op);
+    if (ddc) {
+        target_enable_ddc (tgt, 0);
+    }
+    stats->elapsed_us = host_time_us () - start;
+    if (stats->elapsed_us) {
+        stats->mbps = (double)stats->bytes / (double)stats->elapsed_us;
+    }
+}
+
+int
+mem_download (struct target *tgt, U64 addr, download_fill_t fill, void *priv,
+                 int ddc, struct download_stats *stats)
+{
+    struct download_ctx ctx;
+    struct download_stats st;
+    hostThread filler;
+    U64 start, wait;
+    int i, ret = 0;
+
+    if (tgt == NULL || fill == NULL) {
+        return -1;
+    }
+
+    memset (&ctx, 0, sizeof (ctx));
+    memset (&st, 0, sizeof (st));
+    ctx.fill = fill;
+    ctx.priv = priv;
+    for (i = 0; i < DOWNLOAD_BUFFER_COUNT; i++) {
+        ctx.buff[i] = malloc (DOWNLOAD_CHUNK_SIZE);
+        if (ctx.buff[i] == NULL) {
+            ret = -1;
+        }
+    }
+    if (ret < 0 || host_sem_init (&ctx.empty, DOWNLOAD_BUFFER_COUNT) < 0) {
+        for (i = 0; i < DOWNLOAD_BUFFER_COUNT; i++) {
+            free (ctx.buff[i]);
+        }
+        return -1;
+    }
+    if (host_sem_init (&ctx.full, 0) < 0) {
+        host_sem_destroy (&ctx.empty);
+        for (i = 0; i < DOWNLOAD_BUFFER_COUNT; i++) {
+            free (ctx.buff[i]);
+        }
+        return -1;
+    }
+
+    start = host_time_us ();
+    download_begin (tgt, ddc);
+
+    if (host_thread_create (&filler, download_filler, &ctx) < 0) {
+        ret = -1;
+    } else {
+        for (i = 0; ; i = (i + 1) % DOWNLOAD_BUFFER_COUNT) {
+            wait = host_time_us ();
+            host_sem_wait (&ctx.full, -1);
+            st.stall_us += host_time_us () - wait;
+            if (ctx.len[i] <= 0) {
+                ret = ctx.len[i];
+                break;
+            }
+            ret = mem_access_write (tgt, addr + st.bytes, ctx.buff[i], ctx.len[i]);
+            if (ret < 0) {
+                /* Let the filler see the abort and finish.  */
+                ctx.abort = 1;
+                WAKEUP (ctx.empty);
+                break;
+            }
+            st.chunks++;
+            st.bytes += ctx.len[i];
+            WAKEUP (ctx.empty);
+        }
+        host_thread_join (filler);
+    }
+
+    download_end (tgt, ddc, start, &st);
+    if (stats) {
+        *stats = st;
+    }
+
+    host_sem_destroy (&ctx.full);
+    host_sem_destroy (&ctx.empty);
+    for (i = 0; i < DOWNLOAD_BUFFER_COUNT; i++) {
+        free (ctx.buff[i]);
+    }
+    return ret < 0 ? ret : 0;
+}
+
+int
+mem_download_buffer (struct target *tgt, U64 addr, unsigned char *buff,
+                        unsigned int size, int ddc, struct download_stats *stats)
+{
+    struct download_stats st;
+    unsigned int len;
+    U64 start;
+    int ret = 0;
+
+    if (tgt == NULL || (buff == NULL && size != 0)) {
+        return -1;
+    }
+
+    /* The image is ready already, nothing to prepare ahead.  */
+    memset (&st, 0, sizeof (st));
+    start = host_time_us ();
+    download_begin (tgt, ddc);
+    while (st.bytes < size) {
+        len = size - (unsigned int)st.bytes;
+        if (len > DOWNLOAD_CHUNK_SIZE) {
+            len = DOWNLOAD_CHUNK_SIZE;
+        }
+        ret = mem_access_write (tgt, addr + st.bytes, buff + st.bytes, len);
+        if (ret < 0) {
+            break;
+        }
+        st.chunks++;
+        st.bytes += len;
+    }
+    download_end (tgt, ddc, start, &st);
+    if (stats) {
+        *stats = st;
+    }
+    return ret < 0 ? ret : 0;
+}
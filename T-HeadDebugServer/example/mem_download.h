@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: mem_download.h
+// function description: pipelined bulk download on top of target_write_memory.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_MEM_DOWNLOAD_H__
+#define __DEBUGGER_SERVER_EXAMPLE_MEM_DOWNLOAD_H__
+
+#include "dbg-target.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DOWNLOAD_CHUNK_SIZE     (64 * 1024)     ///< Size of one chunk
+#define DOWNLOAD_BUFFER_COUNT   2               ///< Chunks prepared ahead
+
+/**
+  \brief        Fill the next chunk of the image
+  \param[in]    priv, the private data passed to mem_download
+  \param[in]    offset, offset of the chunk in the image
+  \param[out]   buff, save the data
+  \param[in]    size, max size of the chunk
+  \return       bytes filled, zero for the end of image, negative for error
+*/
+typedef int (*download_fill_t) (void *priv, U64 offset, unsigned char *buff, unsigned int size);
+
+/**
+\brief The statistics of download
+*/
+struct download_stats
+{
+    U64 bytes;                  ///< Bytes written to the target
+    unsigned int chunks;        ///< Calls issued to target_write_memory
+    U64 elapsed_us;             ///< Wall time of the whole download
+    U64 stall_us;               ///< Time the writer waited for the filler
+    double mbps;                ///< Achieved MB/s
+};
+
+/**
+  \brief        Download an image to the target. The image is produced chunk by
+                chunk with fill in another thread, so chunk N+1 is prepared while
+                chunk N is written. The whole download is issued as one continuous
+                memory operation.
+  \param[in]    tgt, the handle of target
+  \param[in]    addr, the memory address to be written
+  \param[in]    fill, the producer of the image
+  \param[in]    priv, the private data for fill
+  \param[in]    ddc, bool type, download with DDC(1) or not(0)
+  \param[out]   stats, save the statistics, could be NULL
+  \return       zero for success, negative for error
+*/
+int mem_download (struct target *tgt, U64 addr, download_fill_t fill, void *priv,
+                     int ddc, struct download_stats *stats);
+
+/**
+  \brief        Download an image in memory to the target, see mem_download
+  \return       zero for success, negative for error
+*/
+int mem_download_buffer (struct target *tgt, U64 addr, unsigned char *buff,
+                            unsigned int size, int ddc, struct download_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_MEM_DOWNLOAD_H__
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "mem_iov.h"
+#include "mem_access.h"
+
+static struct mem_iov_stats iov_stats;
+
+static int
+mem_iov_compare (const void *a, const void *b)
+{
+    const struct mem_iov *ia = *(const struct mem_iov * const *)a;
+    const struct mem_iov *ib = *(const struct mem_iov * const *)b;
+
+    if (ia->addr < ib->addr)
+        return -1;
+    if (ia->addr > ib->addr)
+        return 1;
+    return 0;
+}
+
+/* Read [start, end) into BUFF and copy it out to the segments
+   SORTED[first, last].  */
+static int
+mem_iov_read_span (struct target *tgt, struct mem_iov const **sorted,
+                   int first, int last, U64 start, U64 end,
+                   unsigned char *buff)
+{
+    int i, ret;
+    unsigned int len = (unsigned int)(end - start);
+
+    /* Only one segment, no need to bounce.  */
+    if (first == last) {
+        buff = sorted[first]->buff;
+    }
+
+    ret = mem_access_read (tgt, start, buff, len);
+    iov_stats.transfers++;
+    iov_stats.bytes += len;
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (first != last) {
+        for (i = first; i <= last; i++) {
+            memcpy (sorted[i]->buff, buff + (sorted[i]->addr - start),
+                    sorted[i]->size);
+        }
+    }
+    return 0;
+}
+
+int
+target_read_memory_v (struct target *tgt, const struct mem_iov *iov, int count)
+{
+    struct mem_iov const **sorted;
+    enum target_continuous_mem_op_state op;
+    unsigned char *bounce;
+    U64 start, end, seg_end;
+    int first, i, n, ret = 0;
+
+    if (tgt == NULL || (iov == NULL && count != 0) || count < 0) {
+        return -1;
+    }
+
+    sorted = malloc (sizeof (*sorted) * (count ? count : 1));
+    bounce = malloc (MEM_IOV_MAX_SPAN);
+    if (sorted == NULL || bounce == NULL) {
+        free (sorted);
+        free (bounce);
+        return -1;
+    }
+
+    for (i = 0, n = 0; i < count; i++) {
+        if (iov[i].size == 0) {
+            continue;
+        }
+        sorted[n++] = &iov[i];
+    }
+    iov_stats.segments += n;
+    qsort (sorted, n, sizeof (*sorted), mem_iov_compare);
+
+    op = TARGET_CONTINUOUS_MEM_OPERATION_START;
+    target_config_target (tgt, TARGET_CONFIG_CONTINUOUS_MEM_OPERATION, &op);
+
+    first = 0;
+    while (first < n) {
+        start = sorted[first]->addr;
+        end = start + sorted[first]->size;
+
+        /* Grow the span while the next segment is adjacent, overlapping or
+           close enough, and the span still fits in the bounce buffer.  */
+        for (i = first + 1; i < n; i++) {
+            seg_end = sorted[i]->addr + sorted[i]->size;
+            if (sorted[i]->addr > end + MEM_IOV_MERGE_GAP) {
+                break;
+            }
+            if ((seg_end > end ? seg_end : end) - start > MEM_IOV_MAX_SPAN) {
+                break;
+            }
+            if (seg_end > end) {
+                end = seg_end;
+            }
+        }
+
+        ret = mem_iov_read_span (tgt, sorted, first, i - 1, start, end, bounce);
+        if (ret < 0) {
+            break;
+        }
+        first = i;
+    }
+
+    op = TARGET_CONTINUOUS_MEM_OPERATION_END;
+    target_config_target (tgt, TARGET_CONFIG_CONTINUOUS_MEM_OPERATION, &op);
+
+    free (sorted);
+    free (bounce);
+    return ret;
+}
+
+void
+mem_iov_get_stats (struct mem_iov_stats *stats, int reset)
+{
+    if (stats) {
+        *stats = iov_stats;
+    }
+    if (reset) {
+        memset (&iov_stats, 0, sizeof (iov_stats));
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: mem_iov.h
+// function description: scatter/gather memory access on top of the
+//                       target_read_memory interface.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_MEM_IOV_H__
+#define __DEBUGGER_SERVER_EXAMPLE_MEM_IOV_H__
+
+#include "dbg-target.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Segments closer than this are read as one span, the gap is discarded.  */
+#define MEM_IOV_MERGE_GAP   64
+
+/* The max length of one span issued to target_read_memory.  */
+#define MEM_IOV_MAX_SPAN    4096
+
+/**
+\brief The segment of scatter/gather memory access
+*/
+struct mem_iov
+{
+    U64 addr;                   ///< The memory address of the segment
+    unsigned char *buff;        ///< The buffer of the segment
+    unsigned int size;          ///< The size of the segment in bytes
+};
+
+/**
+\brief The statistics of scatter/gather memory access
+*/
+struct mem_iov_stats
+{
+    unsigned int segments;      ///< Segments requested by callers
+    unsigned int transfers;     ///< Calls issued to target_read_memory
+    unsigned int bytes;         ///< Bytes transferred, including merged gaps
+};
+
+/**
+  \brief        Read many memory segments with the least target_read_memory calls.
+                Segments are sorted, adjacent/overlapping ranges are coalesced and
+                the whole batch is issued as one continuous memory operation.
+  \param[in]    tgt, the handle of target
+  \param[in]    iov, the segments to be read, buffers are filled on return
+  \param[in]    count, the count of segments
+  \return       zero for success, negative for error
+*/
+int target_read_memory_v (struct target *tgt, const struct mem_iov *iov, int count);
+
+/**
+  \brief        Get the statistics of target_read_memory_v
+  \param[out]   stats, save the statistics
+  \param[in]    reset, clear the statistics after reading
+  \return       None
+*/
+void mem_iov_get_stats (struct mem_iov_stats *stats, int reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_MEM_IOV_H__
@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pc_profile.h"
+#include "host_os.h"
+
+/* One PC of the histogram, empty if count is zero.  */
+struct pc_slot
+{
+    U64 pc;
+    U64 count;
+};
+
+struct pc_profile
+{
+    struct elf_syms *syms;
+    hostMutex mutex;
+    struct pc_slot *slots;
+    unsigned int mask;
+    unsigned int used;
+    U64 samples;
+
+    FILE *out;
+    unsigned int interval_ms;
+    int top_n;
+    U64 last_export_us;
+    unsigned int exports;
+};
+
+static unsigned int
+pc_profile_hash (U64 pc)
+{
+    /* Instructions are at least 2 bytes aligned.  */
+    return (unsigned int)(((pc >> 1) * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+static struct pc_slot *
+pc_profile_slot (struct pc_slot *slots, unsigned int mask, U64 pc)
+{
+    unsigned int i = pc_profile_hash (pc) & mask;
+
+    while (slots[i].count != 0 && slots[i].pc != pc) {
+        i = (i + 1) & mask;
+    }
+    return &slots[i];
+}
+
+static int
+pc_profile_grow (struct pc_profile *pp)
+{
+    unsigned int size = (pp->mask + 1) * 2, i;
+    struct pc_slot *slots = calloc (size, sizeof (struct pc_slot));
+
+    if (slots == NULL) {
+        return -1;
+    }
+    for (i = 0; i <= pp->mask; i++) {
+        if (pp->slots[i].count != 0) {
+            *pc_profile_slot (slots, size - 1, pp->slots[i].pc) = pp->slots[i];
+        }
+    }
+    free (pp->slots);
+    pp->slots = slots;
+    pp->mask = size - 1;
+    return 0;
+}
+
+/* The mutex is held.  */
+static int
+pc_profile_add_locked (struct pc_profile *pp, U64 pc, U64 count)
+{
+    struct pc_slot *slot;
+
+    if (count == 0) {
+        return 0;
+    }
+    slot = pc_profile_slot (pp->slots, pp->mask, pc);
+    if (slot->count == 0) {
+        /* Keep the load under 70%.  */
+        if ((pp->used + 1) * 10 > (pp->mask + 1) * 7) {
+            if (pc_profile_grow (pp) < 0) {
+                return -1;
+            }
+            slot = pc_profile_slot (pp->slots, pp->mask, pc);
+        }
+        slot->pc = pc;
+        pp->used++;
+    }
+    slot->count += count;
+    pp->samples += count;
+    return 0;
+}
+
+struct pc_profile *
+pc_profile_create (struct elf_syms *syms)
+{
+    struct pc_profile *pp;
+
+    pp = calloc (1, sizeof (struct pc_profile));
+    if (pp == NULL) {
+        return NULL;
+    }
+    pp->syms = syms;
+    pp->mask = PC_PROFILE_MIN_SLOTS - 1;
+    pp->slots = calloc (PC_PROFILE_MIN_SLOTS, sizeof (struct pc_slot));
+    if (pp->slots == NULL) {
+        free (pp);
+        return NULL;
+    }
+    if (host_mutex_init (&pp->mutex) < 0) {
+        free (pp->slots);
+        free (pp);
+        return NULL;
+    }
+    return pp;
+}
+
+void
+pc_profile_destroy (struct pc_profile *pp)
+{
+    if (pp == NULL) {
+        return;
+    }
+    host_mutex_destroy (&pp->mutex);
+    free (pp->slots);
+    free (pp);
+}
+
+void
+pc_profile_set_export (struct pc_profile *pp, FILE *out, unsigned int interval_ms, int top_n)
+{
+    if (pp == NULL) {
+        return;
+    }
+    LOCK (&pp->mutex);
+    pp->out = out;
+    pp->interval_ms = interval_ms;
+    pp->top_n = top_n > 0 ? top_n : PC_PROFILE_TOP_N;
+    pp->last_export_us = host_time_us ();
+    UNLOCK (&pp->mutex);
+}
+
+int
+pc_profile_add (struct pc_profile *pp, U64 pc, U64 count)
+{
+    int ret;
+
+    if (pp == NULL) {
+        return -1;
+    }
+    LOCK (&pp->mutex);
+    ret = pc_profile_add_locked (pp, pc, count);
+    UNLOCK (&pp->mutex);
+    return ret;
+}
+
+void
+pc_profile_on_samples (void *priv, const struct pc_sample *samples, int count)
+{
+    struct pc_profile *pp = priv;
+    FILE *out = NULL;
+    int i, top_n = 0;
+
+    if (pp == NULL || samples == NULL) {
+        return;
+    }
+    LOCK (&pp->mutex);
+    for (i = 0; i < count; i++) {
+        pc_profile_add_locked (pp, samples[i].pc, 1);
+    }
+    if (pp->out) {
+        U64 now = host_time_us ();
+
+        if (now - pp->last_export_us >= (U64)pp->interval_ms * 1000) {
+            pp->last_export_us = now;
+            out = pp->out;
+            top_n = pp->top_n;
+        }
+    }
+    UNLOCK (&pp->mutex);
+
+    if (out) {
+        pc_profile_export (pp, out, top_n);
+    }
+}
+
+static int
+pc_profile_entry_compare (const void *a, const void *b)
+{
+    const struct pc_profile_entry *ea = a;
+    const struct pc_profile_entry *eb = b;
+
+    if (ea->count != eb->count) {
+        return ea->count > eb->count ? -1 : 1;
+    }
+    return ea->addr < eb->addr ? -1 : (ea->addr > eb->addr);
+}
+
+/* Sum the histogram by function, the last entry is for PCs in no
+   function.  Without symbols each PC is an entry.  The mutex is held.  */
+static struct pc_profile_entry *
+pc_profile_collect (struct pc_profile *pp, int *count)
+{
+    struct pc_profile_entry *all;
+    int nsyms = elf_syms_count (pp->syms), n = 0, i;
+    unsigned int s;
+
+    if (pp->syms) {
+        all = calloc (nsyms + 1, sizeof (struct pc_profile_entry));
+        if (all == NULL) {
+            return NULL;
+        }
+        for (s = 0; s <= pp->mask; s++) {
+            if (pp->slots[s].count != 0) {
+                i = elf_syms_find (pp->syms, pp->slots[s].pc);
+                all[i < 0 ? nsyms : i].count += pp->slots[s].count;
+            }
+        }
+        /* Pack the sampled ones.  */
+        for (i = 0; i <= nsyms; i++) {
+            if (all[i].count == 0) {
+                continue;
+            }
+            if (i < nsyms) {
+                const struct elf_sym *sym = elf_syms_get (pp->syms, i);
+
+                all[i].name = sym->name;
+                all[i].addr = sym->addr;
+            }
+            all[n++] = all[i];
+        }
+    } else {
+        all = calloc (pp->used + 1, sizeof (struct pc_profile_entry));
+        if (all == NULL) {
+            return NULL;
+        }
+        for (s = 0; s <= pp->mask; s++) {
+            if (pp->slots[s].count != 0) {
+                all[n].addr = pp->slots[s].pc;
+                all[n].count = pp->slots[s].count;
+                n++;
+            }
+        }
+    }
+    for (i = 0; i < n; i++) {
+        all[i].percent = all[i].count * 100.0 / pp->samples;
+    }
+    qsort (all, n, sizeof (struct pc_profile_entry), pc_profile_entry_compare);
+    *count = n;
+    return all;
+}
+
+int
+pc_profile_flat (struct pc_profile *pp, struct pc_profile_entry *entries, int max)
+{
+    struct pc_profile_entry *all;
+    int n = 0;
+
+    if (pp == NULL || (entries == NULL && max > 0) || max < 0) {
+        return -1;
+    }
+    LOCK (&pp->mutex);
+    all = pc_profile_collect (pp, &n);
+    UNLOCK (&pp->mutex);
+    if (all == NULL) {
+        return -1;
+    }
+    if (n > max) {
+        n = max;
+    }
+    memcpy (entries, all, sizeof (struct pc_profile_entry) * n);
+    free (all);
+    return n;
+}
+
+int
+pc_profile_export (struct pc_profile *pp, FILE *out, int top_n)
+{
+    struct pc_profile_entry *all;
+    U64 samples;
+    int n = 0, i;
+
+    if (pp == NULL || out == NULL) {
+        return -1;
+    }
+    if (top_n <= 0) {
+        top_n = PC_PROFILE_TOP_N;
+    }
+    LOCK (&pp->mutex);
+    all = pc_profile_collect (pp, &n);
+    samples = pp->samples;
+    pp->exports++;
+    UNLOCK (&pp->mutex);
+    if (all == NULL) {
+        return -1;
+    }
+
+    fprintf (out, "Flat profile, %llu samples:\n", (unsigned long long)samples);
+    fprintf (out, "  %%      samples  function\n");
+    for (i = 0; i < n && i < top_n; i++) {
+        if (all[i].name) {
+            fprintf (out, "%6.2f %10llu  %s\n", all[i].percent,
+                     (unsigned long long)all[i].count, all[i].name);
+        } else if (pp->syms) {
+            fprintf (out, "%6.2f %10llu  ??\n", all[i].percent,
+                     (unsigned long long)all[i].count);
+        } else {
+            fprintf (out, "%6.2f %10llu  0x%llx\n", all[i].percent,
+                     (unsigned long long)all[i].count, (unsigned long long)all[i].addr);
+        }
+    }
+    fprintf (out, "\n");
+    fflush (out);
+    free (all);
+    return 0;
+}
+
+void
+pc_profile_reset (struct pc_profile *pp)
+{
+    if (pp == NULL) {
+        return;
+    }
+    LOCK (&pp->mutex);
+    memset (pp->slots, 0, sizeof (struct pc_slot) * (pp->mask + 1));
+    pp->used = 0;
+    pp->samples = 0;
+    UNLOCK (&pp->mutex);
+}
+
+void
+pc_profile_get_stats (struct pc_profile *pp, struct pc_profile_stats *stats)
+{
+    if (pp == NULL || stats == NULL) {
+        return;
+    }
+    LOCK (&pp->mutex);
+    stats->samples = pp->samples;
+    stats->pcs = pp->used;
+    stats->slots = pp->mask + 1;
+    stats->exports = pp->exports;
+    UNLOCK (&pp->mutex);
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: pc_profile.h
+// function description: PC histogram of sampled PCs and the flat profile
+//                       by function, exported periodically.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_PC_PROFILE_H__
+#define __DEBUGGER_SERVER_EXAMPLE_PC_PROFILE_H__
+
+#include <stdio.h>
+#include "dbg-target.h"
+#include "elf_syms.h"
+#include "pc_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PC_PROFILE_MIN_SLOTS    1024    ///< Initial slots of the histogram, must be power of 2
+#define PC_PROFILE_TOP_N        20      ///< Functions exported by default
+
+/**
+\brief One entry of the flat profile
+*/
+struct pc_profile_entry
+{
+    const char *name;           ///< The function, NULL if the PC is in no function
+    U64 addr;                   ///< The start of function, or the PC if no symbols are given
+    U64 count;                  ///< Samples in the function
+    double percent;             ///< Percent of all samples
+};
+
+/**
+\brief The statistics of profile
+*/
+struct pc_profile_stats
+{
+    U64 samples;                ///< Samples added
+    unsigned int pcs;           ///< Different PCs in the histogram
+    unsigned int slots;         ///< Slots of the histogram
+    unsigned int exports;       ///< Flat profiles exported
+};
+
+/// definition for profile, see pc_profile.c
+struct pc_profile;
+
+/**
+  \brief        Create a profile
+  \param[in]    syms, the symbols to resolve PCs to functions, owned by the
+                caller. NULL for a flat profile by PC
+  \return       A handle for success, otherwise return NULL
+*/
+struct pc_profile *pc_profile_create (struct elf_syms *syms);
+
+/**
+  \brief        Destroy the profile
+  \param[in]    pp, the handle of profile
+  \return       None
+*/
+void pc_profile_destroy (struct pc_profile *pp);
+
+/**
+  \brief        Export the flat profile periodically while samples are added
+  \param[in]    pp, the handle of profile
+  \param[in]    out, where to export, NULL to stop exporting
+  \param[in]    interval_ms, the interval @ms
+  \param[in]    top_n, the count of functions, zero for PC_PROFILE_TOP_N
+  \return       None
+*/
+void pc_profile_set_export (struct pc_profile *pp, FILE *out, unsigned int interval_ms, int top_n);
+
+/**
+  \brief        Add samples of one PC
+  \param[in]    pp, the handle of profile
+  \param[in]    pc, the PC
+  \param[in]    count, the count of samples
+  \return       zero for success, negative for error
+*/
+int pc_profile_add (struct pc_profile *pp, U64 pc, U64 count);
+
+/**
+  \brief        Add samples from the PC stream, it is a pc_stream_cb_t,
+                pass the profile as priv of pc_stream_cfg
+  \param[in]    priv, the handle of profile
+  \param[in]    samples, the samples
+  \param[in]    count, the count of samples
+  \return       None
+*/
+void pc_profile_on_samples (void *priv, const struct pc_sample *samples, int count);
+
+/**
+  \brief        Get the flat profile, the most sampled functions first
+  \param[in]    pp, the handle of profile
+  \param[out]   entries, save the entries
+  \param[in]    max, the max count of entries
+  \return       The count of entries, negative for error
+*/
+int pc_profile_flat (struct pc_profile *pp, struct pc_profile_entry *entries, int max);
+
+/**
+  \brief        Print the flat profile as a table
+  \param[in]    pp, the handle of profile
+  \param[in]    out, where to print
+  \param[in]    top_n, the count of functions, zero for PC_PROFILE_TOP_N
+  \return       zero for success, negative for error
+*/
+int pc_profile_export (struct pc_profile *pp, FILE *out, int top_n);
+
+/**
+  \brief        Drop all samples
+  \param[in]    pp, the handle of profile
+  \return       None
+*/
+void pc_profile_reset (struct pc_profile *pp);
+
+/**
+  \brief        Get the statistics of profile
+  \param[in]    pp, the handle of profile
+  \param[out]   stats, save the statistics
+  \return       None
+*/
+void pc_profile_get_stats (struct pc_profile *pp, struct pc_profile_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_PC_PROFILE_H__
@@ -0,0 +1,395 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pc_stream.h"
+
+#define PC_STREAM_CLK_KHZ       12000
+#define PC_STREAM_WAIT_MIN_MS   1
+#define PC_STREAM_WAIT_MAX_MS   50
+
+struct pc_stream
+{
+    struct target *tgt;
+    hostMutex *lock;            ///< The lock of target access
+    struct pc_stream_cfg cfg;
+    unsigned int freq;
+    enum target_get_config_type config;     ///< PC or context ID sampling
+    int pc_words;               ///< Words of one PC in the dump, 1 or 2
+    int words;                  ///< Words of one sample in the dump
+
+    /* The ring, written by the reader and read by one consumer.  */
+    struct pc_sample *ring;
+    unsigned int mask;
+    volatile unsigned int head;
+    volatile unsigned int tail;
+
+    uint32_t *dump;
+    uint32_t dump_size;         ///< Words of dump
+
+    hostMutex mutex;            ///< Protects the statistics
+    struct pc_stream_stats stats;
+    semVar kick;                ///< Wakes the reader up to stop
+    semVar avail;               ///< Posted after each dump with samples
+    hostThread reader;
+    hostThread deliver;
+    volatile int stop;          ///< Stop the reader
+    int stopped;                ///< pc_stream_stop is done
+    volatile int done;          ///< The reader stopped, stop the delivery
+};
+
+static int
+pc_stream_command (struct pc_stream *ps, struct target_pc_sampling_arg *arg)
+{
+    int ret;
+
+    if (ps->lock) {
+        LOCK (ps->lock);
+    }
+    ret = target_get_target_config (ps->tgt, ps->config, arg);
+    if (ps->lock) {
+        UNLOCK (ps->lock);
+    }
+    return ret;
+}
+
+/* Move the dumped PCs into the ring.  The dump has no time, the PCs are
+   spaced by the sampling period back from now.  */
+static void
+pc_stream_push (struct pc_stream *ps, uint32_t count, U64 now)
+{
+    U64 period_us = 1000000 / ps->freq;
+    unsigned int head = ps->head;
+    unsigned int space = ps->mask + 1 - (head - ps->tail);
+    uint32_t i, n = count < space ? count : space;
+
+    for (i = 0; i < n; i++) {
+        struct pc_sample *s = &ps->ring[(head + i) & ps->mask];
+        const uint32_t *w = ps->dump + i * ps->words;
+
+        if (ps->words > ps->pc_words) {
+            s->contextid = *w++;
+        } else {
+            s->contextid = 0;
+        }
+        s->pc = ps->pc_words == 2 ? ((U64)w[1] << 32) | w[0] : w[0];
+        s->time_us = now - (U64)(count - 1 - i) * period_us;
+        s->cpu = ps->cfg.cpu;
+    }
+    HOST_MEMORY_BARRIER ();
+    ps->head = head + n;
+
+    LOCK (&ps->mutex);
+    ps->stats.samples += count;
+    ps->stats.dropped += count - n;
+    UNLOCK (&ps->mutex);
+}
+
+static int
+pc_stream_pop (struct pc_stream *ps, struct pc_sample *samples, int max)
+{
+    unsigned int tail = ps->tail;
+    unsigned int avail = ps->head - tail;
+    unsigned int i;
+
+    HOST_MEMORY_BARRIER ();
+    if (avail > (unsigned int)max) {
+        avail = max;
+    }
+    for (i = 0; i < avail; i++) {
+        samples[i] = ps->ring[(tail + i) & ps->mask];
+    }
+    HOST_MEMORY_BARRIER ();
+    ps->tail = tail + avail;
+    return avail;
+}
+
+static void *
+pc_stream_reader_thread (void *arg)
+{
+    struct pc_stream *ps = arg;
+    uint32_t capacity = ps->dump_size / ps->words;
+    unsigned int wait_ms;
+
+    /* Dump when the buffer of link is about half full.  */
+    wait_ms = (unsigned int)((U64)capacity * 1000 / 2 / ps->freq);
+    if (wait_ms < PC_STREAM_WAIT_MIN_MS) {
+        wait_ms = PC_STREAM_WAIT_MIN_MS;
+    } else if (wait_ms > PC_STREAM_WAIT_MAX_MS) {
+        wait_ms = PC_STREAM_WAIT_MAX_MS;
+    }
+
+    while (!ps->stop) {
+        struct target_pc_sampling_arg dump;
+        uint32_t count = 0;
+
+        memset (&dump, 0, sizeof (dump));
+        dump.cmd = PC_SAMPLING_DUMP;
+        dump.arg.dump_buff.buff_size = ps->dump_size;
+        dump.arg.dump_buff.pc_count = &count;
+        dump.arg.dump_buff.pc_buffer = ps->dump;
+        if (pc_stream_command (ps, &dump) >= 0) {
+            if (count > capacity) {
+                count = capacity;
+            }
+            LOCK (&ps->mutex);
+            ps->stats.dumps++;
+            if (count == capacity) {
+                ps->stats.link_full++;
+            }
+            UNLOCK (&ps->mutex);
+            if (count > 0) {
+                pc_stream_push (ps, count, host_time_us ());
+                if (ps->cfg.on_samples) {
+                    WAKEUP (ps->avail);
+                }
+            }
+        }
+        host_sem_wait (&ps->kick, wait_ms);
+    }
+    return NULL;
+}
+
+static void *
+pc_stream_deliver_thread (void *arg)
+{
+    struct pc_stream *ps = arg;
+    struct pc_sample samples[PC_STREAM_DELIVER_MAX];
+    int done, count;
+
+    for (;;) {
+        host_sem_wait (&ps->avail, PC_STREAM_WAIT_MAX_MS);
+        /* Samples pushed before done is set are drained below.  */
+        done = ps->done;
+        HOST_MEMORY_BARRIER ();
+        while ((count = pc_stream_pop (ps, samples, PC_STREAM_DELIVER_MAX)) > 0) {
+            ps->cfg.on_samples (ps->cfg.priv, samples, count);
+            LOCK (&ps->mutex);
+            ps->stats.delivered += count;
+            UNLOCK (&ps->mutex);
+        }
+        if (done) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+unsigned int
+pc_stream_max_freq (struct target *tgt, unsigned int clk_khz, enum pc_stream_mode mode)
+{
+    unsigned int cost, cost32;
+    int xlen = 0;
+
+    if (clk_khz == 0) {
+        clk_khz = PC_STREAM_CLK_KHZ;
+    }
+    if (tgt == NULL || target_get_target_config (tgt, TARGET_GET_XLEN, &xlen) < 0) {
+        xlen = 32;
+    }
+    /* The PCFIFO of the HAD on C-SKY, the DM on RISC-V.  */
+    if (tgt && target_get_debug_arch_type (tgt) == DEBUG_ARCH_CSKY) {
+        cost32 = HAD_READ_PCFIFO32_CLK;
+        cost = xlen == 64 ? HAD_READ_PCFIFO64_CLK : HAD_READ_PCFIFO32_CLK;
+    } else {
+        cost32 = DM_PCSAMPLING_32_CLK;
+        cost = xlen == 64 ? DM_PCSAMPLING_64_CLK : DM_PCSAMPLING_32_CLK;
+    }
+    if (mode == PC_STREAM_MODE_CONTEXTID) {
+        cost += cost32;
+    }
+    return (unsigned int)((U64)clk_khz * 1000 / cost);
+}
+
+static void
+pc_stream_free (struct pc_stream *ps)
+{
+    free (ps->dump);
+    free (ps->ring);
+    free (ps);
+}
+
+struct pc_stream *
+pc_stream_create (struct target *tgt, hostMutex *lock, const struct pc_stream_cfg *cfg)
+{
+    struct pc_stream *ps;
+    struct target_pc_sampling_arg arg;
+    unsigned int ring_size, max_freq;
+    uint32_t size = 0;
+    int xlen = 0;
+
+    if (tgt == NULL || cfg == NULL) {
+        return NULL;
+    }
+    ring_size = cfg->ring_size ? cfg->ring_size : PC_STREAM_RING_SIZE;
+    if (ring_size & (ring_size - 1)) {
+        return NULL;
+    }
+    ps = calloc (1, sizeof (struct pc_stream));
+    if (ps == NULL) {
+        return NULL;
+    }
+    ps->tgt = tgt;
+    ps->lock = lock;
+    ps->cfg = *cfg;
+    ps->mask = ring_size - 1;
+    if (target_get_target_config (tgt, TARGET_GET_XLEN, &xlen) < 0) {
+        xlen = 32;
+    }
+    ps->config = cfg->mode == PC_STREAM_MODE_CONTEXTID ? TARGET_GET_CONTEXTID_SAMPLING
+                                                       : TARGET_GET_PC_SAMPLING;
+    ps->pc_words = xlen == 64 ? 2 : 1;
+    ps->words = ps->pc_words + (cfg->mode == PC_STREAM_MODE_CONTEXTID);
+    max_freq = pc_stream_max_freq (tgt, cfg->clk_khz, cfg->mode);
+    ps->freq = cfg->freq == 0 || cfg->freq > max_freq ? max_freq : cfg->freq;
+    if (ps->freq == 0) {
+        ps->freq = 1;
+    }
+
+    memset (&arg, 0, sizeof (arg));
+    arg.cmd = PC_SAMPLING_INFO;
+    arg.arg.buffer_size = &size;
+    ps->dump_size = pc_stream_command (ps, &arg) >= 0 && size > 0 ? size : PC_STREAM_DUMP_SIZE;
+    if (ps->dump_size < (uint32_t)ps->words) {
+        ps->dump_size = ps->words;
+    }
+
+    ps->ring = malloc (sizeof (struct pc_sample) * ring_size);
+    ps->dump = malloc (sizeof (uint32_t) * ps->dump_size);
+    if (ps->ring == NULL || ps->dump == NULL) {
+        pc_stream_free (ps);
+        return NULL;
+    }
+
+    memset (&arg, 0, sizeof (arg));
+    arg.cmd = PC_SAMPLING_SETUP;
+    arg.arg.setup_info.cpu = cfg->cpu;
+    arg.arg.setup_info.freq = ps->freq;
+    if (pc_stream_command (ps, &arg) < 0) {
+        pc_stream_free (ps);
+        return NULL;
+    }
+    memset (&arg, 0, sizeof (arg));
+    arg.cmd = PC_SAMPLING_START;
+    if (pc_stream_command (ps, &arg) < 0) {
+        pc_stream_free (ps);
+        return NULL;
+    }
+
+    if (host_mutex_init (&ps->mutex) < 0) {
+        goto stop;
+    }
+    if (host_sem_init (&ps->kick, 0) < 0) {
+        goto destroy_mutex;
+    }
+    if (host_sem_init (&ps->avail, 0) < 0) {
+        goto destroy_kick;
+    }
+    if (host_thread_create (&ps->reader, pc_stream_reader_thread, ps) < 0) {
+        goto destroy_avail;
+    }
+    if (cfg->on_samples
+        && host_thread_create (&ps->deliver, pc_stream_deliver_thread, ps) < 0) {
+        ps->stop = 1;
+        WAKEUP (ps->kick);
+        host_thread_join (ps->reader);
+        goto destroy_avail;
+    }
+    return ps;
+
+destroy_avail:
+    host_sem_destroy (&ps->avail);
+destroy_kick:
+    host_sem_destroy (&ps->kick);
+destroy_mutex:
+    host_mutex_destroy (&ps->mutex);
+stop:
+    memset (&arg, 0, sizeof (arg));
+    arg.cmd = PC_SAMPLING_STOP;
+    pc_stream_command (ps, &arg);
+    pc_stream_free (ps);
+    return NULL;
+}
+
+void
+pc_stream_stop (struct pc_stream *ps)
+{
+    struct target_pc_sampling_arg arg;
+
+    if (ps == NULL || ps->stopped) {
+        return;
+    }
+    ps->stop = 1;
+    WAKEUP (ps->kick);
+    host_thread_join (ps->reader);
+
+    memset (&arg, 0, sizeof (arg));
+    arg.cmd = PC_SAMPLING_STOP;
+    pc_stream_command (ps, &arg);
+
+    if (ps->cfg.on_samples) {
+        ps->done = 1;
+        WAKEUP (ps->avail);
+        host_thread_join (ps->deliver);
+    }
+    ps->stopped = 1;
+}
+
+void
+pc_stream_destroy (struct pc_stream *ps)
+{
+    if (ps == NULL) {
+        return;
+    }
+    pc_stream_stop (ps);
+    host_sem_destroy (&ps->avail);
+    host_sem_destroy (&ps->kick);
+    host_mutex_destroy (&ps->mutex);
+    pc_stream_free (ps);
+}
+
+int
+pc_stream_read (struct pc_stream *ps, struct pc_sample *samples, int max)
+{
+    int count;
+
+    if (ps == NULL || samples == NULL || max < 0 || ps->cfg.on_samples) {
+        return -1;
+    }
+    count = pc_stream_pop (ps, samples, max);
+    LOCK (&ps->mutex);
+    ps->stats.delivered += count;
+    UNLOCK (&ps->mutex);
+    return count;
+}
+
+unsigned int
+pc_stream_get_freq (struct pc_stream *ps)
+{
+    return ps ? ps->freq : 0;
+}
+
+void
+pc_stream_get_stats (struct pc_stream *ps, struct pc_stream_stats *stats)
+{
+    if (ps == NULL || stats == NULL) {
+        return;
+    }
+    LOCK (&ps->mutex);
+    *stats = ps->stats;
+    UNLOCK (&ps->mutex);
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: pc_stream.h
+// function description: continuous PC sampling, with context IDs or not. A
+//                       reader thread dumps the PC buffer of the link into
+//                       a ring buffer, samples are read by the caller or
+//                       delivered to a callback.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_PC_STREAM_H__
+#define __DEBUGGER_SERVER_EXAMPLE_PC_STREAM_H__
+
+#include "dbg-target.h"
+#include "host_os.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PC_STREAM_RING_SIZE     (1 << 16)   ///< Default samples in the ring, must be power of 2
+#define PC_STREAM_DUMP_SIZE     4096        ///< Words dumped once if the link does not tell
+#define PC_STREAM_DELIVER_MAX   256         ///< Samples passed to the callback once
+
+/*----- The mode of PC stream -----*/
+enum pc_stream_mode
+{
+	PC_STREAM_MODE_PC = 0,      ///<TARGET_GET_PC_SAMPLING, PCs only
+	PC_STREAM_MODE_CONTEXTID,   ///<TARGET_GET_CONTEXTID_SAMPLING, a context ID word before each PC
+};
+
+/**
+\brief One PC sample
+*/
+struct pc_sample
+{
+    U64 pc;                     ///< The PC
+    U64 time_us;                ///< An estimate of the host time, see host_time_us. A dump
+                                ///< only has the time it is read, the samples in it are
+                                ///< spread back by the sampling period
+    int cpu;                    ///< The cpu sampled
+    U32 contextid;              ///< The context ID, such as ASID or PID. Zero for PC_STREAM_MODE_PC
+};
+
+/**
+  \brief        The consumer callback, called from the delivery thread
+  \param[in]    priv, the private data given in pc_stream_cfg
+  \param[in]    samples, the samples in time order
+  \param[in]    count, the count of samples
+  \return       None
+*/
+typedef void (*pc_stream_cb_t) (void *priv, const struct pc_sample *samples, int count);
+
+/**
+\brief The config of PC stream
+*/
+struct pc_stream_cfg
+{
+    enum pc_stream_mode mode;   ///< The mode, the target must support its sampling feature
+    int cpu;                    ///< The cpu sampled
+    unsigned int freq;          ///< Sampling frequence @Hz, limited by pc_stream_max_freq
+    unsigned int clk_khz;       ///< The JTAG clock @KHz, such as ice_clk of link_cfg, zero for 12000
+    unsigned int ring_size;     ///< Samples in the ring, power of 2, zero for PC_STREAM_RING_SIZE
+    pc_stream_cb_t on_samples;  ///< The consumer callback, NULL to read by pc_stream_read
+    void *priv;                 ///< The private data of on_samples
+};
+
+/**
+\brief The statistics of PC stream
+*/
+struct pc_stream_stats
+{
+    unsigned int dumps;         ///< Dumps from the link
+    U64 samples;                ///< Samples dumped
+    U64 dropped;                ///< Samples dropped since the ring is full
+    unsigned int link_full;     ///< Dumps filling the whole buffer, the link may lose samples
+    U64 delivered;              ///< Samples read or delivered to the callback
+};
+
+/// definition for PC stream, see pc_stream.c
+struct pc_stream;
+
+/**
+  \brief        Get the max sampling frequence the link could do, each PC
+                costs DM_PCSAMPLING_32_CLK or DM_PCSAMPLING_64_CLK clocks on
+                RISC-V, HAD_READ_PCFIFO32_CLK or HAD_READ_PCFIFO64_CLK on C-SKY,
+                the context ID costs the 32-bit one more
+  \param[in]    tgt, the handle of target
+  \param[in]    clk_khz, the JTAG clock @KHz, zero for 12000
+  \param[in]    mode, the mode of PC stream
+  \return       The frequence @Hz
+*/
+unsigned int pc_stream_max_freq (struct target *tgt, unsigned int clk_khz,
+                                 enum pc_stream_mode mode);
+
+/**
+  \brief        Setup and start PC sampling, start the reader thread and the
+                delivery thread if on_samples is set
+  \param[in]    tgt, the handle of target
+  \param[in]    lock, held by the reader while accessing the target, such as
+                the lock of session. NULL for no lock
+  \param[in]    cfg, the config of PC stream
+  \return       A handle for success, otherwise return NULL
+*/
+struct pc_stream *pc_stream_create (struct target *tgt, hostMutex *lock,
+                                    const struct pc_stream_cfg *cfg);
+
+/**
+  \brief        Stop PC sampling, the samples left are delivered to on_samples.
+                The statistics are final after it
+  \param[in]    ps, the handle of PC stream
+  \return       None
+*/
+void pc_stream_stop (struct pc_stream *ps);
+
+/**
+  \brief        Stop PC sampling if it is not stopped, and free the stream
+  \param[in]    ps, the handle of PC stream
+  \return       None
+*/
+void pc_stream_destroy (struct pc_stream *ps);
+
+/**
+  \brief        Read samples from the ring, only one thread could read. Not
+                available if on_samples is set
+  \param[in]    ps, the handle of PC stream
+  \param[out]   samples, save the samples
+  \param[in]    max, the max count of samples
+  \return       The count of samples read, negative for error
+*/
+int pc_stream_read (struct pc_stream *ps, struct pc_sample *samples, int max);
+
+/**
+  \brief        Get the sampling frequence after the limit
+  \param[in]    ps, the handle of PC stream
+  \return       The frequence @Hz
+*/
+unsigned int pc_stream_get_freq (struct pc_stream *ps);
+
+/**
+  \brief        Get the statistics of PC stream
+  \param[in]    ps, the handle of PC stream
+  \param[out]   stats, save the statistics
+  \return       None
+*/
+void pc_stream_get_stats (struct pc_stream *ps, struct pc_stream_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_PC_STREAM_H__
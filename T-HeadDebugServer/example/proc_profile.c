@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "proc_profile.h"
+#include "host_os.h"
+
+struct proc_entry
+{
+    struct proc_profile_info info;
+    struct elf_syms *syms;
+    struct pc_profile *profile;     ///< Created with the first sample
+    struct proc_entry *next;
+};
+
+struct proc_profile
+{
+    struct elf_syms *syms;
+    hostMutex mutex;
+    struct proc_entry *buckets[PROC_PROFILE_BUCKETS];
+    struct proc_entry *last;        ///< The process of the last sample
+    unsigned int processes;
+    U64 samples;
+};
+
+static unsigned int
+proc_profile_hash (U32 contextid)
+{
+    return (contextid * 0x9E3779B1u) >> 16;
+}
+
+/* The mutex is held.  */
+static struct proc_entry *
+proc_profile_lookup (struct proc_profile *pp, U32 contextid, int create)
+{
+    unsigned int b = proc_profile_hash (contextid) & (PROC_PROFILE_BUCKETS - 1);
+    struct proc_entry *e;
+
+    for (e = pp->buckets[b]; e; e = e->next) {
+        if (e->info.contextid == contextid) {
+            return e;
+        }
+    }
+    if (!create) {
+        return NULL;
+    }
+    e = calloc (1, sizeof (struct proc_entry));
+    if (e == NULL) {
+        return NULL;
+    }
+    e->info.contextid = contextid;
+    e->next = pp->buckets[b];
+    pp->buckets[b] = e;
+    pp->processes++;
+    return e;
+}
+
+struct proc_profile *
+proc_profile_create (struct elf_syms *syms)
+{
+    struct proc_profile *pp;
+
+    pp = calloc (1, sizeof (struct proc_profile));
+    if (pp == NULL) {
+        return NULL;
+    }
+    pp->syms = syms;
+    if (host_mutex_init (&pp->mutex) < 0) {
+        free (pp);
+        return NULL;
+    }
+    return pp;
+}
+
+void
+proc_profile_destroy (struct proc_profile *pp)
+{
+    int b;
+
+    if (pp == NULL) {
+        return;
+    }
+    for (b = 0; b < PROC_PROFILE_BUCKETS; b++) {
+        while (pp->buckets[b]) {
+            struct proc_entry *e = pp->buckets[b];
+
+            pp->buckets[b] = e->next;
+            pc_profile_destroy (e->profile);
+            free (e);
+        }
+    }
+    host_mutex_destroy (&pp->mutex);
+    free (pp);
+}
+
+int
+proc_profile_set_process (struct proc_profile *pp, U32 contextid,
+                          const char *name, struct elf_syms *syms)
+{
+    struct proc_entry *e;
+    int ret = 0;
+
+    if (pp == NULL) {
+        return -1;
+    }
+    LOCK (&pp->mutex);
+    e = proc_profile_lookup (pp, contextid, 1);
+    if (e == NULL) {
+        ret = -1;
+    } else if (e->profile && syms != e->syms) {
+        /* The samples are resolved by the old symbols.  */
+        ret = -1;
+    } else {
+        e->syms = syms;
+        if (name) {
+            strncpy (e->info.name, name, PROC_PROFILE_NAME_LEN - 1);
+            e->info.name[PROC_PROFILE_NAME_LEN - 1] = '\0';
+        } else {
+            e->info.name[0] = '\0';
+        }
+    }
+    UNLOCK (&pp->mutex);
+    return ret;
+}
+
+void
+proc_profile_on_samples (void *priv, const struct pc_sample *samples, int count)
+{
+    struct proc_profile *pp = priv;
+    struct proc_entry *e;
+    int i;
+
+    if (pp == NULL || samples == NULL) {
+        return;
+    }
+    LOCK (&pp->mutex);
+    for (i = 0; i < count; i++) {
+        e = pp->last;
+        if (e == NULL || e->info.contextid != samples[i].contextid) {
+            e = proc_profile_lookup (pp, samples[i].contextid, 1);
+            if (e == NULL) {
+                continue;
+            }
+            pp->last = e;
+        }
+        if (e->profile == NULL) {
+            e->profile = pc_profile_create (e->syms ? e->syms : pp->syms);
+            if (e->profile == NULL) {
+                continue;
+            }
+        }
+        if (pc_profile_add (e->profile, samples[i].pc, 1) < 0) {
+            continue;
+        }
+        e->info.samples++;
+        if (samples[i].cpu >= 0 && samples[i].cpu < MAX_CPU_COUNT) {
+            e->info.cpu_samples[samples[i].cpu]++;
+        }
+        pp->samples++;
+    }
+    UNLOCK (&pp->mutex);
+}
+
+struct pc_profile *
+proc_profile_get (struct proc_profile *pp, U32 contextid)
+{
+    struct proc_entry *e;
+
+    if (pp == NULL) {
+        return NULL;
+    }
+    LOCK (&pp->mutex);
+    e = proc_profile_lookup (pp, contextid, 0);
+    UNLOCK (&pp->mutex);
+    return e ? e->profile : NULL;
+}
+
+static int
+proc_profile_info_compare (const void *a, const void *b)
+{
+    const struct proc_profile_info *ia = a;
+    const struct proc_profile_info *ib = b;
+
+    if (ia->samples != ib->samples) {
+        return ia->samples > ib->samples ? -1 : 1;
+    }
+    return ia->contextid < ib->contextid ? -1 : (ia->contextid > ib->contextid);
+}
+
+/* All processes, the most sampled first.  */
+static struct proc_profile_info *
+proc_profile_collect (struct proc_profile *pp, int *count)
+{
+    struct proc_profile_info *all;
+    struct proc_entry *e;
+    int b, n = 0;
+
+    LOCK (&pp->mutex);
+    all = malloc (sizeof (struct proc_profile_info) * (pp->processes + 1));
+    if (all) {
+        for (b = 0; b < PROC_PROFILE_BUCKETS; b++) {
+            for (e = pp->buckets[b]; e; e = e->next) {
+                all[n++] = e->info;
+            }
+        }
+    }
+    UNLOCK (&pp->mutex);
+    if (all) {
+        qsort (all, n, sizeof (struct proc_profile_info), proc_profile_info_compare);
+    }
+    *count = n;
+    return all;
+}
+
+int
+proc_profile_list (struct proc_profile *pp, struct proc_profile_info *infos, int max)
+{
+    struct proc_profile_info *all;
+    int n;
+
+    if (pp == NULL || (infos == NULL && max > 0) || max < 0) {
+        return -1;
+    }
+    all = proc_profile_collect (pp, &n);
+    if (all == NULL) {
+        return -1;
+    }
+    if (n > max) {
+        n = max;
+    }
+    memcpy (infos, all, sizeof (struct proc_profile_info) * n);
+    free (all);
+    return n;
+}
+
+int
+proc_profile_export (struct proc_profile *pp, FILE *out, int top_n)
+{
+    struct proc_profile_info *all;
+    U64 samples;
+    int n, i;
+
+    if (pp == NULL || out == NULL) {
+        return -1;
+    }
+    all = proc_profile_collect (pp, &n);
+    if (all == NULL) {
+        return -1;
+    }
+    LOCK (&pp->mutex);
+    samples = pp->samples;
+    UNLOCK (&pp->mutex);
+
+    for (i = 0; i < n; i++) {
+        struct pc_profile *profile = proc_profile_get (pp, all[i].contextid);
+
+        if (profile == NULL) {
+            continue;
+        }
+        fprintf (out, "Process %s context ID 0x%x, %.2f%% of all:\n",
+                 all[i].name[0] ? all[i].name : "-", all[i].contextid,
+                 samples ? all[i].samples * 100.0 / samples : 0.0);
+        pc_profile_export (profile, out, top_n);
+    }
+    free (all);
+    return 0;
+}
+
+void
+proc_profile_get_stats (struct proc_profile *pp, struct proc_profile_stats *stats)
+{
+    if (pp == NULL || stats == NULL) {
+        return;
+    }
+    LOCK (&pp->mutex);
+    stats->samples = pp->samples;
+    stats->processes = pp->processes;
+    UNLOCK (&pp->mutex);
+}
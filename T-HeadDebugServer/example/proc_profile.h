@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: proc_profile.h
+// function description: per-process profiles from (cpu, context ID, PC)
+//                       samples, one pc_profile for each context ID.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_PROC_PROFILE_H__
+#define __DEBUGGER_SERVER_EXAMPLE_PROC_PROFILE_H__
+
+#include <stdio.h>
+#include "dbg-target.h"
+#include "pc_profile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PROC_PROFILE_BUCKETS    64      ///< Buckets of the process table, must be power of 2
+#define PROC_PROFILE_NAME_LEN   32      ///< Max length of process name
+
+/**
+\brief The information of one process
+*/
+struct proc_profile_info
+{
+    U32 contextid;              ///< The context ID
+    char name[PROC_PROFILE_NAME_LEN];   ///< The name, empty if not set
+    U64 samples;                ///< Samples of the process
+    U64 cpu_samples[MAX_CPU_COUNT];     ///< Samples of the process by cpu
+};
+
+/**
+\brief The statistics of per-process profiles
+*/
+struct proc_profile_stats
+{
+    U64 samples;                ///< Samples added
+    unsigned int processes;     ///< Different context IDs
+};
+
+/// definition for per-process profiles, see proc_profile.c
+struct proc_profile;
+
+/**
+  \brief        Create per-process profiles
+  \param[in]    syms, the symbols for processes not given by proc_profile_set_process,
+                owned by the caller. NULL to profile by PC
+  \return       A handle for success, otherwise return NULL
+*/
+struct proc_profile *proc_profile_create (struct elf_syms *syms);
+
+/**
+  \brief        Destroy the per-process profiles
+  \param[in]    pp, the handle of per-process profiles
+  \return       None
+*/
+void proc_profile_destroy (struct proc_profile *pp);
+
+/**
+  \brief        Name the process of a context ID and give its symbols, such as
+                the ELF of a daemon. It must be called before the first
+                sample of the process
+  \param[in]    pp, the handle of per-process profiles
+  \param[in]    contextid, the context ID
+  \param[in]    name, the name of process, NULL for none
+  \param[in]    syms, the symbols of process, owned by the caller. NULL for
+                the symbols given in proc_profile_create
+  \return       zero for success, negative for error
+*/
+int proc_profile_set_process (struct proc_profile *pp, U32 contextid,
+                              const char *name, struct elf_syms *syms);
+
+/**
+  \brief        Add samples from the PC stream in PC_STREAM_MODE_CONTEXTID,
+                it is a pc_stream_cb_t, pass the handle as priv of pc_stream_cfg
+  \param[in]    priv, the handle of per-process profiles
+  \param[in]    samples, the samples
+  \param[in]    count, the count of samples
+  \return       None
+*/
+void proc_profile_on_samples (void *priv, const struct pc_sample *samples, int count);
+
+/**
+  \brief        Get the profile of a process
+  \param[in]    pp, the handle of per-process profiles
+  \param[in]    contextid, the context ID
+  \return       The profile, NULL if no sample of the process
+*/
+struct pc_profile *proc_profile_get (struct proc_profile *pp, U32 contextid);
+
+/**
+  \brief        Get the processes, the most sampled first
+  \param[in]    pp, the handle of per-process profiles
+  \param[out]   infos, save the informations
+  \param[in]    max, the max count of processes
+  \return       The count of processes, negative for error
+*/
+int proc_profile_list (struct proc_profile *pp, struct proc_profile_info *infos, int max);
+
+/**
+  \brief        Print the flat profile of each process, the most sampled first
+  \param[in]    pp, the handle of per-process profiles
+  \param[in]    out, where to print
+  \param[in]    top_n, the count of functions of each process, zero for PC_PROFILE_TOP_N
+  \return       zero for success, negative for error
+*/
+int proc_profile_export (struct proc_profile *pp, FILE *out, int top_n);
+
+/**
+  \brief        Get the statistics of per-process profiles
+  \param[in]    pp, the handle of per-process profiles
+  \param[out]   stats, save the statistics
+  \return       None
+*/
+void proc_profile_get_stats (struct proc_profile *pp, struct proc_profile_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_PROC_PROFILE_H__
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "reg_batch.h"
+#include "rv_dm.h"
+#include "rv_gdb_regs.h"
+
+#define REG_BATCH_RUN_MIN   2       ///< Min count of registers in a run
+#define REG_BATCH_RUN_MAX   32      ///< Max count of registers in a run
+
+static struct reg_batch_stats batch_stats;
+
+/* Abstract commands of a RISC-V target.  */
+struct reg_batch_rv
+{
+    struct rv_dm dm;
+    int size64;                 ///< Access with aarsize 64-bit or not
+    struct reg *list;           ///< The register list, owned by the target
+    int list_count;
+};
+
+struct reg_batch_key
+{
+    int num;
+    int index;                  ///< Index in the caller's array
+};
+
+static int
+reg_batch_compare (const void *a, const void *b)
+{
+    const struct reg_batch_key *ka = a;
+    const struct reg_batch_key *kb = b;
+
+    if (ka->num != kb->num)
+        return ka->num < kb->num ? -1 : 1;
+    return ka->index < kb->index ? -1 : (ka->index > kb->index);
+}
+
+/* Sort the registers by number, so the same registers are adjacent.
+   The type is an output of target_read_cpu_reg, it is not a key.  */
+static struct reg_batch_key *
+reg_batch_sort (struct reg const *regs, int count)
+{
+    struct reg_batch_key *keys;
+    int i;
+
+    keys = malloc (sizeof (struct reg_batch_key) * (count ? count : 1));
+    if (keys == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < count; i++) {
+        keys[i].num = regs[i].num;
+        keys[i].index = i;
+    }
+    qsort (keys, count, sizeof (struct reg_batch_key), reg_batch_compare);
+    batch_stats.requested += count;
+    return keys;
+}
+
+static int
+reg_batch_rv_init (struct reg_batch_rv *rv, struct target *tgt)
+{
+    int xlen = 0;
+
+    if (rv_dm_init (&rv->dm, tgt) < 0
+        || target_get_register_list (tgt, &rv->list, &rv->list_count) < 0
+        || rv->list == NULL) {
+        return -1;
+    }
+    if (target_get_target_config (tgt, TARGET_GET_XLEN, &xlen) < 0) {
+        xlen = 32;
+    }
+    /* FPRs are accessed with the width of XLEN too, the run falls back
+       to target_read_cpu_reg if the hart rejects it.  */
+    rv->size64 = xlen == 64;
+    return 0;
+}
+
+/* The regno of Access Register, -1 if the register is not a GPR or FPR.  */
+static int
+reg_batch_rv_regno (int num)
+{
+    if (num >= RV_GDB_REGNO_ZERO && num <= RV_GDB_REGNO_XPR31) {
+        return RV_DM_REGNO_GPR (num - RV_GDB_REGNO_ZERO);
+    }
+    if (num >= RV_GDB_REGNO_FPR0 && num <= RV_GDB_REGNO_FPR31) {
+        return RV_DM_REGNO_FPR (num - RV_GDB_REGNO_FPR0);
+    }
+    return -1;
+}
+
+static struct reg *
+reg_batch_rv_template (struct reg_batch_rv *rv, int num)
+{
+    int i;
+
+    for (i = 0; i < rv->list_count; i++) {
+        if (rv->list[i].num == num) {
+            return &rv->list[i];
+        }
+    }
+    return NULL;
+}
+
+/* Access the run of consecutive GPRs or FPRs from KEYS[FIRST] with one
+   Access Register command, the values are read into OUT, or written from
+   REGS if OUT is NULL. Return the index after the run, FIRST if there is
+   no run, or negative for error.  */
+static int
+reg_batch_rv_run (struct reg_batch_rv *rv, struct reg const *regs, struct reg *out,
+                  const struct reg_batch_key *keys, int first, int count)
+{
+    U64 values[REG_BATCH_RUN_MAX];
+    int ends[REG_BATCH_RUN_MAX];
+    int regno = reg_batch_rv_regno (keys[first].num);
+    int i = first, j, k, n = 0;
+
+    if (regno < 0) {
+        return first;
+    }
+    while (i < count && n < REG_BATCH_RUN_MAX
+           && keys[i].num == keys[first].num + n
+           && reg_batch_rv_regno (keys[i].num) == regno + n) {
+        for (j = i + 1; j < count && keys[j].num == keys[i].num; j++)
+            ;
+        /* The last one in the caller's array wins.  */
+        values[n] = rv->size64 ? regs[keys[j - 1].index].value.val64
+                               : regs[keys[j - 1].index].value.val32;
+        ends[n++] = j;
+        i = j;
+    }
+    if (n < REG_BATCH_RUN_MIN) {
+        return first;
+    }
+    if (rv_dm_access_regs (&rv->dm, regno, rv->size64, values, n, out == NULL) < 0) {
+        return -1;
+    }
+
+    batch_stats.runs++;
+    batch_stats.run_regs += n;
+    if (out == NULL) {
+        return i;
+    }
+    for (k = 0, j = first; k < n; k++) {
+        struct reg *tmpl = reg_batch_rv_template (rv, keys[j].num);
+
+        for (; j < ends[k]; j++) {
+            struct reg *r = &out[keys[j].index];
+
+            if (tmpl) {
+                memcpy (r->name, tmpl->name, sizeof (r->name));
+                r->type = tmpl->type;
+                r->length = tmpl->length;
+            }
+            memset (&r->value, 0, sizeof (r->value));
+            r->value.val64 = values[k];
+        }
+    }
+    return i;
+}
+
+int
+reg_batch_read (struct target *tgt, struct reg *regs, int count)
+{
+    struct reg_batch_key *keys;
+    struct reg_batch_rv rv;
+    int first, i, failed = 0, use_rv;
+
+    if (tgt == NULL || (regs == NULL && count != 0) || count < 0) {
+        return -1;
+    }
+    keys = reg_batch_sort (regs, count);
+    if (keys == NULL) {
+        return -1;
+    }
+    use_rv = count >= REG_BATCH_RUN_MIN && reg_batch_rv_init (&rv, tgt) == 0;
+
+    for (first = 0; first < count; first = i) {
+        struct reg *leader = &regs[keys[first].index];
+
+        if (use_rv) {
+            i = reg_batch_rv_run (&rv, regs, regs, keys, first, count);
+            if (i > first) {
+                continue;
+            }
+            /* The hart rejects abstract commands, never try again.  */
+            use_rv = i == first;
+        }
+        batch_stats.accessed++;
+        if (target_read_cpu_reg (tgt, leader) < 0) {
+            failed++;
+        }
+        for (i = first + 1; i < count && keys[i].num == keys[first].num; i++) {
+            regs[keys[i].index].length = leader->length;
+            regs[keys[i].index].value = leader->value;
+        }
+    }
+
+    free (keys);
+    return -failed;
+}
+
+int
+reg_batch_write (struct target *tgt, struct reg const *regs, int count)
+{
+    struct reg_batch_key *keys;
+    struct reg_batch_rv rv;
+    int first, i, failed = 0, use_rv;
+
+    if (tgt == NULL || (regs == NULL && count != 0) || count < 0) {
+        return -1;
+    }
+    keys = reg_batch_sort (regs, count);
+    if (keys == NULL) {
+        return -1;
+    }
+    use_rv = count >= REG_BATCH_RUN_MIN && reg_batch_rv_init (&rv, tgt) == 0;
+
+    for (first = 0; first < count; first = i) {
+        if (use_rv) {
+            i = reg_batch_rv_run (&rv, regs, NULL, keys, first, count);
+            if (i > first) {
+                continue;
+            }
+            use_rv = i == first;
+        }
+        for (i = first + 1; i < count && keys[i].num == keys[first].num; i++)
+            ;
+        /* The last one in the caller's array wins.  */
+        batch_stats.accessed++;
+        if (target_write_cpu_reg (tgt, &regs[keys[i - 1].index]) < 0) {
+            failed++;
+        }
+    }
+
+    free (keys);
+    return -failed;
+}
+
+void
+reg_batch_get_stats (struct reg_batch_stats *stats, int reset)
+{
+    if (stats) {
+        *stats = batch_stats;
+    }
+    if (reset) {
+        memset (&batch_stats, 0, sizeof (batch_stats));
+    }
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: reg_batch.h
+// function description: read/write a set of cpu registers, each distinct
+//                       register is accessed once.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_REG_BATCH_H__
+#define __DEBUGGER_SERVER_EXAMPLE_REG_BATCH_H__
+
+#include "dbg-target.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+\brief The statistics of register batch
+*/
+struct reg_batch_stats
+{
+    unsigned int requested;     ///< Registers requested by callers
+    unsigned int accessed;      ///< Registers accessed one at a time
+    unsigned int runs;          ///< Runs accessed with one abstract command
+    unsigned int run_regs;      ///< Registers accessed in the runs
+};
+
+/**
+  \brief        Read cpu registers, registers requested more than once are
+                read once. On RISC-V, runs of consecutive GPRs or FPRs are read
+                with one Access Register command through the DM, aarpostincrement
+                and abstractauto step through the run. Other registers, and the
+                runs which the hart rejects, cost one target_read_cpu_reg each.
+  \param[in]    tgt, the handle of target
+  \param[out]   regs, the registers, the number must set before calling the function
+  \param[in]    count, the count of registers
+  \return       zero for success, negative for the count of failed registers
+*/
+int reg_batch_read (struct target *tgt, struct reg *regs, int count);
+
+/**
+  \brief        Write cpu registers, see reg_batch_read.
+                If a register is given more than once, the last value wins.
+  \param[in]    tgt, the handle of target
+  \param[in]    regs, the registers, the number and value must set before calling
+  \param[in]    count, the count of registers
+  \return       zero for success, negative for the count of failed registers
+*/
+int reg_batch_write (struct target *tgt, struct reg const *regs, int count);
+
+/**
+  \brief        Get the statistics of register batch
+  \param[out]   stats, save the statistics
+  \param[in]    reset, clear the statistics after reading
+  \return       None
+*/
+void reg_batch_get_stats (struct reg_batch_stats *stats, int reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_REG_BATCH_H__
@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "reg_cache.h"
+#include "reg_batch.h"
+
+struct reg_cache_entry
+{
+    struct reg reg;
+    unsigned int gen;           ///< Valid only if equal to reg_cache.gen
+    int dirty;
+};
+
+struct reg_cache_table
+{
+    struct reg_cache_entry slot[REG_CACHE_SLOTS];
+    int dirty;                  ///< The count of dirty entries
+};
+
+struct reg_cache
+{
+    struct target *tgt;
+    int enabled;
+    int cpu;                    ///< The current cpu
+    unsigned int gen;           ///< Bumped to drop all entries at once
+    struct reg_cache_table *table[MAX_CPU_COUNT];
+    struct reg_cache_stats stats;
+};
+
+struct reg_cache *
+reg_cache_create (struct target *tgt)
+{
+    struct reg_cache *rc;
+
+    if (tgt == NULL) {
+        return NULL;
+    }
+    rc = calloc (1, sizeof (struct reg_cache));
+    if (rc == NULL) {
+        return NULL;
+    }
+    rc->tgt = tgt;
+    rc->gen = 1;
+    rc->cpu = target_get_current_cpu (tgt);
+    if (rc->cpu < 0 || rc->cpu >= MAX_CPU_COUNT) {
+        rc->cpu = 0;
+    }
+    return rc;
+}
+
+void
+reg_cache_destroy (struct reg_cache *rc)
+{
+    int i;
+
+    if (rc == NULL) {
+        return;
+    }
+    for (i = 0; i < MAX_CPU_COUNT; i++) {
+        free (rc->table[i]);
+    }
+    free (rc);
+}
+
+/* Find the entry of the register in the table of the current cpu, an
+   empty one is returned if the register is not cached.  NULL if the
+   table is full or can not be allocated.  Only the number is the key,
+   the type is an output of target_read_cpu_reg.  */
+static struct reg_cache_entry *
+reg_cache_lookup (struct reg_cache *rc, struct reg const *reg)
+{
+    struct reg_cache_table *t = rc->table[rc->cpu];
+    unsigned int h, i;
+
+    if (t == NULL) {
+        t = rc->table[rc->cpu] = calloc (1, sizeof (struct reg_cache_table));
+        if (t == NULL) {
+            return NULL;
+        }
+    }
+    h = ((unsigned int)reg->num * 2654435761u) & (REG_CACHE_SLOTS - 1);
+    for (i = 0; i < REG_CACHE_SLOTS; i++) {
+        struct reg_cache_entry *e = &t->slot[(h + i) & (REG_CACHE_SLOTS - 1)];
+
+        if (e->gen != rc->gen) {
+            return e;
+        }
+        if (e->reg.num == reg->num) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+int
+reg_cache_read (struct reg_cache *rc, struct reg *reg)
+{
+    struct reg_cache_entry *e;
+    int ret;
+
+    if (rc == NULL || reg == NULL) {
+        return -1;
+    }
+    if (!rc->enabled) {
+        return target_read_cpu_reg (rc->tgt, reg);
+    }
+
+    e = reg_cache_lookup (rc, reg);
+    if (e && e->gen == rc->gen) {
+        rc->stats.hits++;
+        reg->type = e->reg.type;
+        reg->length = e->reg.length;
+        reg->value = e->reg.value;
+        return 0;
+    }
+
+    rc->stats.misses++;
+    ret = target_read_cpu_reg (rc->tgt, reg);
+    if (ret < 0 || e == NULL) {
+        return ret;
+    }
+    e->reg = *reg;
+    e->gen = rc->gen;
+    e->dirty = 0;
+    return ret;
+}
+
+int
+reg_cache_write (struct reg_cache *rc, struct reg const *reg)
+{
+    struct reg_cache_entry *e;
+
+    if (rc == NULL || reg == NULL) {
+        return -1;
+    }
+    if (!rc->enabled) {
+        return target_write_cpu_reg (rc->tgt, reg);
+    }
+
+    e = reg_cache_lookup (rc, reg);
+    if (e == NULL) {
+        /* No room, write through.  */
+        return target_write_cpu_reg (rc->tgt, reg);
+    }
+    if (e->gen != rc->gen || !e->dirty) {
+        rc->table[rc->cpu]->dirty++;
+    }
+    /* Keep the type and length read from the target.  */
+    if (e->gen == rc->gen) {
+        e->reg.value = reg->value;
+    } else {
+        e->reg = *reg;
+    }
+    e->gen = rc->gen;
+    e->dirty = 1;
+    rc->stats.writes++;
+    return 0;
+}
+
+int
+reg_cache_flush (struct reg_cache *rc)
+{
+    struct reg_cache_table *t;
+    struct reg *regs;
+    int i, count = 0, ret;
+
+    if (rc == NULL) {
+        return -1;
+    }
+    t = rc->table[rc->cpu];
+    if (t == NULL || t->dirty == 0) {
+        return 0;
+    }
+
+    regs = malloc (sizeof (struct reg) * t->dirty);
+    if (regs == NULL) {
+        return -1;
+    }
+    for (i = 0; i < REG_CACHE_SLOTS; i++) {
+        struct reg_cache_entry *e = &t->slot[i];
+
+        if (e->gen == rc->gen && e->dirty) {
+            regs[count++] = e->reg;
+        }
+    }
+
+    rc->stats.flushes++;
+    rc->stats.flushed += count;
+    ret = reg_batch_write (rc->tgt, regs, count);
+    free (regs);
+    if (ret < 0) {
+        /* Which ones failed is unknown, the values on the target are
+           unknown too.  Drop them so they are read again.  */
+        for (i = 0; i < REG_CACHE_SLOTS; i++) {
+            if (t->slot[i].dirty) {
+                t->slot[i].gen = 0;
+                t->slot[i].dirty = 0;
+            }
+        }
+        t->dirty = 0;
+        return ret;
+    }
+
+    for (i = 0; i < REG_CACHE_SLOTS; i++) {
+        t->slot[i].dirty = 0;
+    }
+    t->dirty = 0;
+    return 0;
+}
+
+int
+reg_cache_enable (struct reg_cache *rc, int en)
+{
+    int ret = 0;
+
+    if (rc == NULL) {
+        return -1;
+    }
+    if (rc->enabled && !en) {
+        ret = reg_cache_flush (rc);
+        reg_cache_invalidate (rc);
+    }
+    rc->enabled = en ? 1 : 0;
+    return ret;
+}
+
+void
+reg_cache_set_cpu (struct reg_cache *rc, int cpu)
+{
+    if (rc == NULL || cpu < 0 || cpu >= MAX_CPU_COUNT) {
+        return;
+    }
+    rc->cpu = cpu;
+}
+
+void
+reg_cache_invalidate (struct reg_cache *rc)
+{
+    int i;
+
+    if (rc == NULL) {
+        return;
+    }
+    rc->gen++;
+    if (rc->gen == 0) {
+        /* Wrapped, clear the tables so old entries are not valid again.  */
+        for (i = 0; i < MAX_CPU_COUNT; i++) {
+            if (rc->table[i]) {
+                memset (rc->table[i], 0, sizeof (struct reg_cache_table));
+            }
+        }
+        rc->gen = 1;
+    }
+    for (i = 0; i < MAX_CPU_COUNT; i++) {
+        if (rc->table[i]) {
+            rc->table[i]->dirty = 0;
+        }
+    }
+}
+
+void
+reg_cache_get_stats (struct reg_cache *rc, struct reg_cache_stats *stats)
+{
+    if (rc == NULL || stats == NULL) {
+        return;
+    }
+    *stats = rc->stats;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: reg_cache.h
+// function description: per-cpu register value cache with dirty tracking,
+//                       dirty registers are written back in one batch.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_REG_CACHE_H__
+#define __DEBUGGER_SERVER_EXAMPLE_REG_CACHE_H__
+
+#include "dbg-target.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define REG_CACHE_SLOTS     512     ///< Registers cached per cpu, must be power of 2
+
+/**
+\brief The statistics of register cache
+*/
+struct reg_cache_stats
+{
+    unsigned int hits;          ///< Reads served from the cache
+    unsigned int misses;        ///< Reads from the target
+    unsigned int writes;        ///< Writes kept as dirty
+    unsigned int flushes;       ///< Times dirty registers were written back
+    unsigned int flushed;       ///< Registers written back
+};
+
+/// definition for register cache, see reg_cache.c
+struct reg_cache;
+
+/**
+  \brief        Create a register cache for the target, it is disabled by default
+  \param[in]    tgt, the handle of target
+  \return       A handle for success, otherwise return NULL
+*/
+struct reg_cache *reg_cache_create (struct target *tgt);
+
+/**
+  \brief        Destroy the register cache, dirty registers are dropped
+  \param[in]    rc, the handle of register cache
+  \return       None
+*/
+void reg_cache_destroy (struct reg_cache *rc);
+
+/**
+  \brief        Enable or disable the register cache, dirty registers are written
+                back before disabling
+  \param[in]    rc, the handle of register cache
+  \param[in]    en, bool type, enable(1) or disable(0)
+  \return       zero for success, negative for error
+*/
+int reg_cache_enable (struct reg_cache *rc, int en);
+
+/**
+  \brief        Read cpu register of the current cpu through the cache
+  \param[in]    rc, the handle of register cache
+  \param[out]   reg, the number must set before calling the function
+  \return       zero for success, negative for error
+*/
+int reg_cache_read (struct reg_cache *rc, struct reg *reg);
+
+/**
+  \brief        Write cpu register of the current cpu, it is kept as dirty
+                until reg_cache_flush
+  \param[in]    rc, the handle of register cache
+  \param[in]    reg, the number and value must set before calling the function
+  \return       zero for success, negative for error
+*/
+int reg_cache_write (struct reg_cache *rc, struct reg const *reg);
+
+/**
+  \brief        Write back all dirty registers of the current cpu in one batch
+  \param[in]    rc, the handle of register cache
+  \return       zero for success, negative for error
+*/
+int reg_cache_flush (struct reg_cache *rc);
+
+/**
+  \brief        Tell the cache which cpu is selected, dirty registers must be
+                flushed before
+  \param[in]    rc, the handle of register cache
+  \param[in]    cpu, the index of cpu
+  \return       None
+*/
+void reg_cache_set_cpu (struct reg_cache *rc, int cpu);
+
+/**
+  \brief        Drop the registers of all cpus, including dirty ones
+  \param[in]    rc, the handle of register cache
+  \return       None
+*/
+void reg_cache_invalidate (struct reg_cache *rc);
+
+/**
+  \brief        Get the statistics of register cache
+  \param[in]    rc, the handle of register cache
+  \param[out]   stats, save the statistics
+  \return       None
+*/
+void reg_cache_get_stats (struct reg_cache *rc, struct reg_cache_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_REG_CACHE_H__
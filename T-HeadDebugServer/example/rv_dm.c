@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "rv_dm.h"
+
+int
+rv_dm_init (struct rv_dm *dm, struct target *tgt)
+{
+    if (dm == NULL || tgt == NULL) {
+        return -1;
+    }
+    memset (dm, 0, sizeof (struct rv_dm));
+    if (target_get_debug_arch_type (tgt) != DEBUG_ARCH_RISCV) {
+        return -1;
+    }
+    dm->tgt = tgt;
+    target_get_dm_registers_list (tgt, &dm->spec_ver, &dm->count, &dm->list);
+    return dm->list && dm->count > 0 ? 0 : -1;
+}
+
+static struct reg *
+rv_dm_find (struct rv_dm *dm, const char *name)
+{
+    int i;
+
+    if (dm == NULL || dm->list == NULL || name == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < dm->count; i++) {
+        if (strcmp (dm->list[i].name, name) == 0) {
+            return &dm->list[i];
+        }
+    }
+    return NULL;
+}
+
+int
+rv_dm_read (struct rv_dm *dm, const char *name, U32 *value)
+{
+    struct reg *tmpl = rv_dm_find (dm, name);
+    struct reg reg;
+    int ret;
+
+    if (tmpl == NULL || value == NULL) {
+        return -1;
+    }
+    reg = *tmpl;
+    ret = target_read_dm_reg (dm->tgt, &reg, dm->spec_ver);
+    if (ret < 0) {
+        return ret;
+    }
+    *value = reg.value.val32;
+    return 0;
+}
+
+int
+rv_dm_write (struct rv_dm *dm, const char *name, U32 value)
+{
+    struct reg *tmpl = rv_dm_find (dm, name);
+    struct reg reg;
+
+    if (tmpl == NULL) {
+        return -1;
+    }
+    reg = *tmpl;
+    reg.value.val32 = value;
+    return target_write_dm_reg (dm->tgt, &reg, dm->spec_ver);
+}
+
+static int
+rv_dm_data_read (struct rv_dm *dm, int size64, U64 *value)
+{
+    U32 lo, hi = 0;
+
+    /* Reading data0 re-executes the command, so data1 goes first.  */
+    if (size64 && rv_dm_read (dm, "data1", &hi) < 0) {
+        return -1;
+    }
+    if (rv_dm_read (dm, "data0", &lo) < 0) {
+        return -1;
+    }
+    *value = (U64)hi << 32 | lo;
+    return 0;
+}
+
+static int
+rv_dm_data_write (struct rv_dm *dm, int size64, U64 value)
+{
+    if (size64 && rv_dm_write (dm, "data1", (U32)(value >> 32)) < 0) {
+        return -1;
+    }
+    return rv_dm_write (dm, "data0", (U32)value);
+}
+
+int
+rv_dm_access_regs (struct rv_dm *dm, U32 regno, int size64, U64 *values,
+                   int count, int write)
+{
+    U32 command, abstractcs = 0;
+    int i, ret = 0;
+
+    if (dm == NULL || values == NULL || count <= 0) {
+        return -1;
+    }
+    command = RV_DM_COMMAND_AARSIZE (size64 ? 3 : 2) | RV_DM_COMMAND_AARPOSTINCREMENT
+              | RV_DM_COMMAND_TRANSFER | RV_DM_COMMAND_REGNO (regno)
+              | (write ? RV_DM_COMMAND_WRITE : 0);
+
+    if (write) {
+        ret = rv_dm_data_write (dm, size64, values[0]);
+        if (ret == 0) {
+            ret = rv_dm_write (dm, "command", command);
+        }
+        if (ret == 0 && count > 1) {
+            ret = rv_dm_write (dm, "abstractauto", RV_DM_ABSTRACTAUTO_AUTOEXECDATA (0));
+        }
+        for (i = 1; ret == 0 && i < count; i++) {
+            ret = rv_dm_data_write (dm, size64, values[i]);
+        }
+    } else {
+        ret = rv_dm_write (dm, "command", command);
+        if (ret == 0 && count > 1) {
+            ret = rv_dm_write (dm, "abstractauto", RV_DM_ABSTRACTAUTO_AUTOEXECDATA (0));
+        }
+        for (i = 0; ret == 0 && i < count; i++) {
+            /* Stop before the last data0 read, no register after the run
+               is accessed.  */
+            if (i == count - 1 && count > 1) {
+                ret = rv_dm_write (dm, "abstractauto", 0);
+            }
+            if (ret == 0) {
+                ret = rv_dm_data_read (dm, size64, &values[i]);
+            }
+        }
+    }
+    if (count > 1 && (write || ret < 0)) {
+        rv_dm_write (dm, "abstractauto", 0);
+    }
+
+    /* An unsupported register or a busy DM sets cmderr.  */
+    if (ret == 0) {
+        ret = rv_dm_read (dm, "abstractcs", &abstractcs);
+    }
+    if (ret == 0 && RV_DM_ABSTRACTCS_CMDERR (abstractcs) != 0) {
+        rv_dm_write (dm, "abstractcs", RV_DM_ABSTRACTCS_CMDERR_MASK);
+        ret = -1;
+    }
+    return ret < 0 ? -1 : 0;
+}
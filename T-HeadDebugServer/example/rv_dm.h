@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: rv_dm.h
+// function description: access RISC-V Debug Module registers by name.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_RV_DM_H__
+#define __DEBUGGER_SERVER_EXAMPLE_RV_DM_H__
+
+#include "dbg-target.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* dmcontrol */
+#define RV_DM_DMCONTROL_HALTREQ         (0x1u << 31)
+#define RV_DM_DMCONTROL_RESUMEREQ       (0x1u << 30)
+#define RV_DM_DMCONTROL_ACKHAVERESET    (0x1u << 28)
+#define RV_DM_DMCONTROL_HASEL           (0x1u << 26)
+#define RV_DM_DMCONTROL_HARTSELLO(v)    (((v) & 0x3ffu) << 16)
+#define RV_DM_DMCONTROL_HARTSEL_MASK    (0x3ffu << 16 | 0x3ffu << 6)
+
+/* dmstatus */
+#define RV_DM_DMSTATUS_ANYHALTED        (0x1u << 8)
+#define RV_DM_DMSTATUS_ALLHALTED        (0x1u << 9)
+#define RV_DM_DMSTATUS_ANYRUNNING       (0x1u << 10)
+#define RV_DM_DMSTATUS_ALLRUNNING       (0x1u << 11)
+#define RV_DM_DMSTATUS_ANYRESUMEACK     (0x1u << 16)
+#define RV_DM_DMSTATUS_ALLRESUMEACK     (0x1u << 17)
+
+/* abstractcs */
+#define RV_DM_ABSTRACTCS_CMDERR(v)      (((v) >> 8) & 0x7)
+#define RV_DM_ABSTRACTCS_CMDERR_MASK    (0x7u << 8)
+#define RV_DM_ABSTRACTCS_BUSY           (0x1u << 12)
+
+/* command, Access Register */
+#define RV_DM_COMMAND_AARSIZE(n)        (((n) & 0x7u) << 20)
+#define RV_DM_COMMAND_AARPOSTINCREMENT  (0x1u << 19)
+#define RV_DM_COMMAND_TRANSFER          (0x1u << 17)
+#define RV_DM_COMMAND_WRITE             (0x1u << 16)
+#define RV_DM_COMMAND_REGNO(n)          ((n) & 0xffffu)
+
+/* abstractauto */
+#define RV_DM_ABSTRACTAUTO_AUTOEXECDATA(n)  (0x1u << (n))
+
+/* regno of Access Register */
+#define RV_DM_REGNO_GPR(n)              (0x1000u + (n))
+#define RV_DM_REGNO_FPR(n)              (0x1020u + (n))
+
+/**
+\brief The DM registers of the target
+*/
+struct rv_dm
+{
+    struct target *tgt;         ///< The handle of target
+    int spec_ver;               ///< The version of dm
+    int count;                  ///< The count of registers in list
+    struct reg *list;           ///< The register list, owned by the target
+};
+
+/**
+  \brief        Get the DM register list of the target
+  \param[out]   dm, save the DM informations
+  \param[in]    tgt, the handle of target
+  \return       zero for success, negative for error or the target is not RISC-V
+*/
+int rv_dm_init (struct rv_dm *dm, struct target *tgt);
+
+/**
+  \brief        Read DM register
+  \param[in]    dm, the DM informations
+  \param[in]    name, the name of the register, such as "abstractcs"
+  \param[out]   value, save the register value
+  \return       zero for success, negative for error
+*/
+int rv_dm_read (struct rv_dm *dm, const char *name, U32 *value);
+
+/**
+  \brief        Write DM register
+  \param[in]    dm, the DM informations
+  \param[in]    name, the name of the register, such as "abstractcs"
+  \param[in]    value, the register value
+  \return       zero for success, negative for error
+*/
+int rv_dm_write (struct rv_dm *dm, const char *name, U32 value);
+
+/**
+  \brief        Access consecutive registers of the selected hart with one Access
+                Register command, aarpostincrement steps the regno and
+                abstractauto re-executes it on each data0 access
+  \param[in]    dm, the DM informations
+  \param[in]    regno, the regno of the first register, such as RV_DM_REGNO_GPR(1)
+  \param[in]    size64, bool type, 64-bit(1) or 32-bit(0) access
+  \param[in]    values, the register values, read into or written from
+  \param[in]    count, the count of registers
+  \param[in]    write, bool type, write(1) or read(0)
+  \return       zero for success, negative for error, cmderr is cleared
+*/
+int rv_dm_access_regs (struct rv_dm *dm, U32 regno, int size64, U64 *values,
+                       int count, int write);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_RV_DM_H__
@@ -0,0 +1,374 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "rv_mem_region.h"
+#include "mem_access.h"
+#include "rv_dm.h"
+
+#define RV_MEM_MODE_COUNT   3
+
+struct rv_mem_router
+{
+    struct target *tgt;
+    struct rv_mem_region regions[RV_MEM_REGION_MAX];
+    int count;
+    int cur_mode;               ///< The mode set to the target, -1 for unknown
+    enum target_riscv_mem_access_mode default_mode; ///< The configured mode
+    int attached;
+    int burst;                  ///< Use abstractauto burst for ABSCMD or not
+    struct rv_dm dm;
+    struct rv_mem_region_stats stats;
+};
+
+/* From the fastest to the slowest.  */
+static const enum target_riscv_mem_access_mode rv_mem_mode_order[RV_MEM_MODE_COUNT] =
+{
+    RV_MEM_ACCESS_SYSBUS,
+    RV_MEM_ACCESS_ABSCMD,
+    RV_MEM_ACCESS_PROGBUF,
+};
+
+static const char *rv_mem_mode_name[RV_MEM_MODE_COUNT] =
+{
+    "progbuf",      /* RV_MEM_ACCESS_PROGBUF */
+    "abscmd",       /* RV_MEM_ACCESS_ABSCMD */
+    "sysbus",       /* RV_MEM_ACCESS_SYSBUS */
+};
+
+static int rv_mem_router_set_mode (struct rv_mem_router *router,
+                                   enum target_riscv_mem_access_mode mode);
+static int rv_mem_router_xfer (void *priv, struct target *tgt, U64 addr,
+                               unsigned char *buff, unsigned int size, int write);
+
+struct rv_mem_router *
+rv_mem_router_create (struct target *tgt)
+{
+    struct rv_mem_router *router;
+
+    if (tgt == NULL || target_get_debug_arch_type (tgt) != DEBUG_ARCH_RISCV) {
+        return NULL;
+    }
+    router = calloc (1, sizeof (struct rv_mem_router));
+    if (router == NULL) {
+        return NULL;
+    }
+    router->tgt = tgt;
+    /* Assume the target is in the configured mode, so nothing is switched
+       until a region or a failure asks for it.  */
+    router->default_mode = RV_MEM_ACCESS_PROGBUF;
+    router->cur_mode = router->default_mode;
+    /* Burst needs abstractcs to check the errors.  */
+    router->burst = rv_dm_init (&router->dm, tgt) == 0;
+    return router;
+}
+
+void
+rv_mem_router_destroy (struct rv_mem_router *router)
+{
+    if (router == NULL) {
+        return;
+    }
+    if (router->attached) {
+        void *priv;
+
+        /* Another router may be attached to the target after this one.  */
+        if (mem_access_get_backend (router->tgt, &priv) == rv_mem_router_xfer
+            && priv == router) {
+            mem_access_set_backend (router->tgt, NULL, NULL);
+        }
+    }
+    /* Leave the target in the configured mode.  */
+    rv_mem_router_set_mode (router, router->default_mode);
+    free (router);
+}
+
+static int
+rv_mem_region_insert (struct rv_mem_router *router, U64 start, U64 end,
+                      enum target_riscv_mem_access_mode mode, int learned)
+{
+    int i;
+
+    if (router->count == RV_MEM_REGION_MAX) {
+        /* Drop the oldest learned region, configured ones are kept.  */
+        for (i = 0; i < router->count; i++) {
+            if (router->regions[i].learned) {
+                break;
+            }
+        }
+        if (i == router->count) {
+            return -1;
+        }
+        memmove (&router->regions[i], &router->regions[i + 1],
+                 sizeof (struct rv_mem_region) * (router->count - i - 1));
+        router->count--;
+    }
+    router->regions[router->count].start = start;
+    router->regions[router->count].end = end;
+    router->regions[router->count].mode = mode;
+    router->regions[router->count].failed = 0;
+    router->regions[router->count].learned = learned;
+    router->count++;
+    return 0;
+}
+
+int
+rv_mem_region_add (struct rv_mem_router *router, U64 start, U64 end,
+                   enum target_riscv_mem_access_mode mode)
+{
+    if (router == NULL || start >= end || mode > RV_MEM_ACCESS_SYSBUS) {
+        return -1;
+    }
+    return rv_mem_region_insert (router, start, end, mode, 0);
+}
+
+int
+rv_mem_region_parse (struct rv_mem_router *router, const char *spec)
+{
+    const char *p = spec;
+    char *end;
+    U64 start, stop;
+    size_t len;
+    int mode;
+
+    if (router == NULL || spec == NULL) {
+        return -1;
+    }
+    while (*p) {
+        start = strtoull (p, &end, 0);
+        if (end == p || *end != '-') {
+            return -1;
+        }
+        p = end + 1;
+        stop = strtoull (p, &end, 0);
+        if (end == p || *end != ':') {
+            return -1;
+        }
+        p = end + 1;
+        len = strcspn (p, ",");
+        for (mode = 0; mode < RV_MEM_MODE_COUNT; mode++) {
+            if (strlen (rv_mem_mode_name[mode]) == len
+                && strncmp (p, rv_mem_mode_name[mode], len) == 0) {
+                break;
+            }
+        }
+        if (mode == RV_MEM_MODE_COUNT
+            || rv_mem_region_add (router, start, stop,
+                                  (enum target_riscv_mem_access_mode)mode) < 0) {
+            return -1;
+        }
+        p += len;
+        if (*p == ',') {
+            p++;
+        }
+    }
+    return 0;
+}
+
+/* Find the region which ADDR routes to, the later region wins. *PIECE_END
+   is where the routing may change.  */
+static struct rv_mem_region *
+rv_mem_region_lookup (struct rv_mem_router *router, U64 addr, U64 *piece_end)
+{
+    struct rv_mem_region *found = NULL;
+    int i;
+
+    for (i = router->count - 1; i >= 0; i--) {
+        struct rv_mem_region *r = &router->regions[i];
+
+        if (found == NULL && r->start <= addr && addr < r->end) {
+            found = r;
+            if (r->end < *piece_end) {
+                *piece_end = r->end;
+            }
+        } else if (found == NULL && r->start > addr && r->start < *piece_end) {
+            *piece_end = r->start;
+        }
+    }
+    return found;
+}
+
+static int
+rv_mem_router_set_mode (struct rv_mem_router *router, enum target_riscv_mem_access_mode mode)
+{
+    int ret;
+
+    if (router->cur_mode == (int)mode) {
+        return 0;
+    }
+    router->stats.mode_switches++;
+    ret = target_config_target (router->tgt, TARGET_CONFIG_MEM_ACCESS_MODE, &mode);
+    router->cur_mode = ret < 0 ? -1 : (int)mode;
+    return ret;
+}
+
+static int
+rv_mem_router_do (struct rv_mem_router *router, U64 addr, unsigned char *buff,
+                  unsigned int size, int write)
+{
+    if (write) {
+        return target_write_memory (router->tgt, addr, buff, size);
+    }
+    return target_read_memory (router->tgt, addr, buff, size);
+}
+
+/* Arm abstractauto on data0, so the link streams data0 back-to-back
+   without issuing an abstract command for each word.  */
+static int
+rv_mem_router_burst (struct rv_mem_router *router, U64 addr, unsigned char *buff,
+                     unsigned int size, int write)
+{
+    U32 abstractcs = 0;
+    int ret;
+
+    ret = target_config_link (router->tgt, LINK_CONFIG_SET_ABSTRACTAUTO, 1);
+    if (ret < 0) {
+        router->burst = 0;
+        return rv_mem_router_do (router, addr, buff, size, write);
+    }
+    ret = rv_mem_router_do (router, addr, buff, size, write);
+    target_config_link (router->tgt, LINK_CONFIG_SET_ABSTRACTAUTO, 0);
+
+    if (ret == 0 && rv_dm_read (&router->dm, "abstractcs", &abstractcs) == 0
+        && RV_DM_ABSTRACTCS_CMDERR (abstractcs) == 0) {
+        router->stats.bursts++;
+        return 0;
+    }
+
+    /* cmderr fired or the burst failed, clear cmderr(W1C) and never use
+       the burst again on this target.  */
+    rv_dm_write (&router->dm, "abstractcs", RV_DM_ABSTRACTCS_CMDERR_MASK);
+    router->burst = 0;
+    router->stats.burst_fallbacks++;
+    return rv_mem_router_do (router, addr, buff, size, write);
+}
+
+static int
+rv_mem_router_piece (struct rv_mem_router *router, U64 addr, unsigned char *buff,
+                     unsigned int size, int write, struct rv_mem_region *r)
+{
+    enum target_riscv_mem_access_mode order[RV_MEM_MODE_COUNT + 1];
+    unsigned int failed = r ? r->failed : 0;
+    int i, n = 0, ret = -1;
+
+    /* Every mode has failed, the region may be accessible now(power or
+       clock is on), so try all of them again.  */
+    if (failed == (RV_MEM_MODE_BIT (RV_MEM_MODE_COUNT) - 1)) {
+        failed = 0;
+    }
+
+    order[n++] = r ? r->mode : router->default_mode;
+    for (i = 0; i < RV_MEM_MODE_COUNT; i++) {
+        if (rv_mem_mode_order[i] != order[0]) {
+            order[n++] = rv_mem_mode_order[i];
+        }
+    }
+
+    for (i = 0; i < n; i++) {
+        if (failed & RV_MEM_MODE_BIT (order[i])) {
+            continue;
+        }
+        if (i > 0) {
+            router->stats.fallbacks++;
+        }
+        ret = rv_mem_router_set_mode (router, order[i]);
+        if (ret == 0) {
+            if (order[i] == RV_MEM_ACCESS_ABSCMD && router->burst
+                && size >= RV_MEM_BURST_MIN) {
+                ret = rv_mem_router_burst (router, addr, buff, size, write);
+            } else {
+                ret = rv_mem_router_do (router, addr, buff, size, write);
+            }
+        }
+        if (ret == 0) {
+            router->stats.accesses[order[i]]++;
+            if (r) {
+                r->mode = order[i];
+            }
+            return 0;
+        }
+
+        /* Remember the failure, a region is learned if there is none.  */
+        failed |= RV_MEM_MODE_BIT (order[i]);
+        if (r == NULL) {
+            if (rv_mem_region_insert (router, addr, addr + size, order[i], 1) == 0) {
+                r = &router->regions[router->count - 1];
+            }
+        }
+        if (r) {
+            r->failed = failed;
+        }
+    }
+    return ret;
+}
+
+static int
+rv_mem_router_xfer (void *priv, struct target *tgt, U64 addr,
+                    unsigned char *buff, unsigned int size, int write)
+{
+    struct rv_mem_router *router = priv;
+    struct rv_mem_region *r;
+    U64 piece_end;
+    unsigned int len;
+    int ret;
+
+    while (size) {
+        piece_end = addr + size;
+        r = rv_mem_region_lookup (router, addr, &piece_end);
+        len = (unsigned int)(piece_end - addr);
+        ret = rv_mem_router_piece (router, addr, buff, len, write, r);
+        if (ret < 0) {
+            return ret;
+        }
+        addr += len;
+        buff += len;
+        size -= len;
+    }
+    return 0;
+}
+
+int
+rv_mem_router_set_default (struct rv_mem_router *router,
+                           enum target_riscv_mem_access_mode mode)
+{
+    if (router == NULL || mode > RV_MEM_ACCESS_SYSBUS) {
+        return -1;
+    }
+    router->default_mode = mode;
+    router->cur_mode = -1;
+    return rv_mem_router_set_mode (router, mode);
+}
+
+void
+rv_mem_router_attach (struct rv_mem_router *router)
+{
+    if (router == NULL) {
+        return;
+    }
+    if (mem_access_set_backend (router->tgt, rv_mem_router_xfer, router) == 0) {
+        router->attached = 1;
+    }
+}
+
+void
+rv_mem_router_get_stats (struct rv_mem_router *router, struct rv_mem_region_stats *stats)
+{
+    if (router == NULL || stats == NULL) {
+        return;
+    }
+    *stats = router->stats;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: rv_mem_region.h
+// function description: route RISC-V memory access to SYSBUS, ABSCMD or
+//                       PROGBUF by region, with automatic fallback.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_RV_MEM_REGION_H__
+#define __DEBUGGER_SERVER_EXAMPLE_RV_MEM_REGION_H__
+
+#include "dbg-target.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RV_MEM_REGION_MAX       32      ///< Max count of regions in the table
+#define RV_MEM_BURST_MIN        64      ///< Min size for abstractauto burst
+
+/* Bit of mode in the mask of rv_mem_region.  */
+#define RV_MEM_MODE_BIT(mode)   (1u << (mode))
+
+/**
+\brief The region of memory access mode
+*/
+struct rv_mem_region
+{
+    U64 start;                  ///< The start address
+    U64 end;                    ///< The end address, exclusive
+    enum target_riscv_mem_access_mode mode;     ///< The preferred mode
+    unsigned int failed;        ///< The modes failed in the region, RV_MEM_MODE_BIT
+    int learned;                ///< Learned from failures or not
+};
+
+/**
+\brief The statistics of memory access routing
+*/
+struct rv_mem_region_stats
+{
+    unsigned int accesses[3];   ///< Accesses done with each mode
+    unsigned int fallbacks;     ///< Accesses retried with a slower mode
+    unsigned int mode_switches; ///< Times TARGET_CONFIG_MEM_ACCESS_MODE was set
+    unsigned int bursts;        ///< ABSCMD accesses streamed with abstractauto
+    unsigned int burst_fallbacks;   ///< Bursts redone without abstractauto
+};
+
+/// definition for the region table, see rv_mem_region.c
+struct rv_mem_router;
+
+/**
+  \brief        Create a region table for the target. Accesses out of the regions
+                try the configured mode first, then SYSBUS, ABSCMD and PROGBUF
+                in order. Long ABSCMD accesses are streamed with abstractauto
+                until abstractcs.cmderr fires.
+  \param[in]    tgt, the handle of target
+  \return       A handle for success, NULL for error or the target is not RISC-V
+*/
+struct rv_mem_router *rv_mem_router_create (struct target *tgt);
+
+/**
+  \brief        Destroy the region table, the backend of mem_access and the
+                configured mode of the target are restored
+  \param[in]    router, the handle of region table
+  \return       None
+*/
+void rv_mem_router_destroy (struct rv_mem_router *router);
+
+/**
+  \brief        Add a region, the later one wins if regions are overlapped
+  \param[in]    router, the handle of region table
+  \param[in]    start, the start address
+  \param[in]    end, the end address, exclusive
+  \param[in]    mode, the preferred mode
+  \return       zero for success, negative for error
+*/
+int rv_mem_region_add (struct rv_mem_router *router, U64 start, U64 end,
+                       enum target_riscv_mem_access_mode mode);
+
+/**
+  \brief        Add regions from a string, such as
+                "0x0-0x20000:progbuf,0x80000000-0x100000000:sysbus"
+  \param[in]    router, the handle of region table
+  \param[in]    spec, the string of regions
+  \return       zero for success, negative for error
+*/
+int rv_mem_region_parse (struct rv_mem_router *router, const char *spec);
+
+/**
+  \brief        Configure TARGET_CONFIG_MEM_ACCESS_MODE of the target, use it
+                instead of target_config_target while the router is alive.
+                RV_MEM_ACCESS_PROGBUF, the default of libTarget, is assumed
+                if it is never called
+  \param[in]    router, the handle of region table
+  \param[in]    mode, the configured mode
+  \return       zero for success, negative for error
+*/
+int rv_mem_router_set_default (struct rv_mem_router *router,
+                               enum target_riscv_mem_access_mode mode);
+
+/**
+  \brief        Route memory access of mem_access on the target by the region table
+  \param[in]    router, the handle of region table
+  \return       None
+*/
+void rv_mem_router_attach (struct rv_mem_router *router);
+
+/**
+  \brief        Get the statistics of memory access routing
+  \param[in]    router, the handle of region table
+  \param[out]   stats, save the statistics
+  \return       None
+*/
+void rv_mem_router_get_stats (struct rv_mem_router *router, struct rv_mem_region_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_RV_MEM_REGION_H__
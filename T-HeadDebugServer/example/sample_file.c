@@ -0,0 +1,469 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "sample_file.h"
+#include "proc_profile.h"
+
+#define SAMPLE_FILE_MAGIC       "PCSF"
+#define SAMPLE_BLOCK_MAGIC      "PCSB"
+#define SAMPLE_HEADER_SIZE      8
+#define SAMPLE_BLOCK_HEADER     12
+#define SAMPLE_RECORD_MAX       40      ///< Bytes of one sample at most
+#define SAMPLE_CONVERT_BATCH    256
+
+/* The last values the deltas are against, reset for each block.  */
+struct sample_state
+{
+    U64 time;
+    U64 pc[MAX_CPU_COUNT];
+    U32 contextid[MAX_CPU_COUNT];
+};
+
+struct sample_writer
+{
+    FILE *fp;
+    unsigned char block[SAMPLE_BLOCK_HEADER + SAMPLE_FILE_BLOCK_SIZE];
+    unsigned int len;           ///< Payload bytes in block
+    unsigned int count;         ///< Samples in block
+    struct sample_state state;
+    struct sample_writer_stats stats;
+};
+
+struct sample_reader
+{
+    FILE *fp;
+    unsigned char payload[SAMPLE_FILE_BLOCK_SIZE];
+    unsigned int len;
+    unsigned int pos;
+    unsigned int left;          ///< Samples left in the block
+    struct sample_state state;
+};
+
+static void
+put_u32 (unsigned char *p, U32 v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static U32
+get_u32 (const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((U32)p[3] << 24);
+}
+
+static unsigned int
+put_varint (unsigned char *p, U64 v)
+{
+    unsigned int n = 0;
+
+    while (v >= 0x80) {
+        p[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (unsigned char)v;
+    return n;
+}
+
+static int
+get_varint (struct sample_reader *r, U64 *v)
+{
+    unsigned int shift = 0;
+
+    *v = 0;
+    while (r->pos < r->len && shift < 64) {
+        unsigned char b = r->payload[r->pos++];
+
+        *v |= (U64)(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            return 0;
+        }
+        shift += 7;
+    }
+    return -1;
+}
+
+/* Signed deltas, small magnitudes are short either way.  */
+static U64
+zigzag (U64 delta)
+{
+    return (delta << 1) ^ ((delta >> 63) ? ~(U64)0 : 0);
+}
+
+static U64
+unzigzag (U64 v)
+{
+    return (v >> 1) ^ ((v & 1) ? ~(U64)0 : 0);
+}
+
+/* Only append to a sample file whose blocks are complete, the blocks
+   appended after a truncated one could not be found.  */
+static int
+sample_file_check (FILE *fp, long size)
+{
+    unsigned char header[SAMPLE_BLOCK_HEADER];
+    long pos = SAMPLE_HEADER_SIZE;
+
+    if (fseek (fp, 0, SEEK_SET) != 0
+        || fread (header, 1, SAMPLE_HEADER_SIZE, fp) != SAMPLE_HEADER_SIZE
+        || memcmp (header, SAMPLE_FILE_MAGIC, 4) != 0
+        || get_u32 (header + 4) != SAMPLE_FILE_VERSION) {
+        return -1;
+    }
+    while (pos < size) {
+        if (fseek (fp, pos, SEEK_SET) != 0
+            || fread (header, 1, SAMPLE_BLOCK_HEADER, fp) != SAMPLE_BLOCK_HEADER
+            || memcmp (header, SAMPLE_BLOCK_MAGIC, 4) != 0) {
+            return -1;
+        }
+        pos += SAMPLE_BLOCK_HEADER + (long)get_u32 (header + 4);
+    }
+    if (pos != size) {
+        return -1;
+    }
+    return fseek (fp, 0, SEEK_END);
+}
+
+struct sample_writer *
+sample_writer_open (const char *path)
+{
+    struct sample_writer *w;
+    unsigned char header[SAMPLE_HEADER_SIZE];
+    FILE *fp;
+    long size;
+
+    if (path == NULL) {
+        return NULL;
+    }
+    fp = fopen (path, "ab+");
+    if (fp == NULL) {
+        return NULL;
+    }
+    if (fseek (fp, 0, SEEK_END) != 0 || (size = ftell (fp)) < 0) {
+        fclose (fp);
+        return NULL;
+    }
+    if (size > 0 && sample_file_check (fp, size) < 0) {
+        fclose (fp);
+        return NULL;
+    }
+
+    w = calloc (1, sizeof (struct sample_writer));
+    if (w == NULL) {
+        fclose (fp);
+        return NULL;
+    }
+    w->fp = fp;
+    if (size == 0) {
+        memcpy (header, SAMPLE_FILE_MAGIC, 4);
+        put_u32 (header + 4, SAMPLE_FILE_VERSION);
+        if (fwrite (header, 1, SAMPLE_HEADER_SIZE, fp) != SAMPLE_HEADER_SIZE) {
+            fclose (fp);
+            free (w);
+            return NULL;
+        }
+        w->stats.bytes += SAMPLE_HEADER_SIZE;
+    }
+    return w;
+}
+
+int
+sample_writer_flush (struct sample_writer *w)
+{
+    unsigned int size;
+
+    if (w == NULL) {
+        return -1;
+    }
+    if (w->count == 0) {
+        return 0;
+    }
+    memcpy (w->block, SAMPLE_BLOCK_MAGIC, 4);
+    put_u32 (w->block + 4, w->len);
+    put_u32 (w->block + 8, w->count);
+    size = SAMPLE_BLOCK_HEADER + w->len;
+    w->len = 0;
+    w->count = 0;
+    memset (&w->state, 0, sizeof (w->state));
+    if (fwrite (w->block, 1, size, w->fp) != size || fflush (w->fp) != 0) {
+        return -1;
+    }
+    w->stats.blocks++;
+    w->stats.bytes += size;
+    return 0;
+}
+
+int
+sample_writer_add (struct sample_writer *w, const struct pc_sample *samples, int count)
+{
+    int i;
+
+    if (w == NULL || (samples == NULL && count != 0)) {
+        return -1;
+    }
+    for (i = 0; i < count; i++) {
+        const struct pc_sample *s = &samples[i];
+        unsigned char *p;
+        int cpu = s->cpu, changed;
+
+        if (cpu < 0 || cpu >= MAX_CPU_COUNT) {
+            w->stats.rejected++;
+            continue;
+        }
+        if (w->len + SAMPLE_RECORD_MAX > SAMPLE_FILE_BLOCK_SIZE
+            && sample_writer_flush (w) < 0) {
+            return -1;
+        }
+        p = w->block + SAMPLE_BLOCK_HEADER + w->len;
+        changed = s->contextid != w->state.contextid[cpu];
+        p += put_varint (p, (U64)cpu * 2 + changed);
+        if (changed) {
+            p += put_varint (p, s->contextid);
+            w->state.contextid[cpu] = s->contextid;
+        }
+        p += put_varint (p, zigzag (s->time_us - w->state.time));
+        p += put_varint (p, zigzag (s->pc - w->state.pc[cpu]));
+        w->state.time = s->time_us;
+        w->state.pc[cpu] = s->pc;
+        w->len = (unsigned int)(p - (w->block + SAMPLE_BLOCK_HEADER));
+        w->count++;
+        w->stats.samples++;
+    }
+    return 0;
+}
+
+void
+sample_writer_on_samples (void *priv, const struct pc_sample *samples, int count)
+{
+    sample_writer_add (priv, samples, count);
+}
+
+int
+sample_writer_close (struct sample_writer *w)
+{
+    int ret;
+
+    if (w == NULL) {
+        return -1;
+    }
+    ret = sample_writer_flush (w);
+    if (fclose (w->fp) != 0) {
+        ret = -1;
+    }
+    free (w);
+    return ret;
+}
+
+void
+sample_writer_get_stats (struct sample_writer *w, struct sample_writer_stats *stats)
+{
+    if (w && stats) {
+        *stats = w->stats;
+    }
+}
+
+struct sample_reader *
+sample_reader_open (const char *path)
+{
+    struct sample_reader *r;
+    unsigned char header[SAMPLE_HEADER_SIZE];
+    FILE *fp;
+
+    if (path == NULL) {
+        return NULL;
+    }
+    fp = fopen (path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    if (fread (header, 1, SAMPLE_HEADER_SIZE, fp) != SAMPLE_HEADER_SIZE
+        || memcmp (header, SAMPLE_FILE_MAGIC, 4) != 0
+        || get_u32 (header + 4) != SAMPLE_FILE_VERSION) {
+        fclose (fp);
+        return NULL;
+    }
+    r = calloc (1, sizeof (struct sample_reader));
+    if (r == NULL) {
+        fclose (fp);
+        return NULL;
+    }
+    r->fp = fp;
+    return r;
+}
+
+int
+sample_reader_next (struct sample_reader *r, struct pc_sample *sample)
+{
+    U64 h, v;
+    int cpu;
+
+    if (r == NULL || sample == NULL) {
+        return -1;
+    }
+    while (r->left == 0) {
+        unsigned char header[SAMPLE_BLOCK_HEADER];
+
+        /* A truncated block is the end, the writer was stopped.  */
+        if (fread (header, 1, SAMPLE_BLOCK_HEADER, r->fp) != SAMPLE_BLOCK_HEADER) {
+            return 0;
+        }
+        if (memcmp (header, SAMPLE_BLOCK_MAGIC, 4) != 0
+            || get_u32 (header + 4) > SAMPLE_FILE_BLOCK_SIZE) {
+            return -1;
+        }
+        r->len = get_u32 (header + 4);
+        r->left = get_u32 (header + 8);
+        r->pos = 0;
+        memset (&r->state, 0, sizeof (r->state));
+        if (fread (r->payload, 1, r->len, r->fp) != r->len) {
+            r->left = 0;
+            return 0;
+        }
+    }
+
+    if (get_varint (r, &h) < 0 || h / 2 >= MAX_CPU_COUNT) {
+        return -1;
+    }
+    cpu = (int)(h / 2);
+    if (h & 1) {
+        if (get_varint (r, &v) < 0) {
+            return -1;
+        }
+        r->state.contextid[cpu] = (U32)v;
+    }
+    if (get_varint (r, &v) < 0) {
+        return -1;
+    }
+    r->state.time += unzigzag (v);
+    if (get_varint (r, &v) < 0) {
+        return -1;
+    }
+    r->state.pc[cpu] += unzigzag (v);
+    r->left--;
+
+    sample->cpu = cpu;
+    sample->contextid = r->state.contextid[cpu];
+    sample->time_us = r->state.time;
+    sample->pc = r->state.pc[cpu];
+    return 1;
+}
+
+void
+sample_reader_close (struct sample_reader *r)
+{
+    if (r == NULL) {
+        return;
+    }
+    fclose (r->fp);
+    free (r);
+}
+
+/* Write the functions of one process.  */
+static int
+sample_collapsed_process (struct pc_profile *profile, const struct proc_profile_info *info,
+                          FILE *out, int has_syms)
+{
+    struct pc_profile_stats stats;
+    struct pc_profile_entry *entries;
+    int n, i;
+
+    pc_profile_get_stats (profile, &stats);
+    entries = malloc (sizeof (struct pc_profile_entry) * (stats.pcs + 1));
+    if (entries == NULL) {
+        return -1;
+    }
+    n = pc_profile_flat (profile, entries, stats.pcs + 1);
+    for (i = 0; i < n; i++) {
+        if (info->contextid) {
+            fprintf (out, "ctx_0x%x;", info->contextid);
+        }
+        if (entries[i].name) {
+            fprintf (out, "%s", entries[i].name);
+        } else if (has_syms) {
+            fprintf (out, "[unknown]");
+        } else {
+            fprintf (out, "0x%llx", (unsigned long long)entries[i].addr);
+        }
+        fprintf (out, " %llu\n", (unsigned long long)entries[i].count);
+    }
+    free (entries);
+    return n < 0 ? -1 : 0;
+}
+
+int
+sample_file_to_collapsed (const char *path, FILE *out, struct elf_syms *syms,
+                          U64 *samples)
+{
+    struct pc_sample batch[SAMPLE_CONVERT_BATCH];
+    struct proc_profile_stats stats;
+    struct proc_profile_info *infos = NULL;
+    struct sample_reader *r;
+    struct proc_profile *pp;
+    int n = 0, i, ret = 0;
+
+    if (out == NULL) {
+        return -1;
+    }
+    r = sample_reader_open (path);
+    if (r == NULL) {
+        return -1;
+    }
+    pp = proc_profile_create (syms);
+    if (pp == NULL) {
+        sample_reader_close (r);
+        return -1;
+    }
+
+    /* Samples are summed by process and function first.  */
+    do {
+        for (n = 0; n < SAMPLE_CONVERT_BATCH; n++) {
+            ret = sample_reader_next (r, &batch[n]);
+            if (ret <= 0) {
+                break;
+            }
+        }
+        proc_profile_on_samples (pp, batch, n);
+    } while (ret > 0);
+    sample_reader_close (r);
+
+    proc_profile_get_stats (pp, &stats);
+    if (ret == 0) {
+        infos = malloc (sizeof (struct proc_profile_info) * (stats.processes + 1));
+        if (infos == NULL) {
+            ret = -1;
+        }
+    }
+    if (ret == 0) {
+        n = proc_profile_list (pp, infos, stats.processes);
+        for (i = 0; i < n && ret == 0; i++) {
+            struct pc_profile *profile = proc_profile_get (pp, infos[i].contextid);
+
+            if (profile) {
+                ret = sample_collapsed_process (profile, &infos[i], out, syms != NULL);
+            }
+        }
+    }
+    free (infos);
+    proc_profile_destroy (pp);
+    if (samples) {
+        *samples = stats.samples;
+    }
+    return ret;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: sample_file.h
+// function description: append-only file of PC samples, PCs and times are
+//                       delta and varint encoded in blocks, and the
+//                       converter to collapsed stack text.
+//
+// File layout, integers are little endian:
+//   "PCSF", u32 version
+//   blocks of: "PCSB", u32 payload bytes, u32 samples, payload
+// The payload is the samples, each is varints of
+//   cpu * 2 + (context ID changed), [context ID], zigzag time delta,
+//   zigzag PC delta to the last sample of the same cpu
+// The deltas start from zero in each block, so blocks are appended to an
+// existing file. A truncated last block is ignored by the reader, and the
+// writer does not append to such a file.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_SAMPLE_FILE_H__
+#define __DEBUGGER_SERVER_EXAMPLE_SAMPLE_FILE_H__
+
+#include <stdio.h>
+#include "dbg-target.h"
+#include "elf_syms.h"
+#include "pc_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SAMPLE_FILE_VERSION     1
+#define SAMPLE_FILE_BLOCK_SIZE  0x10000     ///< Payload bytes of a block at most
+
+/**
+\brief The statistics of sample file writer
+*/
+struct sample_writer_stats
+{
+    U64 samples;                ///< Samples written
+    U64 rejected;               ///< Samples of a cpu out of MAX_CPU_COUNT
+    unsigned int blocks;        ///< Blocks written
+    U64 bytes;                  ///< Bytes written, including headers
+};
+
+/// definition for sample file writer and reader, see sample_file.c
+struct sample_writer;
+struct sample_reader;
+
+/**
+  \brief        Open the file to append samples, the file header is written
+                if the file is empty
+  \param[in]    path, the path of file
+  \return       A handle for success, otherwise return NULL
+*/
+struct sample_writer *sample_writer_open (const char *path);
+
+/**
+  \brief        Add samples, they are written when a block is full
+  \param[in]    w, the handle of writer
+  \param[in]    samples, the samples
+  \param[in]    count, the count of samples
+  \return       zero for success, negative for error
+*/
+int sample_writer_add (struct sample_writer *w, const struct pc_sample *samples, int count);
+
+/**
+  \brief        Add samples from the PC stream, it is a pc_stream_cb_t,
+                pass the writer as priv of pc_stream_cfg
+  \param[in]    priv, the handle of writer
+  \param[in]    samples, the samples
+  \param[in]    count, the count of samples
+  \return       None
+*/
+void sample_writer_on_samples (void *priv, const struct pc_sample *samples, int count);
+
+/**
+  \brief        Write the samples added as a block
+  \param[in]    w, the handle of writer
+  \return       zero for success, negative for error
+*/
+int sample_writer_flush (struct sample_writer *w);
+
+/**
+  \brief        Flush and close the file
+  \param[in]    w, the handle of writer
+  \return       zero for success, negative for error
+*/
+int sample_writer_close (struct sample_writer *w);
+
+/**
+  \brief        Get the statistics of writer
+  \param[in]    w, the handle of writer
+  \param[out]   stats, save the statistics
+  \return       None
+*/
+void sample_writer_get_stats (struct sample_writer *w, struct sample_writer_stats *stats);
+
+/**
+  \brief        Open the file to read samples
+  \param[in]    path, the path of file
+  \return       A handle for success, otherwise return NULL
+*/
+struct sample_reader *sample_reader_open (const char *path);
+
+/**
+  \brief        Read the next sample
+  \param[in]    r, the handle of reader
+  \param[out]   sample, save the sample
+  \return       1 for a sample, zero for the end of file, negative for error
+*/
+int sample_reader_next (struct sample_reader *r, struct pc_sample *sample);
+
+/**
+  \brief        Close the file
+  \param[in]    r, the handle of reader
+  \return       None
+*/
+void sample_reader_close (struct sample_reader *r);
+
+/**
+  \brief        Convert the sample file to collapsed stack text, one line of
+                "[ctx_<context ID>;]<function> <count>" for each function,
+                read by flamegraph.pl, speedscope and so on
+  \param[in]    path, the path of sample file
+  \param[in]    out, where to write the text
+  \param[in]    syms, the symbols to resolve PCs, NULL to write PCs
+  \param[out]   samples, save the count of samples converted, could be NULL
+  \return       zero for success, negative for error
+*/
+int sample_file_to_collapsed (const char *path, FILE *out, struct elf_syms *syms,
+                              U64 *samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_SAMPLE_FILE_H__
@@ -0,0 +1,623 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "semihost.h"
+#include "mem_access.h"
+#include "mem_iov.h"
+
+/* The open flags of GDB File-I/O protocol.  */
+#define FILEIO_O_RDONLY     0x0
+#define FILEIO_O_WRONLY     0x1
+#define FILEIO_O_RDWR       0x2
+#define FILEIO_O_ACCMODE    0x3
+#define FILEIO_O_APPEND     0x8
+#define FILEIO_O_CREAT      0x200
+#define FILEIO_O_TRUNC      0x400
+#define FILEIO_O_EXCL       0x800
+
+/* The errno of GDB File-I/O protocol.  */
+#define FILEIO_EPERM        1
+#define FILEIO_ENOENT       2
+#define FILEIO_EBADF        9
+#define FILEIO_EACCES       13
+#define FILEIO_EFAULT       14
+#define FILEIO_EEXIST       17
+#define FILEIO_EISDIR       21
+#define FILEIO_EINVAL       22
+#define FILEIO_EMFILE       24
+#define FILEIO_ENOSPC       28
+#define FILEIO_ESPIPE       29
+#define FILEIO_ENOSYS       88
+#define FILEIO_ENAMETOOLONG 91
+#define FILEIO_EUNKNOWN     9999
+
+#define SEMIHOST_MAX_PATH   1024
+
+struct semihost_file
+{
+    FILE *fp;
+    char *buf;                  ///< The host buffer, NULL for stdin/stdout/stderr
+    int writing;                ///< The last access is a write
+};
+
+struct semihost
+{
+    struct target *tgt;
+    char *root;
+    struct semihost_file files[SEMIHOST_MAX_FILES];
+    unsigned char *xfer;        ///< The bounce buffer of target memory
+    struct mem_iov iov[SEMIHOST_MAX_IOV];
+    unsigned char table[SEMIHOST_MAX_IOV * sizeof (struct semihost_iov)];
+    struct semihost_stats stats;
+};
+
+static int
+semihost_errno (int err)
+{
+    switch (err) {
+    case EPERM:         return FILEIO_EPERM;
+    case ENOENT:        return FILEIO_ENOENT;
+    case EBADF:         return FILEIO_EBADF;
+    case EACCES:        return FILEIO_EACCES;
+    case EFAULT:        return FILEIO_EFAULT;
+    case EEXIST:        return FILEIO_EEXIST;
+    case EISDIR:        return FILEIO_EISDIR;
+    case EINVAL:        return FILEIO_EINVAL;
+    case EMFILE:        return FILEIO_EMFILE;
+    case ENOSPC:        return FILEIO_ENOSPC;
+    case ESPIPE:        return FILEIO_ESPIPE;
+    case ENAMETOOLONG:  return FILEIO_ENAMETOOLONG;
+    default:            return FILEIO_EUNKNOWN;
+    }
+}
+
+/* The identifier is the name of the call, maybe followed by its
+   parameters, such as "write,1,80001000,c".  */
+static int
+semihost_call_is (const char *identifier, const char *name)
+{
+    size_t len = strlen (name);
+
+    return strncmp (identifier, name, len) == 0
+           && (identifier[len] == '\0' || identifier[len] == ',');
+}
+
+static struct semihost_file *
+semihost_get_file (struct semihost *sh, U64 fd)
+{
+    if (fd >= SEMIHOST_MAX_FILES || sh->files[fd].fp == NULL) {
+        return NULL;
+    }
+    return &sh->files[fd];
+}
+
+/* Standard C needs a seek or flush between reads and writes of one file.  */
+static void
+semihost_set_dir (struct semihost_file *f, int writing)
+{
+    if (f->writing != writing) {
+        fseek (f->fp, 0, SEEK_CUR);
+        f->writing = writing;
+    }
+}
+
+static int
+semihost_read_target (struct semihost *sh, U64 addr, unsigned char *buff, unsigned int size)
+{
+    sh->stats.transfers++;
+    return mem_access_read (sh->tgt, addr, buff, size);
+}
+
+static int
+semihost_read_path (struct semihost *sh, U64 addr, U64 len, char *path, int *err)
+{
+    size_t root_len = sh->root ? strlen (sh->root) : 0;
+    char *name;
+
+    if (len == 0 || root_len + 1 + len > SEMIHOST_MAX_PATH) {
+        *err = len ? FILEIO_ENAMETOOLONG : FILEIO_ENOENT;
+        return -1;
+    }
+    name = path + root_len + 1;
+    if (semihost_read_target (sh, addr, (unsigned char *)name, (unsigned int)len) < 0) {
+        *err = FILEIO_EFAULT;
+        return -1;
+    }
+    name[len - 1] = '\0';
+
+    /* Relative paths are under the root.  */
+    if (root_len == 0 || name[0] == '/' || name[0] == '\\'
+        || (name[0] != '\0' && name[1] == ':')) {
+        memmove (path, name, strlen (name) + 1);
+    } else {
+        memcpy (path, sh->root, root_len);
+        path[root_len] = '/';
+    }
+    return 0;
+}
+
+static int
+semihost_exists (const char *path)
+{
+    FILE *fp = fopen (path, "rb");
+
+    if (fp) {
+        fclose (fp);
+    }
+    return fp != NULL;
+}
+
+/* Map the open flags to the mode of fopen.  */
+static FILE *
+semihost_fopen (const char *path, U64 flags)
+{
+    int rdwr = (flags & FILEIO_O_ACCMODE) == FILEIO_O_RDWR;
+    FILE *fp;
+
+    if ((flags & FILEIO_O_ACCMODE) == FILEIO_O_RDONLY) {
+        return fopen (path, "rb");
+    }
+    if ((flags & FILEIO_O_EXCL) && semihost_exists (path)) {
+        errno = EEXIST;
+        return NULL;
+    }
+    if (!(flags & FILEIO_O_CREAT) && !semihost_exists (path)) {
+        errno = ENOENT;
+        return NULL;
+    }
+    if (flags & FILEIO_O_APPEND) {
+        return fopen (path, rdwr ? "a+b" : "ab");
+    }
+    if (flags & FILEIO_O_TRUNC) {
+        return fopen (path, rdwr ? "w+b" : "wb");
+    }
+    fp = fopen (path, "r+b");
+    if (fp == NULL) {
+        fp = fopen (path, "w+b");
+    }
+    return fp;
+}
+
+static int
+semihost_open (struct semihost *sh, const struct gdb_fileio_info *io, int *err)
+{
+    char path[SEMIHOST_MAX_PATH];
+    struct semihost_file *f;
+    int fd;
+
+    for (fd = 3; fd < SEMIHOST_MAX_FILES && sh->files[fd].fp; fd++)
+        ;
+    if (fd == SEMIHOST_MAX_FILES) {
+        *err = FILEIO_EMFILE;
+        return -1;
+    }
+    if (semihost_read_path (sh, io->param_1, io->param_2, path, err) < 0) {
+        return -1;
+    }
+
+    f = &sh->files[fd];
+    f->buf = malloc (SEMIHOST_FILE_BUF_SIZE);
+    if (f->buf == NULL) {
+        *err = FILEIO_ENOSPC;
+        return -1;
+    }
+    f->fp = semihost_fopen (path, io->param_3);
+    if (f->fp == NULL) {
+        *err = semihost_errno (errno);
+        free (f->buf);
+        f->buf = NULL;
+        return -1;
+    }
+    setvbuf (f->fp, f->buf, _IOFBF, SEMIHOST_FILE_BUF_SIZE);
+    f->writing = 0;
+    return fd;
+}
+
+static int
+semihost_close (struct semihost *sh, U64 fd, int *err)
+{
+    struct semihost_file *f = semihost_get_file (sh, fd);
+    int ret = 0;
+
+    if (f == NULL) {
+        *err = FILEIO_EBADF;
+        return -1;
+    }
+    /* The console is kept open.  */
+    if (fd < 3) {
+        if (fd > 0) {
+            fflush (f->fp);
+        }
+        return 0;
+    }
+    if (fclose (f->fp) != 0) {
+        *err = semihost_errno (errno);
+        ret = -1;
+    }
+    free (f->buf);
+    memset (f, 0, sizeof (struct semihost_file));
+    return ret;
+}
+
+/* Copy LEN bytes at ADDR of target to the file F, through the bounce
+   buffer.  */
+static int
+semihost_copy_out (struct semihost *sh, struct semihost_file *f, U64 addr, U64 len, int *err)
+{
+    unsigned int size;
+    U64 done;
+
+    semihost_set_dir (f, 1);
+    for (done = 0; done < len; done += size) {
+        size = len - done > SEMIHOST_MAX_TRANSFER ? SEMIHOST_MAX_TRANSFER
+                                                  : (unsigned int)(len - done);
+        if (semihost_read_target (sh, addr + done, sh->xfer, size) < 0) {
+            *err = FILEIO_EFAULT;
+            return -1;
+        }
+        if (fwrite (sh->xfer, 1, size, f->fp) != size) {
+            *err = semihost_errno (errno);
+            return -1;
+        }
+        sh->stats.bytes_written += size;
+    }
+    return 0;
+}
+
+static int
+semihost_write (struct semihost *sh, const struct gdb_fileio_info *io, int *err)
+{
+    struct semihost_file *f = semihost_get_file (sh, io->param_1);
+
+    if (f == NULL) {
+        *err = FILEIO_EBADF;
+        return -1;
+    }
+    if (io->param_3 > 0x7fffffff) {
+        *err = FILEIO_EINVAL;
+        return -1;
+    }
+    if (semihost_copy_out (sh, f, io->param_2, io->param_3, err) < 0) {
+        return -1;
+    }
+    if (f->buf == NULL) {
+        fflush (f->fp);
+    }
+    return (int)io->param_3;
+}
+
+void
+semihost_iov_decode (const unsigned char *table, int count, struct semihost_iov *segs)
+{
+    int i, j;
+
+    for (i = 0; i < count; i++) {
+        const unsigned char *p = table + i * sizeof (struct semihost_iov);
+
+        segs[i].fd = p[0] | p[1] << 8 | p[2] << 16 | (U32)p[3] << 24;
+        segs[i].len = p[4] | p[5] << 8 | p[6] << 16 | (U32)p[7] << 24;
+        segs[i].addr = 0;
+        for (j = 15; j >= 8; j--) {
+            segs[i].addr = segs[i].addr << 8 | p[j];
+        }
+    }
+}
+
+/* Write the segments of the table at ADDR, segments are read together as
+   long as they fit in the bounce buffer.  */
+static int
+semihost_writev (struct semihost *sh, const struct gdb_fileio_info *io, int *err)
+{
+    struct semihost_iov segs[SEMIHOST_MAX_IOV];
+    unsigned int total, offset;
+    int count, first, last, i, written = 0;
+
+    count = (int)(io->param_3 / sizeof (struct semihost_iov));
+    if (io->param_3 % sizeof (struct semihost_iov) || count > SEMIHOST_MAX_IOV) {
+        *err = FILEIO_EINVAL;
+        return -1;
+    }
+    if (count && semihost_read_target (sh, io->param_2, sh->table,
+                                       count * sizeof (struct semihost_iov)) < 0) {
+        *err = FILEIO_EFAULT;
+        return -1;
+    }
+    semihost_iov_decode (sh->table, count, segs);
+    for (i = 0; i < count; i++) {
+        if (semihost_get_file (sh, segs[i].fd) == NULL) {
+            *err = FILEIO_EBADF;
+            return -1;
+        }
+        if (segs[i].len > (U32)(0x7fffffff - written)) {
+            *err = FILEIO_EINVAL;
+            return -1;
+        }
+        written += segs[i].len;
+    }
+    sh->stats.segments += count;
+
+    for (first = 0; first < count; first = last) {
+        /* Too big to be bounced with others.  */
+        if (segs[first].len > SEMIHOST_MAX_TRANSFER) {
+            if (semihost_copy_out (sh, &sh->files[segs[first].fd], segs[first].addr,
+                                   segs[first].len, err) < 0) {
+                return -1;
+            }
+            last = first + 1;
+            continue;
+        }
+        total = 0;
+        for (last = first; last < count && segs[last].len <= SEMIHOST_MAX_TRANSFER - total; last++) {
+            sh->iov[last - first].addr = segs[last].addr;
+            sh->iov[last - first].buff = sh->xfer + total;
+            sh->iov[last - first].size = segs[last].len;
+            total += segs[last].len;
+        }
+        sh->stats.transfers++;
+        if (target_read_memory_v (sh->tgt, sh->iov, last - first) < 0) {
+            *err = FILEIO_EFAULT;
+            return -1;
+        }
+        for (i = first, offset = 0; i < last; offset += segs[i].len, i++) {
+            struct semihost_file *f = &sh->files[segs[i].fd];
+
+            semihost_set_dir (f, 1);
+            if (fwrite (sh->xfer + offset, 1, segs[i].len, f->fp) != segs[i].len) {
+                *err = semihost_errno (errno);
+                return -1;
+            }
+        }
+        sh->stats.bytes_written += total;
+    }
+    for (i = 0; i < count; i++) {
+        if (segs[i].fd < 3) {
+            fflush (sh->files[segs[i].fd].fp);
+        }
+    }
+    return written;
+}
+
+static int
+semihost_read (struct semihost *sh, const struct gdb_fileio_info *io, int *err)
+{
+    struct semihost_file *f = semihost_get_file (sh, io->param_1);
+    unsigned int size, got;
+    U64 done;
+
+    if (f == NULL) {
+        *err = FILEIO_EBADF;
+        return -1;
+    }
+    if (io->param_3 > 0x7fffffff) {
+        *err = FILEIO_EINVAL;
+        return -1;
+    }
+    semihost_set_dir (f, 0);
+    for (done = 0; done < io->param_3; done += got) {
+        size = io->param_3 - done > SEMIHOST_MAX_TRANSFER ? SEMIHOST_MAX_TRANSFER
+                                                          : (unsigned int)(io->param_3 - done);
+        /* The console returns one line at most.  */
+        if (f->fp == stdin) {
+            if (fgets ((char *)sh->xfer, size < SEMIHOST_MAX_TRANSFER ? size + 1 : size,
+                       stdin) == NULL) {
+                break;
+            }
+            got = (unsigned int)strlen ((char *)sh->xfer);
+        } else {
+            got = (unsigned int)fread (sh->xfer, 1, size, f->fp);
+        }
+        if (got == 0) {
+            break;
+        }
+        sh->stats.transfers++;
+        if (mem_access_write (sh->tgt, io->param_2 + done, sh->xfer, got) < 0) {
+            *err = FILEIO_EFAULT;
+            return -1;
+        }
+        sh->stats.bytes_read += got;
+        if (got < size) {
+            done += got;
+            break;
+        }
+    }
+    if (ferror (f->fp)) {
+        clearerr (f->fp);
+        *err = semihost_errno (errno);
+        return -1;
+    }
+    return (int)done;
+}
+
+static int
+semihost_lseek (struct semihost *sh, const struct gdb_fileio_info *io, int *err)
+{
+    struct semihost_file *f = semihost_get_file (sh, io->param_1);
+    long pos;
+
+    if (f == NULL) {
+        *err = FILEIO_EBADF;
+        return -1;
+    }
+    if (io->param_1 < 3) {
+        *err = FILEIO_ESPIPE;
+        return -1;
+    }
+    if (fseek (f->fp, (long)io->param_2, (int)io->param_3) != 0
+        || (pos = ftell (f->fp)) < 0) {
+        *err = semihost_errno (errno);
+        return -1;
+    }
+    return (int)pos;
+}
+
+static int
+semihost_unlink (struct semihost *sh, const struct gdb_fileio_info *io, int *err)
+{
+    char path[SEMIHOST_MAX_PATH];
+
+    if (semihost_read_path (sh, io->param_1, io->param_2, path, err) < 0) {
+        return -1;
+    }
+    if (remove (path) != 0) {
+        *err = semihost_errno (errno);
+        return -1;
+    }
+    return 0;
+}
+
+static int
+semihost_rename (struct semihost *sh, const struct gdb_fileio_info *io, int *err)
+{
+    char from[SEMIHOST_MAX_PATH], to[SEMIHOST_MAX_PATH];
+
+    if (semihost_read_path (sh, io->param_1, io->param_2, from, err) < 0
+        || semihost_read_path (sh, io->param_3, io->param_4, to, err) < 0) {
+        return -1;
+    }
+    if (rename (from, to) != 0) {
+        *err = semihost_errno (errno);
+        return -1;
+    }
+    return 0;
+}
+
+int
+semihost_handle (struct semihost *sh, const struct halt_info *info)
+{
+    const struct gdb_fileio_info *io;
+    const char *id;
+    int ret, err = 0;
+
+    if (sh == NULL || info == NULL) {
+        return -1;
+    }
+    if (info->reason != DBG_REASON_FILEIO) {
+        return 1;
+    }
+    io = &info->data.fileio;
+    id = io->identifier ? io->identifier : "";
+    sh->stats.calls++;
+
+    if (semihost_call_is (id, "write")) {
+        sh->stats.writes++;
+        ret = io->param_1 == SEMIHOST_WRITEV_FD ? semihost_writev (sh, io, &err)
+                                                : semihost_write (sh, io, &err);
+    } else if (semihost_call_is (id, "read")) {
+        sh->stats.reads++;
+        ret = semihost_read (sh, io, &err);
+    } else if (semihost_call_is (id, "open")) {
+        ret = semihost_open (sh, io, &err);
+    } else if (semihost_call_is (id, "close")) {
+        ret = semihost_close (sh, io->param_1, &err);
+    } else if (semihost_call_is (id, "lseek")) {
+        ret = semihost_lseek (sh, io, &err);
+    } else if (semihost_call_is (id, "isatty")) {
+        ret = semihost_get_file (sh, io->param_1) ? io->param_1 < 3 : -1;
+        err = ret < 0 ? FILEIO_EBADF : 0;
+    } else if (semihost_call_is (id, "unlink")) {
+        ret = semihost_unlink (sh, io, &err);
+    } else if (semihost_call_is (id, "rename")) {
+        ret = semihost_rename (sh, io, &err);
+    } else {
+        sh->stats.unsupported++;
+        ret = -1;
+        err = FILEIO_ENOSYS;
+    }
+
+    if (target_fileio_end (sh->tgt, ret, ret < 0 ? err : 0, 0) < 0) {
+        return -1;
+    }
+    return target_resume (sh->tgt);
+}
+
+int
+semihost_flush (struct semihost *sh)
+{
+    int fd, ret = 0;
+
+    if (sh == NULL) {
+        return -1;
+    }
+    for (fd = 0; fd < SEMIHOST_MAX_FILES; fd++) {
+        if (sh->files[fd].fp && sh->files[fd].fp != stdin
+            && fflush (sh->files[fd].fp) != 0) {
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+struct semihost *
+semihost_create (struct target *tgt, const char *root)
+{
+    struct semihost *sh;
+
+    if (tgt == NULL) {
+        return NULL;
+    }
+    sh = calloc (1, sizeof (struct semihost));
+    if (sh == NULL) {
+        return NULL;
+    }
+    sh->xfer = malloc (SEMIHOST_MAX_TRANSFER);
+    sh->root = root && root[0] ? malloc (strlen (root) + 1) : NULL;
+    if (sh->xfer == NULL || (root && root[0] && sh->root == NULL)) {
+        free (sh->xfer);
+        free (sh->root);
+        free (sh);
+        return NULL;
+    }
+    if (sh->root) {
+        strcpy (sh->root, root);
+    }
+    sh->tgt = tgt;
+    sh->files[0].fp = stdin;
+    sh->files[1].fp = stdout;
+    sh->files[2].fp = stderr;
+    return sh;
+}
+
+void
+semihost_destroy (struct semihost *sh)
+{
+    int fd, err;
+
+    if (sh == NULL) {
+        return;
+    }
+    for (fd = 3; fd < SEMIHOST_MAX_FILES; fd++) {
+        if (sh->files[fd].fp) {
+            semihost_close (sh, fd, &err);
+        }
+    }
+    fflush (stdout);
+    fflush (stderr);
+    free (sh->xfer);
+    free (sh->root);
+    free (sh);
+}
+
+void
+semihost_get_stats (struct semihost *sh, struct semihost_stats *stats)
+{
+    if (sh && stats) {
+        *stats = sh->stats;
+    }
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: semihost.h
+// function description: local semihosting engine serving DBG_REASON_FILEIO
+//                       halts with buffered host files and vectored writes.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_SEMIHOST_H__
+#define __DEBUGGER_SERVER_EXAMPLE_SEMIHOST_H__
+
+#include "dbg-target.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SEMIHOST_MAX_FILES      32              ///< Files opened at the same time, including 0/1/2
+#define SEMIHOST_FILE_BUF_SIZE  (256 * 1024)    ///< The host buffer of each opened file
+#define SEMIHOST_MAX_TRANSFER   (1024 * 1024)   ///< The max bytes of one target memory access
+#define SEMIHOST_MAX_IOV        256             ///< The max segments of one vectored write
+
+/* A write to this descriptor is a vectored write, the buffer is an array of
+   struct semihost_iov and the length is the size of the array in bytes.  */
+#define SEMIHOST_WRITEV_FD      0x7fffff00
+
+/**
+\brief The segment of vectored write as it is laid out in target memory,
+       little endian, 16 bytes.
+*/
+struct semihost_iov
+{
+    U32 fd;                     ///< The file descriptor returned by open
+    U32 len;                    ///< The length of the segment
+    U64 addr;                   ///< The address of the segment
+};
+
+/**
+\brief The statistics of semihosting engine
+*/
+struct semihost_stats
+{
+    unsigned int calls;         ///< File-I/O halts served
+    unsigned int unsupported;   ///< Calls answered with ENOSYS
+    unsigned int writes;        ///< Writes, a vectored write counts once
+    unsigned int segments;      ///< Segments of vectored writes
+    unsigned int reads;         ///< Reads
+    unsigned int transfers;     ///< Target memory accesses
+    U64 bytes_written;          ///< Bytes written to host files
+    U64 bytes_read;             ///< Bytes read from host files
+};
+
+/// definition for semihosting engine, see semihost.c
+struct semihost;
+
+/**
+  \brief        Create the semihosting engine. Use it when the local_semi of
+                functional_cfg is off, so File-I/O halts come to the caller.
+  \param[in]    tgt, the handle of target
+  \param[in]    root, the directory for relative paths opened by the target,
+                NULL for the current directory
+  \return       A handle for success, otherwise return NULL
+*/
+struct semihost *semihost_create (struct target *tgt, const char *root);
+
+/**
+  \brief        Close all files opened by the target and destroy the engine
+  \param[in]    sh, the handle of semihosting engine
+  \return       None
+*/
+void semihost_destroy (struct semihost *sh);
+
+/**
+  \brief        Serve the syscall of a File-I/O halt, the answer is sent by
+                target_fileio_end and the target is resumed
+  \param[in]    sh, the handle of semihosting engine
+  \param[in]    info, the halt informations from target_check_debug
+  \return       zero for served, positive for not a File-I/O halt, negative for error
+*/
+int semihost_handle (struct semihost *sh, const struct halt_info *info);
+
+/**
+  \brief        Write the host buffers of all opened files to disk
+  \param[in]    sh, the handle of semihosting engine
+  \return       zero for success, negative for error
+*/
+int semihost_flush (struct semihost *sh);
+
+/**
+  \brief        Decode the table of a vectored write read from target memory
+  \param[in]    table, count * 16 bytes, see struct semihost_iov
+  \param[in]    count, the count of segments
+  \param[out]   segs, save the segments
+  \return       None
+*/
+void semihost_iov_decode (const unsigned char *table, int count, struct semihost_iov *segs);
+
+/**
+  \brief        Get the statistics of semihosting engine
+  \param[in]    sh, the handle of semihosting engine
+  \param[out]   stats, save the statistics
+  \return       None
+*/
+void semihost_get_stats (struct semihost *sh, struct semihost_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_SEMIHOST_H__
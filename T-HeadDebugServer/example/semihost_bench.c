@@ -0,0 +1,573 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Semihosting benchmark: semihost.c serves the File-I/O halts of a program
+   on the simulated target. It is linked with sim_link.c built with
+   SIM_LINK_TARGET instead of libTarget, so target_check_debug and
+   target_fileio_end are the simulated ones, not those of libTarget.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dbg-target.h"
+#include "host_os.h"
+#include "semihost.h"
+#include "sim_link.h"
+
+#define BENCH_MEM_SIZE		(8 * 1024 * 1024)
+#define BENCH_PATH_ADDR		0x100
+#define BENCH_IOV_ADDR		0x1000
+#define BENCH_DATA_ADDR		0x10000
+#define BENCH_WRITEV_SEGS	8
+#define BENCH_MAX_SIZE		((BENCH_MEM_SIZE - BENCH_DATA_ADDR) / BENCH_WRITEV_SEGS)
+#define BENCH_FILE			"semihost_bench.tmp"
+
+/* The open flags of GDB File-I/O protocol.  */
+#define BENCH_O_RDONLY		0x0
+#define BENCH_O_CREAT_WR	0x601	/* O_WRONLY | O_CREAT | O_TRUNC */
+#define BENCH_O_CREAT_RDWR	0x602	/* O_RDWR | O_CREAT | O_TRUNC */
+
+enum bench_mix
+{
+	BENCH_MIX_WRITE = 0,	///< Writes to one file
+	BENCH_MIX_WRITEV,		///< Vectored writes of BENCH_WRITEV_SEGS segments
+	BENCH_MIX_READ,			///< Reads from one file
+	BENCH_MIX_OPEN_CLOSE,	///< Open and close
+	BENCH_MIX_MIXED,		///< open, 4 writes, lseek, 3 reads, close
+	BENCH_MIX_NUM,
+};
+
+static const char *bench_mix_names[BENCH_MIX_NUM] = {
+	"write", "writev", "read", "open-close", "mixed",
+};
+
+enum bench_op
+{
+	BENCH_OP_NONE = 0,
+	BENCH_OP_OPEN,
+	BENCH_OP_CLOSE,
+	BENCH_OP_WRITE,
+	BENCH_OP_READ,
+	BENCH_OP_LSEEK,
+};
+
+struct bench_prog
+{
+	enum bench_mix mix;
+	unsigned int calls;		///< Syscalls to issue
+	unsigned int size;		///< Bytes of each read/write
+	unsigned int issued;
+	enum bench_op last;
+	int fd;
+	unsigned int failed;
+	U64 bytes;
+};
+
+static int
+bench_issue (struct bench_prog *p, struct gdb_fileio_info *io, enum bench_op op,
+			 U64 p1, U64 p2, U64 p3)
+{
+	static const char *ids[] = {"", "open", "close", "write", "read", "lseek"};
+
+	io->identifier = (char *)ids[op];
+	io->param_1 = p1;
+	io->param_2 = p2;
+	io->param_3 = p3;
+	p->last = op;
+	p->issued++;
+	return 1;
+}
+
+static int
+bench_open (struct bench_prog *p, struct gdb_fileio_info *io, U64 flags)
+{
+	return bench_issue (p, io, BENCH_OP_OPEN, BENCH_PATH_ADDR, strlen (BENCH_FILE) + 1, flags);
+}
+
+/* The program on the target, one syscall is issued for each call.  */
+static int
+bench_program (void *priv, struct target *tgt, struct gdb_fileio_info *io)
+{
+	struct bench_prog *p = priv;
+	unsigned int step;
+	int ret = 0, err;
+
+	if (p->last != BENCH_OP_NONE) {
+		if (sim_target_fileio_result (tgt, &ret, &err) < 0 || ret < 0) {
+			p->failed++;
+		} else if (p->last == BENCH_OP_OPEN) {
+			p->fd = ret;
+		} else if (p->last == BENCH_OP_WRITE || p->last == BENCH_OP_READ) {
+			p->bytes += ret;
+		}
+	}
+
+	if (p->issued == 0) {
+		if (p->mix == BENCH_MIX_READ || p->mix == BENCH_MIX_OPEN_CLOSE) {
+			return bench_open (p, io, BENCH_O_RDONLY);
+		}
+		return bench_open (p, io, p->mix == BENCH_MIX_MIXED ? BENCH_O_CREAT_RDWR
+															: BENCH_O_CREAT_WR);
+	}
+	if (p->issued >= p->calls) {
+		if (p->last != BENCH_OP_CLOSE) {
+			return bench_issue (p, io, BENCH_OP_CLOSE, p->fd, 0, 0);
+		}
+		return -1;
+	}
+
+	switch (p->mix) {
+	case BENCH_MIX_WRITE:
+		return bench_issue (p, io, BENCH_OP_WRITE, p->fd, BENCH_DATA_ADDR, p->size);
+	case BENCH_MIX_WRITEV:
+		return bench_issue (p, io, BENCH_OP_WRITE, SEMIHOST_WRITEV_FD, BENCH_IOV_ADDR,
+							BENCH_WRITEV_SEGS * sizeof (struct semihost_iov));
+	case BENCH_MIX_READ:
+		/* Rewind at the end of file.  */
+		if (p->last == BENCH_OP_READ && ret == 0) {
+			return bench_issue (p, io, BENCH_OP_LSEEK, p->fd, 0, 0);
+		}
+		return bench_issue (p, io, BENCH_OP_READ, p->fd, BENCH_DATA_ADDR, p->size);
+	case BENCH_MIX_OPEN_CLOSE:
+		if (p->last == BENCH_OP_OPEN) {
+			return bench_issue (p, io, BENCH_OP_CLOSE, p->fd, 0, 0);
+		}
+		return bench_open (p, io, BENCH_O_RDONLY);
+	default:
+		break;
+	}
+
+	/* The first open is step 0.  */
+	step = p->issued % 10;
+	if (step == 0) {
+		return bench_open (p, io, BENCH_O_CREAT_RDWR);
+	} else if (step <= 4) {
+		return bench_issue (p, io, BENCH_OP_WRITE, p->fd, BENCH_DATA_ADDR, p->size);
+	} else if (step == 5) {
+		return bench_issue (p, io, BENCH_OP_LSEEK, p->fd, 0, 0);
+	} else if (step <= 8) {
+		return bench_issue (p, io, BENCH_OP_READ, p->fd, BENCH_DATA_ADDR, p->size);
+	}
+	return bench_issue (p, io, BENCH_OP_CLOSE, p->fd, 0, 0);
+}
+
+/* The file read by the read and open-close mixes.  */
+static int
+bench_prepare_file (unsigned int size)
+{
+	FILE *fp = fopen (BENCH_FILE, "wb");
+	unsigned int i;
+
+	if (fp == NULL) {
+		return -1;
+	}
+	for (i = 0; i < size * 16; i++) {
+		fputc (i & 0xff, fp);
+	}
+	fclose (fp);
+	return 0;
+}
+
+static void
+bench_prepare_memory (struct target *tgt, int fd, unsigned int size)
+{
+	unsigned char *mem = sim_target_memory (tgt, NULL);
+	unsigned char *iov = mem + BENCH_IOV_ADDR;
+	U64 addr;
+	int i, j;
+
+	strcpy ((char *)mem + BENCH_PATH_ADDR, BENCH_FILE);
+	for (i = 0; i < BENCH_WRITEV_SEGS; i++) {
+		addr = BENCH_DATA_ADDR + (U64)i * size;
+		for (j = 0; j < 4; j++) {
+			iov[i * 16 + j] = (unsigned char)(fd >> (j * 8));
+			iov[i * 16 + 4 + j] = (unsigned char)(size >> (j * 8));
+		}
+		for (j = 0; j < 8; j++) {
+			iov[i * 16 + 8 + j] = (unsigned char)(addr >> (j * 8));
+		}
+	}
+	for (i = 0; i < BENCH_WRITEV_SEGS * (int)size; i++) {
+		mem[BENCH_DATA_ADDR + i] = (unsigned char)i;
+	}
+}
+
+/* The check: each call once with its answer checked, then the host file.  */
+#define CHECK_FILE			"semihost_check.tmp"
+#define CHECK_MISSING		"semihost_check.none"
+#define CHECK_MISSING_ADDR	0x200
+#define CHECK_READ_ADDR		0x700000
+#define CHECK_READ_SIZE		0x1000
+#define CHECK_WRITE_SIZE	1000
+#define CHECK_SEGS			5
+#define CHECK_FD			3
+
+/* GDB File-I/O errno.  */
+#define CHECK_ENOENT		2
+#define CHECK_EBADF			9
+
+struct check_call
+{
+	const char *id;
+	U64 p1, p2, p3;
+	int ret;				///< The expected answer
+	int err;				///< The expected errno when ret is negative
+};
+
+/* Two segments share a bounce buffer, one is over SEMIHOST_MAX_TRANSFER and
+   two more share the next one.  */
+static const struct semihost_iov check_segs[CHECK_SEGS] = {
+	{CHECK_FD, 0x90000, BENCH_DATA_ADDR},
+	{CHECK_FD, 0x60000, BENCH_DATA_ADDR + 0x100000},
+	{CHECK_FD, 0x180000, BENCH_DATA_ADDR + 0x200000},
+	{CHECK_FD, 0x40000, BENCH_DATA_ADDR + 0x400000},
+	{CHECK_FD, 0x20000, BENCH_DATA_ADDR + 0x500000},
+};
+#define CHECK_WRITEV_SIZE	(0x90000 + 0x60000 + 0x180000 + 0x40000 + 0x20000)
+#define CHECK_FILE_SIZE		(CHECK_WRITE_SIZE + CHECK_WRITEV_SIZE)
+
+static const struct check_call check_calls[] = {
+	{"open", BENCH_PATH_ADDR, sizeof (CHECK_FILE), BENCH_O_CREAT_RDWR, CHECK_FD, 0},
+	{"write", CHECK_FD, BENCH_DATA_ADDR + 0x600000, CHECK_WRITE_SIZE, CHECK_WRITE_SIZE, 0},
+	{"write", SEMIHOST_WRITEV_FD, BENCH_IOV_ADDR, CHECK_SEGS * sizeof (struct semihost_iov),
+	 CHECK_WRITEV_SIZE, 0},
+	{"lseek", CHECK_FD, 0, SEEK_SET, 0, 0},
+	{"read", CHECK_FD, CHECK_READ_ADDR, CHECK_READ_SIZE, CHECK_READ_SIZE, 0},
+	{"lseek", CHECK_FD, 0, SEEK_END, CHECK_FILE_SIZE, 0},
+	{"read", CHECK_FD, CHECK_READ_ADDR, 16, 0, 0},
+	{"write", 20, BENCH_DATA_ADDR, 16, -1, CHECK_EBADF},
+	{"close", CHECK_FD, 0, 0, 0, 0},
+	{"close", CHECK_FD, 0, 0, -1, CHECK_EBADF},
+	{"open", CHECK_MISSING_ADDR, sizeof (CHECK_MISSING), BENCH_O_RDONLY, -1, CHECK_ENOENT},
+};
+#define CHECK_CALLS			(int)(sizeof (check_calls) / sizeof (check_calls[0]))
+
+struct check_prog
+{
+	int issued;
+	int failed;				///< The first call with a wrong answer, plus 1
+};
+
+static int
+check_program (void *priv, struct target *tgt, struct gdb_fileio_info *io)
+{
+	struct check_prog *p = priv;
+	const struct check_call *c;
+	int ret, err = 0;
+
+	if (p->issued > 0) {
+		c = &check_calls[p->issued - 1];
+		if (sim_target_fileio_result (tgt, &ret, &err) < 0 || ret != c->ret
+			|| (ret < 0 && err != c->err)) {
+			if (!p->failed) {
+				printf ("check %s #%d answered %d, errno %d\n", c->id, p->issued, ret, err);
+				p->failed = p->issued;
+			}
+		}
+	}
+	if (p->issued == CHECK_CALLS) {
+		return -1;
+	}
+	c = &check_calls[p->issued++];
+	io->identifier = (char *)c->id;
+	io->param_1 = c->p1;
+	io->param_2 = c->p2;
+	io->param_3 = c->p3;
+	return 1;
+}
+
+static unsigned char
+check_pattern (unsigned int i)
+{
+	return (unsigned char)(i ^ i >> 8 ^ i >> 16 ^ i >> 24);
+}
+
+/* The host file is the write followed by the segments, and the read got
+   its head back.  */
+static int
+check_verify (unsigned char *mem)
+{
+	unsigned char *buf = malloc (CHECK_FILE_SIZE + 1), *p;
+	FILE *fp = fopen (CHECK_FILE, "rb");
+	size_t size = 0;
+	int i, ret = 0;
+
+	if (buf && fp) {
+		size = fread (buf, 1, CHECK_FILE_SIZE + 1, fp);
+	}
+	if (fp) {
+		fclose (fp);
+	}
+	if (buf == NULL || size != CHECK_FILE_SIZE) {
+		printf ("check file is %u bytes, not %u\n", (unsigned int)size, CHECK_FILE_SIZE);
+		free (buf);
+		return -1;
+	}
+	p = buf;
+	if (memcmp (p, mem + BENCH_DATA_ADDR + 0x600000, CHECK_WRITE_SIZE) != 0) {
+		ret = -1;
+	}
+	p += CHECK_WRITE_SIZE;
+	for (i = 0; i < CHECK_SEGS; i++) {
+		if (memcmp (p, mem + check_segs[i].addr, check_segs[i].len) != 0) {
+			printf ("check segment %d differs in the file\n", i);
+			ret = -1;
+		}
+		p += check_segs[i].len;
+	}
+	if (memcmp (mem + CHECK_READ_ADDR, buf, CHECK_READ_SIZE) != 0) {
+		printf ("check read differs from the file\n");
+		ret = -1;
+	}
+	free (buf);
+	return ret;
+}
+
+/* Run each call on the simulated target and check the answers and the
+   host file.  */
+static int
+bench_check (const struct sim_target_cfg *tmpl)
+{
+	struct sim_target_cfg cfg = *tmpl;
+	struct check_prog prog;
+	struct halt_info info;
+	struct semihost *sh;
+	struct target *tgt;
+	unsigned char *mem, *iov;
+	unsigned int i;
+	int j, ret = 0;
+
+	memset (&prog, 0, sizeof (prog));
+	cfg.latency_us = 0;
+	cfg.bytes_per_us = 0;
+	cfg.program = check_program;
+	cfg.priv = &prog;
+	tgt = sim_target_open (&cfg);
+	if (tgt == NULL) {
+		return -1;
+	}
+	sh = semihost_create (tgt, NULL);
+	if (sh == NULL) {
+		sim_target_close (tgt);
+		return -1;
+	}
+	mem = sim_target_memory (tgt, NULL);
+	strcpy ((char *)mem + BENCH_PATH_ADDR, CHECK_FILE);
+	strcpy ((char *)mem + CHECK_MISSING_ADDR, CHECK_MISSING);
+	for (i = BENCH_DATA_ADDR; i < CHECK_READ_ADDR; i++) {
+		mem[i] = check_pattern (i);
+	}
+	iov = mem + BENCH_IOV_ADDR;
+	for (i = 0; i < CHECK_SEGS; i++) {
+		for (j = 0; j < 4; j++) {
+			iov[i * 16 + j] = (unsigned char)(check_segs[i].fd >> (j * 8));
+			iov[i * 16 + 4 + j] = (unsigned char)(check_segs[i].len >> (j * 8));
+		}
+		for (j = 0; j < 8; j++) {
+			iov[i * 16 + 8 + j] = (unsigned char)(check_segs[i].addr >> (j * 8));
+		}
+	}
+	remove (CHECK_MISSING);
+
+	target_resume (tgt);
+	while (1) {
+		if (target_check_debug (tgt, &info) < 0) {
+			ret = -1;
+			break;
+		}
+		if (info.reason == DBG_REASON_RUNNING) {
+			continue;
+		}
+		if (info.reason != DBG_REASON_FILEIO) {
+			break;
+		}
+		if (semihost_handle (sh, &info) < 0) {
+			ret = -1;
+			break;
+		}
+	}
+	semihost_destroy (sh);
+	if (ret == 0 && (prog.failed || prog.issued != CHECK_CALLS || check_verify (mem) < 0)) {
+		ret = -1;
+	}
+	sim_target_close (tgt);
+	remove (CHECK_FILE);
+	return ret;
+}
+
+struct bench_result
+{
+	unsigned int calls;
+	U64 bytes;
+	U64 us;
+	unsigned int transactions;
+	unsigned int failed;
+};
+
+static int
+bench_run (enum bench_mix mix, const struct sim_target_cfg *tmpl, unsigned int calls,
+		   unsigned int size, struct bench_result *res)
+{
+	struct sim_target_cfg cfg = *tmpl;
+	struct sim_target_stats stats;
+	struct semihost_stats sh_stats;
+	struct bench_prog prog;
+	struct halt_info info;
+	struct semihost *sh;
+	struct target *tgt;
+	U64 start;
+	int ret = 0;
+
+	memset (&prog, 0, sizeof (prog));
+	memset (res, 0, sizeof (struct bench_result));
+	prog.mix = mix;
+	prog.calls = calls;
+	prog.size = size;
+	cfg.program = bench_program;
+	cfg.priv = &prog;
+
+	if ((mix == BENCH_MIX_READ || mix == BENCH_MIX_OPEN_CLOSE) && bench_prepare_file (size) < 0) {
+		return -1;
+	}
+	tgt = sim_target_open (&cfg);
+	if (tgt == NULL) {
+		return -1;
+	}
+	sh = semihost_create (tgt, NULL);
+	if (sh == NULL) {
+		sim_target_close (tgt);
+		return -1;
+	}
+	/* The first descriptor opened by the target.  */
+	bench_prepare_memory (tgt, 3, size);
+
+	start = host_time_us ();
+	target_resume (tgt);
+	while (1) {
+		if (target_check_debug (tgt, &info) < 0) {
+			ret = -1;
+			break;
+		}
+		if (info.reason == DBG_REASON_RUNNING) {
+			continue;
+		}
+		if (info.reason != DBG_REASON_FILEIO) {
+			break;
+		}
+		if (semihost_handle (sh, &info) < 0) {
+			ret = -1;
+			break;
+		}
+	}
+	semihost_flush (sh);
+	res->us = host_time_us () - start;
+
+	semihost_get_stats (sh, &sh_stats);
+	sim_target_get_stats (tgt, &stats);
+	res->calls = sh_stats.calls;
+	res->bytes = prog.bytes;
+	res->transactions = stats.transactions;
+	res->failed = prog.failed;
+	semihost_destroy (sh);
+	sim_target_close (tgt);
+	remove (BENCH_FILE);
+	return ret;
+}
+
+static void
+usage (const char *prog)
+{
+	int i;
+
+	printf ("Usage: %s [-m mix] [-n calls] [-s size] [-l latency_us] [-b bytes_per_us] "
+			"[-t min_calls_per_s]\n", prog);
+	printf ("  mix: all");
+	for (i = 0; i < BENCH_MIX_NUM; i++) {
+		printf (", %s", bench_mix_names[i]);
+	}
+	printf ("\n");
+}
+
+int
+main (int argc, char **argv)
+{
+	struct sim_target_cfg cfg;
+	struct bench_result res;
+	unsigned int calls = 10000, size = 256;
+	double min_rate = 0, rate;
+	int i, mix = -1, failed = 0;
+
+	memset (&cfg, 0, sizeof (cfg));
+	cfg.mem_size = BENCH_MEM_SIZE;
+	cfg.xlen = 32;
+	cfg.latency_us = 20;
+
+	for (i = 1; i + 1 < argc; i += 2) {
+		if (strcmp (argv[i], "-m") == 0) {
+			for (mix = 0; mix < BENCH_MIX_NUM && strcmp (argv[i + 1], bench_mix_names[mix]); mix++)
+				;
+			if (mix == BENCH_MIX_NUM) {
+				mix = strcmp (argv[i + 1], "all") == 0 ? -1 : BENCH_MIX_NUM;
+			}
+		} else if (strcmp (argv[i], "-n") == 0) {
+			calls = (unsigned int)strtoul (argv[i + 1], NULL, 0);
+		} else if (strcmp (argv[i], "-s") == 0) {
+			size = (unsigned int)strtoul (argv[i + 1], NULL, 0);
+		} else if (strcmp (argv[i], "-l") == 0) {
+			cfg.latency_us = (unsigned int)strtoul (argv[i + 1], NULL, 0);
+		} else if (strcmp (argv[i], "-b") == 0) {
+			cfg.bytes_per_us = (unsigned int)strtoul (argv[i + 1], NULL, 0);
+		} else if (strcmp (argv[i], "-t") == 0) {
+			min_rate = atof (argv[i + 1]);
+		} else {
+			break;
+		}
+	}
+	if (i < argc || mix == BENCH_MIX_NUM || calls == 0 || size == 0 || size > BENCH_MAX_SIZE) {
+		usage (argv[0]);
+		return 2;
+	}
+
+	if (bench_check (&cfg) < 0) {
+		printf ("check failed\n");
+		return 1;
+	}
+	printf ("check: %d calls answered, writev of %d segments in %u bytes\n\n", CHECK_CALLS,
+			CHECK_SEGS, CHECK_WRITEV_SIZE);
+
+	printf ("latency %u us, bandwidth %u bytes/us, %u calls, %u bytes each\n\n",
+			cfg.latency_us, cfg.bytes_per_us, calls, size);
+	printf ("%-12s %10s %10s %12s %10s %12s\n", "mix", "calls", "ms", "calls/s", "MB/s", "link/call");
+	for (i = 0; i < BENCH_MIX_NUM; i++) {
+		if (mix >= 0 && mix != i) {
+			continue;
+		}
+		if (bench_run ((enum bench_mix)i, &cfg, calls, size, &res) < 0 || res.failed) {
+			printf ("%-12s failed, %u syscalls failed\n", bench_mix_names[i], res.failed);
+			failed++;
+			continue;
+		}
+		rate = res.us ? res.calls * 1000000.0 / res.us : 0;
+		printf ("%-12s %10u %10llu %12.1f %10.2f %12.1f\n", bench_mix_names[i], res.calls,
+				(unsigned long long)(res.us / 1000), rate, res.us ? (double)res.bytes / res.us : 0,
+				(double)res.transactions / res.calls);
+		if (rate < min_rate) {
+			printf ("%-12s is below %.1f calls/s\n", bench_mix_names[i], min_rate);
+			failed++;
+		}
+	}
+	return failed ? 1 : 0;
+}
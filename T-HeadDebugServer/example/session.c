@@ -0,0 +1,442 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include "session.h"
+#include "mem_access.h"
+#include "smp.h"
+
+struct dbg_session *
+session_create (struct target *tgt)
+{
+    struct dbg_session *s;
+
+    if (tgt == NULL) {
+        return NULL;
+    }
+    s = calloc (1, sizeof (struct dbg_session));
+    if (s == NULL) {
+        return NULL;
+    }
+    s->tgt = tgt;
+    mem_access_init (tgt);
+    s->mcache = mem_cache_create (tgt, 0);
+    if (s->mcache == NULL) {
+        free (s);
+        return NULL;
+    }
+    if (host_mutex_init (&s->lock) < 0) {
+        mem_cache_destroy (s->mcache);
+        free (s);
+        return NULL;
+    }
+    s->rcache = reg_cache_create (tgt);
+    s->bpm = bkpt_mgr_create (tgt);
+    s->poller = halt_poller_create (tgt, &s->lock);
+    if (s->rcache == NULL || s->bpm == NULL || s->poller == NULL) {
+        halt_poller_destroy (s->poller);
+        host_mutex_destroy (&s->lock);
+        bkpt_mgr_destroy (s->bpm);
+        reg_cache_destroy (s->rcache);
+        mem_cache_destroy (s->mcache);
+        free (s);
+        return NULL;
+    }
+
+    /* Route memory access by regions, only for riscv.  */
+    s->router = rv_mem_router_create (tgt);
+    rv_mem_router_attach (s->router);
+    return s;
+}
+
+void
+session_destroy (struct dbg_session *s)
+{
+    if (s == NULL) {
+        return;
+    }
+    halt_poller_destroy (s->poller);
+    host_mutex_destroy (&s->lock);
+    rv_mem_router_destroy (s->router);
+    bkpt_mgr_destroy (s->bpm);
+    reg_cache_destroy (s->rcache);
+    mem_cache_destroy (s->mcache);
+    mem_access_exit (s->tgt);
+    free (s);
+}
+
+void
+session_enable_mem_cache (struct dbg_session *s, int en)
+{
+    if (s == NULL) {
+        return;
+    }
+    mem_cache_enable (s->mcache, en);
+}
+
+int
+session_enable_reg_cache (struct dbg_session *s, int en)
+{
+    if (s == NULL) {
+        return -1;
+    }
+    return reg_cache_enable (s->rcache, en);
+}
+
+int
+session_enable_lazy_breakpoints (struct dbg_session *s, int en)
+{
+    if (s == NULL) {
+        return -1;
+    }
+    mem_cache_invalidate (s->mcache);
+    return bkpt_mgr_set_lazy (s->bpm, en);
+}
+
+int
+session_enable_cache_flush (struct dbg_session *s, int en)
+{
+    if (s == NULL) {
+        return -1;
+    }
+    return bkpt_mgr_enable_cache_flush (s->bpm, en);
+}
+
+int
+session_set_mem_regions (struct dbg_session *s, const char *spec)
+{
+    if (s == NULL || s->router == NULL) {
+        return -1;
+    }
+    return rv_mem_region_parse (s->router, spec);
+}
+
+int
+session_set_mem_mode (struct dbg_session *s, enum target_riscv_mem_access_mode mode)
+{
+    int ret;
+
+    if (s == NULL || s->router == NULL) {
+        return -1;
+    }
+    LOCK (&s->lock);
+    ret = rv_mem_router_set_default (s->router, mode);
+    UNLOCK (&s->lock);
+    return ret;
+}
+
+/* Everything cached is only valid while the CPU stays halted.  */
+static void
+session_invalidate (struct dbg_session *s)
+{
+    mem_cache_invalidate (s->mcache);
+    reg_cache_invalidate (s->rcache);
+}
+
+/* Write back dirty registers and lazy breakpoints before the CPU runs
+   again, it must not run with stale state.  */
+static int
+session_flush (struct dbg_session *s)
+{
+    int ret = reg_cache_flush (s->rcache);
+
+    if (bkpt_mgr_sync (s->bpm) < 0) {
+        ret = -1;
+    }
+    session_invalidate (s);
+    return ret;
+}
+
+int
+session_read_memory (struct dbg_session *s, U64 addr, unsigned char *buff, unsigned int size)
+{
+    int ret;
+
+    if (s == NULL) {
+        return -1;
+    }
+    ret = mem_cache_read (s->mcache, addr, buff, size);
+    if (ret >= 0) {
+        /* Show the original instructions, not the soft breakpoints.  */
+        bkpt_mgr_check_mem_read (s->bpm, addr, buff, size);
+    }
+    return ret;
+}
+
+int
+session_write_memory (struct dbg_session *s, U64 addr, unsigned char *buff, unsigned int size)
+{
+    if (s == NULL) {
+        return -1;
+    }
+    return mem_cache_write (s->mcache, addr, buff, size);
+}
+
+int
+session_breakpoint_add (struct dbg_session *s, U64 address,
+                        unsigned int length, enum bkpt_type type)
+{
+    if (s == NULL) {
+        return -1;
+    }
+    /* Soft breakpoints are written under the memory cache.  */
+    mem_cache_invalidate (s->mcache);
+    return bkpt_mgr_breakpoint_add (s->bpm, address, length, type);
+}
+
+int
+session_breakpoint_remove (struct dbg_session *s, U64 address)
+{
+    if (s == NULL) {
+        return -1;
+    }
+    mem_cache_invalidate (s->mcache);
+    return bkpt_mgr_breakpoint_remove (s->bpm, address);
+}
+
+int
+session_breakpoint_add_batch (struct dbg_session *s, struct breakpoint *bps, int count)
+{
+    if (s == NULL) {
+        return -1;
+    }
+    mem_cache_invalidate (s->mcache);
+    return bkpt_mgr_breakpoint_add_batch (s->bpm, bps, count);
+}
+
+int
+session_breakpoint_remove_batch (struct dbg_session *s, const U64 *addresses, int count)
+{
+    if (s == NULL) {
+        return -1;
+    }
+    mem_cache_invalidate (s->mcache);
+    return bkpt_mgr_breakpoint_remove_batch (s->bpm, addresses, count);
+}
+
+int
+session_read_cpu_reg (struct dbg_session *s, struct reg *reg)
+{
+    if (s == NULL) {
+        return -1;
+    }
+    return reg_cache_read (s->rcache, reg);
+}
+
+int
+session_write_cpu_reg (struct dbg_session *s, struct reg const *reg)
+{
+    if (s == NULL) {
+        return -1;
+    }
+    return reg_cache_write (s->rcache, reg);
+}
+
+/* Let the target run and watch it for halt.  */
+static int
+session_run (struct dbg_session *s, int (*run) (struct target *))
+{
+    int ret;
+
+    LOCK (&s->lock);
+    ret = run (s->tgt);
+    if (ret >= 0) {
+        bkpt_mgr_run_done (s->bpm);
+    }
+    UNLOCK (&s->lock);
+    if (ret >= 0) {
+        halt_poller_arm (s->poller);
+    }
+    return ret;
+}
+
+int
+session_resume (struct dbg_session *s)
+{
+    if (s == NULL) {
+        return -1;
+    }
+    if (session_flush (s) < 0) {
+        return -1;
+    }
+    return session_run (s, target_resume);
+}
+
+int
+session_single_step (struct dbg_session *s)
+{
+    if (s == NULL) {
+        return -1;
+    }
+    if (session_flush (s) < 0) {
+        return -1;
+    }
+    return session_run (s, target_single_step);
+}
+
+int
+session_resume_cpus (struct dbg_session *s, U32 mask)
+{
+    int cur, ret;
+
+    if (s == NULL) {
+        return -1;
+    }
+    if (session_flush (s) < 0) {
+        return -1;
+    }
+    LOCK (&s->lock);
+    /* The resumereq of the DM skips the cache flush of target_resume,
+       the patched code needs it, so resume them one by one then.  */
+    if (bkpt_mgr_flush_pending (s->bpm)) {
+        ret = target_resume_cpus_one_by_one (s->tgt, mask);
+        if (ret >= 0) {
+            bkpt_mgr_run_done (s->bpm);
+        }
+    } else {
+        ret = target_resume_cpus (s->tgt, mask);
+    }
+    cur = target_get_current_cpu (s->tgt);
+    UNLOCK (&s->lock);
+    /* The poller watches the current cpu only.  */
+    if (ret >= 0 && cur >= 0 && cur < 32 && (mask & (1u << cur))) {
+        halt_poller_arm (s->poller);
+    }
+    return ret;
+}
+
+int
+session_halt_cpus (struct dbg_session *s, U32 mask)
+{
+    int ret;
+
+    if (s == NULL) {
+        return -1;
+    }
+    LOCK (&s->lock);
+    ret = target_halt_cpus (s->tgt, mask);
+    UNLOCK (&s->lock);
+    return ret;
+}
+
+int
+session_halt (struct dbg_session *s)
+{
+    int ret;
+
+    if (s == NULL) {
+        return -1;
+    }
+    /* The poller reports the halt.  */
+    LOCK (&s->lock);
+    ret = target_halt (s->tgt);
+    UNLOCK (&s->lock);
+    return ret;
+}
+
+int
+session_wait_halt (struct dbg_session *s, struct halt_info *info, int timeout_ms)
+{
+    if (s == NULL) {
+        return -1;
+    }
+    return halt_poller_wait (s->poller, info, timeout_ms);
+}
+
+void
+session_lock (struct dbg_session *s)
+{
+    if (s) {
+        LOCK (&s->lock);
+    }
+}
+
+void
+session_unlock (struct dbg_session *s)
+{
+    if (s) {
+        UNLOCK (&s->lock);
+    }
+}
+
+int
+session_reset (struct dbg_session *s, int type, void *data)
+{
+    int ret;
+
+    if (s == NULL) {
+        return -1;
+    }
+    halt_poller_disarm (s->poller);
+    LOCK (&s->lock);
+    session_invalidate (s);
+    ret = target_reset (s->tgt, type, data);
+    UNLOCK (&s->lock);
+    return ret;
+}
+
+int
+session_select_cpu (struct dbg_session *s, int cpu)
+{
+    int ret;
+
+    if (s == NULL) {
+        return -1;
+    }
+    LOCK (&s->lock);
+    /* Dirty registers belong to the current cpu.  */
+    ret = reg_cache_flush (s->rcache);
+    if (ret >= 0) {
+        /* The view of memory may differ between cpus(MMU, TCM).  */
+        mem_cache_invalidate (s->mcache);
+        ret = target_select_cpu (s->tgt, cpu);
+    }
+    if (ret >= 0) {
+        reg_cache_set_cpu (s->rcache, cpu);
+    }
+    UNLOCK (&s->lock);
+    return ret;
+}
+
+int
+session_get_stats (struct dbg_session *s, enum session_stats_type type, void *value)
+{
+    if (s == NULL || value == NULL) {
+        return -1;
+    }
+    switch (type) {
+    case SESSION_STATS_MEM_CACHE:
+        mem_cache_get_stats (s->mcache, (struct mem_cache_stats *)value);
+        return 0;
+    case SESSION_STATS_REG_CACHE:
+        reg_cache_get_stats (s->rcache, (struct reg_cache_stats *)value);
+        return 0;
+    case SESSION_STATS_BKPT:
+        bkpt_mgr_get_stats (s->bpm, (struct bkpt_mgr_stats *)value);
+        return 0;
+    case SESSION_STATS_HALT_POLLER:
+        halt_poller_get_stats (s->poller, (struct halt_poller_stats *)value);
+        return 0;
+    case SESSION_STATS_MEM_REGION:
+        if (s->router == NULL) {
+            return -1;
+        }
+        rv_mem_router_get_stats (s->router, (struct rv_mem_region_stats *)value);
+        return 0;
+    default:
+        return -1;
+    }
+}
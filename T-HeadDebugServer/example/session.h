@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: session.h
+// function description: a debug session on top of the target interfaces,
+//                       it keeps host side caches coherent with run control.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_SESSION_H__
+#define __DEBUGGER_SERVER_EXAMPLE_SESSION_H__
+
+#include "dbg-target.h"
+#include "bkpt_mgr.h"
+#include "halt_poller.h"
+#include "host_os.h"
+#include "mem_cache.h"
+#include "reg_cache.h"
+#include "rv_mem_region.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----- The type for session_get_stats -----*/
+enum session_stats_type
+{
+	SESSION_STATS_MEM_CACHE = 0,    ///<get struct mem_cache_stats
+	SESSION_STATS_MEM_REGION,       ///<get struct rv_mem_region_stats, only riscv
+	SESSION_STATS_REG_CACHE,        ///<get struct reg_cache_stats
+	SESSION_STATS_BKPT,             ///<get struct bkpt_mgr_stats
+	SESSION_STATS_HALT_POLLER,      ///<get struct halt_poller_stats
+};
+
+/**
+\brief The debug session
+*/
+struct dbg_session
+{
+    struct target *tgt;             ///< The handle of target
+    struct mem_cache *mcache;       ///< Memory cache, valid while halted
+    struct reg_cache *rcache;       ///< Register cache, valid while halted
+    struct bkpt_mgr *bpm;           ///< Breakpoints and watchpoints
+    struct halt_poller *poller;     ///< Checks for halt while running
+    hostMutex lock;                 ///< Held while accessing the target, see session_lock
+    struct rv_mem_router *router;   ///< Memory access mode by region, only riscv
+};
+
+/**
+  \brief        Create a debug session for the target
+  \param[in]    tgt, the handle of target which has been opened
+  \return       A handle for success, otherwise return NULL
+*/
+struct dbg_session *session_create (struct target *tgt);
+
+/**
+  \brief        Destroy the debug session, the target is not closed
+  \param[in]    s, the handle of session
+  \return       None
+*/
+void session_destroy (struct dbg_session *s);
+
+/**
+  \brief        Enable or disable the memory cache of the session
+  \param[in]    s, the handle of session
+  \param[in]    en, bool type, enable(1) or disable(0)
+  \return       None
+*/
+void session_enable_mem_cache (struct dbg_session *s, int en);
+
+/**
+  \brief        Enable or disable the register cache of the session, dirty
+                registers are written back before resume or single step
+  \param[in]    s, the handle of session
+  \param[in]    en, bool type, enable(1) or disable(0)
+  \return       zero for success, negative for error
+*/
+int session_enable_reg_cache (struct dbg_session *s, int en);
+
+/**
+  \brief        Enable or disable lazy soft breakpoints of the session, they
+                are written to the target before resume or single step,
+                see bkpt_mgr_set_lazy
+  \param[in]    s, the handle of session
+  \param[in]    en, bool type, enable(1) or disable(0)
+  \return       zero for success, negative for error
+*/
+int session_enable_lazy_breakpoints (struct dbg_session *s, int en);
+
+/**
+  \brief        Enable or disable cache flush while doing single-step or
+                resuming, see bkpt_mgr_enable_cache_flush
+  \param[in]    s, the handle of session
+  \param[in]    en, bool type, enable(1) or disable(0)
+  \return       zero for success, negative for error
+*/
+int session_enable_cache_flush (struct dbg_session *s, int en);
+
+/**
+  \brief        Add regions of memory access mode, only for riscv
+  \param[in]    s, the handle of session
+  \param[in]    spec, see rv_mem_region_parse
+  \return       zero for success, negative for error
+*/
+int session_set_mem_regions (struct dbg_session *s, const char *spec);
+
+/**
+  \brief        Set the memory access mode out of the regions, only for riscv
+  \param[in]    s, the handle of session
+  \param[in]    mode, see rv_mem_router_set_default
+  \return       zero for success, negative for error
+*/
+int session_set_mem_mode (struct dbg_session *s, enum target_riscv_mem_access_mode mode);
+
+/**
+  \brief        Read memory, see target_read_memory
+  \return       zero for success, negative for error
+*/
+int session_read_memory (struct dbg_session *s, U64 addr, unsigned char *buff, unsigned int size);
+
+/**
+  \brief        Write memory, see target_write_memory
+  \return       zero for success, negative for error
+*/
+int session_write_memory (struct dbg_session *s, U64 addr, unsigned char *buff, unsigned int size);
+
+/**
+  \brief        Add breakpoint, see bkpt_mgr_breakpoint_add. Use s->bpm
+                for watchpoints and lookups
+  \return       zero for success, negative for error
+*/
+int session_breakpoint_add (struct dbg_session *s, U64 address,
+                            unsigned int length, enum bkpt_type type);
+
+/**
+  \brief        Remove breakpoint, see bkpt_mgr_breakpoint_remove
+  \return       zero for success, negative for error
+*/
+int session_breakpoint_remove (struct dbg_session *s, U64 address);
+
+/**
+  \brief        Add breakpoints in one batch, see bkpt_mgr_breakpoint_add_batch
+  \return       zero for success, negative for the count of failed breakpoints
+*/
+int session_breakpoint_add_batch (struct dbg_session *s, struct breakpoint *bps, int count);
+
+/**
+  \brief        Remove breakpoints in one batch, see bkpt_mgr_breakpoint_remove_batch
+  \return       zero for success, negative for the count of failed breakpoints
+*/
+int session_breakpoint_remove_batch (struct dbg_session *s, const U64 *addresses, int count);
+
+/**
+  \brief        Read cpu register, see target_read_cpu_reg
+  \return       zero for success, negative for error
+*/
+int session_read_cpu_reg (struct dbg_session *s, struct reg *reg);
+
+/**
+  \brief        Write cpu register, see target_write_cpu_reg. With the register
+                cache enabled, it reaches the target on the next resume or step
+  \return       zero for success, negative for error
+*/
+int session_write_cpu_reg (struct dbg_session *s, struct reg const *reg);
+
+/**
+  \brief        Resume the target, see target_resume
+  \return       zero for success, negative for error
+*/
+int session_resume (struct dbg_session *s);
+
+/**
+  \brief        Do single step, see target_single_step
+  \return       zero for success, negative for error
+*/
+int session_single_step (struct dbg_session *s);
+
+/**
+  \brief        Resume a group of cpus together, see target_resume_cpus. They are
+                resumed one by one if patched code needs the cache flush. The
+                halt is watched only if the current cpu is in the group
+  \param[in]    s, the handle of session
+  \param[in]    mask, bit n is set for cpu n, see smp_get_group_mask
+  \return       zero for success, negative for error
+*/
+int session_resume_cpus (struct dbg_session *s, U32 mask);
+
+/**
+  \brief        Halt a group of cpus together, see target_halt_cpus
+  \param[in]    s, the handle of session
+  \param[in]    mask, bit n is set for cpu n, see smp_get_group_mask
+  \return       zero for success, negative for error
+*/
+int session_halt_cpus (struct dbg_session *s, U32 mask);
+
+/**
+  \brief        Halt the target, see target_halt. Use session_wait_halt for
+                the halt informations
+  \return       zero for success, negative for error
+*/
+int session_halt (struct dbg_session *s);
+
+/**
+  \brief        Wait for the target to halt after session_resume or
+                session_single_step, it is checked by a background thread
+                instead of calling target_check_debug in a loop
+  \param[in]    s, the handle of session
+  \param[out]   info, the halt informations, could be NULL
+  \param[in]    timeout_ms, negative for waiting forever
+  \return       zero for halted, positive for timeout, negative for error
+*/
+int session_wait_halt (struct dbg_session *s, struct halt_info *info, int timeout_ms);
+
+/**
+  \brief        Take the lock of target access, other threads must hold it
+                when accessing the target while it is running
+  \param[in]    s, the handle of session
+  \return       None
+*/
+void session_lock (struct dbg_session *s);
+
+/**
+  \brief        Release the lock of target access
+  \param[in]    s, the handle of session
+  \return       None
+*/
+void session_unlock (struct dbg_session *s);
+
+/**
+  \brief        Reset target, see target_reset
+  \return       zero for success, negative for error
+*/
+int session_reset (struct dbg_session *s, int type, void *data);
+
+/**
+  \brief        Select the cpu, see target_select_cpu
+  \return       zero for success, negative for error
+*/
+int session_select_cpu (struct dbg_session *s, int cpu);
+
+/**
+  \brief        Get the statistics of the session
+  \param[in]    s, the handle of session
+  \param[in]    type, statistics type
+  \param[out]   value, space is malloced by caller
+  \return       zero for success, negative for error
+*/
+int session_get_stats (struct dbg_session *s, enum session_stats_type type, void *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_SESSION_H__
@@ -0,0 +1,879 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef SIM_LINK_TARGET
+/* The interfaces of libTarget are defined here.  */
+#ifndef TARGET_EXPORTS
+#define TARGET_EXPORTS
+#endif
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "sim_link.h"
+#include "host_os.h"
+#include "regNo.h"
+
+/* The HCR bit of debug request.  */
+#define SIM_HCR_DR              0x8000
+
+struct sim_link
+{
+    struct sim_link_cfg cfg;
+    unsigned char *mem;
+    struct sim_link_stats stats;
+
+    /* The hart/cpu.  */
+    int halted;
+    int resumeack;
+    U64 gpr[32];
+    U64 pc;
+    U32 psr;
+    U32 wbbr;
+
+    /* RISC-V DM.  */
+    U64 dmi_result;             ///< The output of the next DMI scan
+    int dmi_inflight;           ///< The last DMI op is not done yet
+    int dmi_busy;               ///< Sticky busy, cleared by dtmcs.dmireset
+    U32 dmcontrol;
+    U32 data[2];
+    U32 cmderr;
+    U32 sbcs;                   ///< The writable fields of sbcs
+    U32 sberror;
+    U64 sbaddress;
+    U32 sbdata[2];
+
+    /* C-SKY HAD.  */
+    U32 hsr;
+    U32 ddcaddr;
+};
+
+static struct sim_link_cfg sim_link_default = {
+    SIM_LINK_RISCV, 64, 1024 * 1024, 0, 0, 0
+};
+
+void
+sim_link_set_cfg (const struct sim_link_cfg *cfg)
+{
+    if (cfg && cfg->mem_size) {
+        sim_link_default = *cfg;
+    }
+}
+
+void
+sim_link_get_stats (void *handle, struct sim_link_stats *stats)
+{
+    struct sim_link *sl = handle;
+
+    if (sl && stats) {
+        *stats = sl->stats;
+    }
+}
+
+/* One USB transfer, memory access costs the bandwidth as well. Too short
+   for the sleep of host.  */
+static void
+sim_link_transfer (struct sim_link *sl, unsigned int bytes)
+{
+    U64 cost = sl->cfg.latency_us, start;
+
+    if (sl->cfg.bytes_per_us) {
+        cost += bytes / sl->cfg.bytes_per_us;
+    }
+    sl->stats.transfers++;
+    sl->stats.bytes += bytes;
+    sl->stats.link_us += cost;
+    if (cost == 0) {
+        return;
+    }
+    start = host_time_us ();
+    while (host_time_us () - start < cost)
+        ;
+}
+
+static int
+sim_link_range (struct sim_link *sl, U64 addr, U64 length)
+{
+    return addr <= sl->cfg.mem_size && length <= sl->cfg.mem_size - addr;
+}
+
+static const char *
+sim_link_name (void)
+{
+    return SIM_LINK_NAME;
+}
+
+static struct sim_link *
+sim_link_create (const struct sim_link_cfg *cfg)
+{
+    struct sim_link *sl;
+
+    sl = calloc (1, sizeof (struct sim_link));
+    if (sl == NULL) {
+        return NULL;
+    }
+    sl->cfg = *cfg;
+    sl->mem = calloc (1, sl->cfg.mem_size);
+    if (sl->mem == NULL) {
+        free (sl);
+        return NULL;
+    }
+    return sl;
+}
+
+static void *
+sim_link_open (dbg_server_cfg_t *cfg, void *unique)
+{
+    (void)cfg;
+    (void)unique;
+    return sim_link_create (&sim_link_default);
+}
+
+static void
+sim_link_close (void *handle)
+{
+    struct sim_link *sl = handle;
+
+    if (sl) {
+        free (sl->mem);
+        free (sl);
+    }
+}
+
+static int
+sim_link_config (void *handle, enum LINK_CONFIG_KEY key, unsigned int value)
+{
+    struct sim_link *sl = handle;
+
+    if (sl == NULL) {
+        return -1;
+    }
+    if (key == LINK_CONFIG_ISA_VER) {
+        sl->cfg.arch = value >= 4 ? SIM_LINK_RISCV : SIM_LINK_CSKY;
+        sl->cfg.xlen = value == 5 ? 64 : 32;
+    }
+    return 0;
+}
+
+static int
+sim_link_memory_read (void *handle, uint64_t addr, int xlen, uint8_t *buff, int length, int mode)
+{
+    struct sim_link *sl = handle;
+
+    (void)xlen;
+    (void)mode;
+    if (sl == NULL || buff == NULL || length < 0 || !sim_link_range (sl, addr, length)) {
+        return -1;
+    }
+    sim_link_transfer (sl, length);
+    memcpy (buff, sl->mem + addr, length);
+    return 0;
+}
+
+static int
+sim_link_memory_write (void *handle, uint64_t addr, int xlen, uint8_t *buff, int length, int mode)
+{
+    struct sim_link *sl = handle;
+
+    (void)xlen;
+    (void)mode;
+    if (sl == NULL || buff == NULL || length < 0 || !sim_link_range (sl, addr, length)) {
+        return -1;
+    }
+    sim_link_transfer (sl, length);
+    memcpy (sl->mem + addr, buff, length);
+    return 0;
+}
+
+/* C-SKY HAD: HCR.DR halts the cpu, HACR with GO and EX resumes it, HSR
+   shows the debug mode, the SCR registers are valid while halted.  */
+static int
+sim_had_read (struct sim_link *sl, int regno, U32 *value)
+{
+    switch (regno) {
+    case HID:
+        *value = SIM_LINK_HID;
+        return 0;
+    case HSR:
+        *value = sl->hsr | (sl->halted ? 0x2 : 0x0);
+        return 0;
+    case SCRPC:
+        *value = (U32)sl->pc;
+        return sl->halted ? 0 : -1;
+    case SCRPSR:
+        *value = sl->psr;
+        return sl->halted ? 0 : -1;
+    case SCRWBBR:
+        *value = sl->wbbr;
+        return sl->halted ? 0 : -1;
+    case DDCADDR:
+        *value = sl->ddcaddr;
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+static int
+sim_had_write (struct sim_link *sl, int regno, U32 value)
+{
+    switch (regno) {
+    case HCR:
+        if (value & SIM_HCR_DR) {
+            sl->halted = 1;
+            sl->hsr |= HSR_BIT_DRO;
+        }
+        return 0;
+    case HACR:
+        if ((value & (GOBIT | EXBIT)) == (GOBIT | EXBIT)) {
+            sl->halted = 0;
+            sl->hsr &= ~HSR_BIT_DRO;
+        }
+        return 0;
+    case SCRPC:
+        sl->pc = value;
+        return sl->halted ? 0 : -1;
+    case SCRPSR:
+        sl->psr = value;
+        return sl->halted ? 0 : -1;
+    case SCRWBBR:
+        sl->wbbr = value;
+        return sl->halted ? 0 : -1;
+    case DDCADDR:
+        sl->ddcaddr = value;
+        return 0;
+    case DDCDATA:
+        /* Download by DDC, the address goes on.  */
+        if (!sim_link_range (sl, sl->ddcaddr, 4)) {
+            return -1;
+        }
+        memcpy (sl->mem + sl->ddcaddr, &value, 4);
+        sl->ddcaddr += 4;
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+static int
+sim_link_register_read (void *handle, int regno, uint8_t *buff, int nbyte)
+{
+    struct sim_link *sl = handle;
+    U32 value;
+
+    if (sl == NULL || buff == NULL || nbyte < 4 || sl->cfg.arch != SIM_LINK_CSKY) {
+        return -1;
+    }
+    sim_link_transfer (sl, 0);
+    if (sim_had_read (sl, regno, &value) < 0) {
+        return -1;
+    }
+    memcpy (buff, &value, 4);
+    return 0;
+}
+
+static int
+sim_link_register_write (void *handle, int regno, uint8_t *buff, int nbyte)
+{
+    struct sim_link *sl = handle;
+    U32 value;
+
+    if (sl == NULL || buff == NULL || nbyte < 4 || sl->cfg.arch != SIM_LINK_CSKY) {
+        return -1;
+    }
+    sim_link_transfer (sl, 0);
+    memcpy (&value, buff, 4);
+    return sim_had_write (sl, regno, value);
+}
+
+/* RISC-V DM: access register command on GPRs and dpc.  */
+static void
+sim_dm_command (struct sim_link *sl, U32 command)
+{
+    U32 regno = command & 0xffff, aarsize = (command >> 20) & 0x7;
+    U64 *reg;
+
+    if (sl->cmderr) {
+        return;
+    }
+    if ((command >> 24) != 0 || aarsize < 2 || aarsize > 3
+        || (aarsize == 3 && sl->cfg.xlen == 32)) {
+        sl->cmderr = 2;
+        return;
+    }
+    if (!sl->halted) {
+        sl->cmderr = 4;
+        return;
+    }
+    if (regno >= 0x1000 && regno < 0x1020) {
+        reg = &sl->gpr[regno - 0x1000];
+    } else if (regno == 0x7b1) {
+        reg = &sl->pc;
+    } else {
+        sl->cmderr = 3;
+        return;
+    }
+    if (!(command & (1 << 17))) {
+        return;
+    }
+    if (command & (1 << 16)) {
+        *reg = aarsize == 3 ? (U64)sl->data[1] << 32 | sl->data[0] : sl->data[0];
+        sl->gpr[0] = 0;
+    } else {
+        sl->data[0] = (U32)*reg;
+        sl->data[1] = aarsize == 3 ? (U32)(*reg >> 32) : 0;
+    }
+}
+
+/* RISC-V DM: one system bus access of sbaccess, then sbautoincrement.  */
+static void
+sim_dm_sb_access (struct sim_link *sl, int write)
+{
+    unsigned int size = 1u << ((sl->sbcs >> 17) & 0x7);
+
+    if (sl->sberror) {
+        return;
+    }
+    if (size > (unsigned int)sl->cfg.xlen / 8) {
+        sl->sberror = 4;
+        return;
+    }
+    if (sl->sbaddress & (size - 1)) {
+        sl->sberror = 3;
+        return;
+    }
+    if (!sim_link_range (sl, sl->sbaddress, size)) {
+        sl->sberror = 2;
+        return;
+    }
+    if (write) {
+        memcpy (sl->mem + sl->sbaddress, sl->sbdata, size);
+    } else {
+        sl->sbdata[0] = sl->sbdata[1] = 0;
+        memcpy (sl->sbdata, sl->mem + sl->sbaddress, size);
+    }
+    if (sl->sbcs & (1 << 16)) {
+        sl->sbaddress += size;
+    }
+}
+
+static U32
+sim_dm_read (struct sim_link *sl, U32 addr)
+{
+    U32 value;
+
+    switch (addr) {
+    case SIM_DM_DATA0:
+    case SIM_DM_DATA1:
+        return sl->data[addr - SIM_DM_DATA0];
+    case SIM_DM_DMCONTROL:
+        return sl->dmcontrol & 0x1;
+    case SIM_DM_DMSTATUS:
+        /* Version 0.13, authenticated.  */
+        return 2 | (1 << 7) | (sl->halted ? 0x3 << 8 : 0x3 << 10)
+               | (sl->resumeack ? 0x3 << 16 : 0);
+    case SIM_DM_ABSTRACTCS:
+        return 2 | sl->cmderr << 8;
+    case SIM_DM_SBCS:
+        return 1u << 29 | sl->sbcs | sl->sberror << 12 | sl->cfg.xlen << 5
+               | (sl->cfg.xlen == 64 ? 0xf : 0x7);
+    case SIM_DM_SBADDRESS0:
+        return (U32)sl->sbaddress;
+    case SIM_DM_SBADDRESS1:
+        return (U32)(sl->sbaddress >> 32);
+    case SIM_DM_SBDATA0:
+        value = sl->sbdata[0];
+        if (sl->sbcs & (1 << 15)) {
+            sim_dm_sb_access (sl, 0);
+        }
+        return value;
+    case SIM_DM_SBDATA1:
+        return sl->sbdata[1];
+    default:
+        return 0;
+    }
+}
+
+static void
+sim_dm_write (struct sim_link *sl, U32 addr, U32 value)
+{
+    switch (addr) {
+    case SIM_DM_DATA0:
+    case SIM_DM_DATA1:
+        sl->data[addr - SIM_DM_DATA0] = value;
+        break;
+    case SIM_DM_DMCONTROL:
+        sl->dmcontrol = value;
+        if (!(value & 0x1)) {
+            break;
+        }
+        if (value & (1u << 31)) {
+            sl->halted = 1;
+        } else if ((value & (1 << 30)) && sl->halted) {
+            sl->halted = 0;
+            sl->resumeack = 1;
+        }
+        if (value & (1u << 31)) {
+            sl->resumeack = 0;
+        }
+        break;
+    case SIM_DM_ABSTRACTCS:
+        sl->cmderr &= ~((value >> 8) & 0x7);
+        break;
+    case SIM_DM_COMMAND:
+        sim_dm_command (sl, value);
+        break;
+    case SIM_DM_SBCS:
+        sl->sbcs = value & 0x1f8000;
+        sl->sberror &= ~((value >> 12) & 0x7);
+        break;
+    case SIM_DM_SBADDRESS0:
+        sl->sbaddress = (sl->sbaddress & ~(U64)0xffffffff) | value;
+        if (sl->sbcs & (1 << 20)) {
+            sim_dm_sb_access (sl, 0);
+        }
+        break;
+    case SIM_DM_SBADDRESS1:
+        sl->sbaddress = (sl->sbaddress & 0xffffffff) | (U64)value << 32;
+        break;
+    case SIM_DM_SBDATA0:
+        sl->sbdata[0] = value;
+        sim_dm_sb_access (sl, 1);
+        break;
+    case SIM_DM_SBDATA1:
+        sl->sbdata[1] = value;
+        break;
+    default:
+        break;
+    }
+}
+
+/* RISC-V DTM: IDCODE, DTMCS and DMI.  */
+static void
+sim_link_scan (struct sim_link *sl, struct jtag_scan *scan)
+{
+    U64 in = 0, out = 0;
+    U32 addr;
+    int i;
+
+    sl->stats.scans++;
+    for (i = scan->dr_len - 1; i >= 0; i--) {
+        in = in << 8 | scan->dr_w[i];
+    }
+    switch (scan->ir[0]) {
+    case JTAG_DTM_IR_IDCODE:
+        out = SIM_LINK_IDCODE;
+        break;
+    case JTAG_DTM_IR_DTMCS:
+        out = (sl->cfg.dmi_idle > 7 ? 7 : sl->cfg.dmi_idle) << 12 | SIM_LINK_ABITS << 4 | 1
+              | (sl->dmi_busy ? JTAG_DMI_STATUS_BUSY << 10 : 0);
+        if (in & JTAG_DTMCS_DMIRESET) {
+            sl->dmi_busy = 0;
+            sl->dmi_inflight = 0;
+            sl->dmi_result = 0;
+        }
+        break;
+    case JTAG_DTM_IR_DMI:
+        /* The op before is not done, this one is ignored until dmireset.  */
+        if (sl->dmi_busy || sl->dmi_inflight) {
+            sl->dmi_busy = 1;
+            sl->dmi_inflight = 0;
+            sl->stats.dmi_busy++;
+            out = JTAG_DMI_STATUS_BUSY;
+            break;
+        }
+        out = sl->dmi_result;
+        addr = (U32)(in >> 34) & ((1 << SIM_LINK_ABITS) - 1);
+        sl->dmi_result = 0;
+        if ((in & 0x3) != JTAG_DMI_OP_NOP && addr >= SIM_LINK_DM_SIZE) {
+            sl->dmi_result = JTAG_DMI_STATUS_FAILED;
+        } else if ((in & 0x3) == JTAG_DMI_OP_READ) {
+            sl->dmi_result = (U64)sim_dm_read (sl, addr) << 2;
+        } else if ((in & 0x3) == JTAG_DMI_OP_WRITE) {
+            sim_dm_write (sl, addr, (U32)(in >> 2));
+        }
+        sl->dmi_inflight = (in & 0x3) != JTAG_DMI_OP_NOP && scan->idle < sl->cfg.dmi_idle;
+        break;
+    default:
+        break;
+    }
+    for (i = 0; i < scan->dr_len; i++) {
+        scan->dr_r[i] = (unsigned char)(out >> (i * 8));
+    }
+}
+
+static int
+sim_link_jtag_operator (void *handle, int ir_len, unsigned char *ir,
+                        int dr_len, unsigned char *dr_r, unsigned char *dr_w, int read)
+{
+    struct sim_link *sl = handle;
+    struct jtag_scan scan;
+
+    if (sl == NULL || sl->cfg.arch != SIM_LINK_RISCV || ir_len <= 0
+        || ir_len > JTAG_SCAN_MAX_IR || dr_len <= 0 || dr_len > JTAG_SCAN_MAX_DR) {
+        return -1;
+    }
+    memset (&scan, 0, sizeof (scan));
+    scan.ir_len = ir_len;
+    memcpy (scan.ir, ir, ir_len);
+    scan.dr_len = dr_len;
+    memcpy (scan.dr_w, dr_w, dr_len);
+    sim_link_transfer (sl, 0);
+    /* The op before is done during the transfer.  */
+    sl->dmi_inflight = 0;
+    sim_link_scan (sl, &scan);
+    if (read) {
+        memcpy (dr_r, scan.dr_r, dr_len);
+    }
+    return 0;
+}
+
+static int
+sim_link_jtag_batch (void *handle, struct jtag_scan *scans, int count)
+{
+    struct sim_link *sl = handle;
+    int i;
+
+    if (sl == NULL || sl->cfg.arch != SIM_LINK_RISCV) {
+        return -1;
+    }
+    sim_link_transfer (sl, 0);
+    sl->dmi_inflight = 0;
+    for (i = 0; i < count; i++) {
+        sim_link_scan (sl, &scans[i]);
+    }
+    return 0;
+}
+
+static int
+sim_link_reset (void *handle, int hard)
+{
+    struct sim_link *sl = handle;
+
+    (void)hard;
+    if (sl == NULL) {
+        return -1;
+    }
+    sim_link_transfer (sl, 0);
+    sl->halted = 0;
+    sl->resumeack = 0;
+    sl->pc = 0;
+    memset (sl->gpr, 0, sizeof (sl->gpr));
+    return 0;
+}
+
+static const struct link_ops sim_link_ops = {
+    LINK_OPS_VERSION,
+    sizeof (struct link_ops),
+    sim_link_name,
+    NULL,                       /* init */
+    sim_link_open,
+    sim_link_close,
+    sim_link_config,
+    NULL,                       /* upgrade */
+    sim_link_memory_read,
+    sim_link_memory_write,
+    sim_link_register_read,
+    sim_link_register_write,
+    sim_link_jtag_operator,
+    sim_link_jtag_batch,
+    NULL,                       /* gpio_operator */
+    NULL,                       /* show_info */
+    sim_link_reset,
+    NULL,                       /* get_device_list */
+    NULL,                       /* get_device_list_with_vid_pid */
+};
+
+const struct link_ops *
+sim_link_get_ops (void)
+{
+    return &sim_link_ops;
+}
+
+#ifdef SIM_LINK_TARGET
+/* libTarget on the simulated link: each interface costs one transfer, the
+   program on the target runs while target_check_debug polls it.  */
+struct target
+{
+    struct sim_target_cfg cfg;
+    struct sim_link *sl;
+    enum target_debug_reason reason;
+    struct gdb_fileio_info fileio;
+    int answered;               ///< The File-I/O syscall is answered
+    int retcode;
+    int fileio_errno;
+    struct sim_target_stats stats;
+};
+
+struct target *
+sim_target_open (const struct sim_target_cfg *cfg)
+{
+    struct sim_link_cfg link_cfg;
+    struct target *tgt;
+
+    if (cfg == NULL || cfg->mem_size == 0) {
+        return NULL;
+    }
+    tgt = calloc (1, sizeof (struct target));
+    if (tgt == NULL) {
+        return NULL;
+    }
+    memset (&link_cfg, 0, sizeof (link_cfg));
+    link_cfg.arch = SIM_LINK_RISCV;
+    link_cfg.xlen = cfg->xlen == 64 ? 64 : 32;
+    link_cfg.mem_size = cfg->mem_size;
+    link_cfg.latency_us = cfg->latency_us;
+    link_cfg.bytes_per_us = cfg->bytes_per_us;
+    tgt->sl = sim_link_create (&link_cfg);
+    if (tgt->sl == NULL) {
+        free (tgt);
+        return NULL;
+    }
+    tgt->cfg = *cfg;
+    tgt->sl->halted = 1;
+    tgt->reason = DBG_REASON_DBGRQ;
+    return tgt;
+}
+
+void
+sim_target_close (struct target *tgt)
+{
+    if (tgt) {
+        sim_link_close (tgt->sl);
+        free (tgt);
+    }
+}
+
+unsigned char *
+sim_target_memory (struct target *tgt, unsigned int *size)
+{
+    if (size) {
+        *size = tgt ? tgt->cfg.mem_size : 0;
+    }
+    return tgt ? tgt->sl->mem : NULL;
+}
+
+int
+sim_target_fileio_result (struct target *tgt, int *retcode, int *fileio_errno)
+{
+    if (tgt == NULL || retcode == NULL || !tgt->answered) {
+        return -1;
+    }
+    *retcode = tgt->retcode;
+    if (fileio_errno) {
+        *fileio_errno = tgt->fileio_errno;
+    }
+    return 0;
+}
+
+void
+sim_target_get_stats (struct target *tgt, struct sim_target_stats *stats)
+{
+    if (tgt && stats) {
+        *stats = tgt->stats;
+        stats->transactions = tgt->sl->stats.transfers;
+        stats->bytes = tgt->sl->stats.bytes;
+        stats->link_us = tgt->sl->stats.link_us;
+    }
+}
+
+int
+target_read_memory (struct target *tgt, U64 addr, unsigned char *buff, unsigned int size)
+{
+    if (tgt == NULL || size > 0x7fffffff
+        || sim_link_memory_read (tgt->sl, addr, tgt->cfg.xlen, buff, (int)size, 0) < 0) {
+        return -1;
+    }
+    tgt->stats.mem_reads++;
+    return 0;
+}
+
+int
+target_write_memory (struct target *tgt, U64 addr, unsigned char *buff, unsigned int size)
+{
+    if (tgt == NULL || size > 0x7fffffff
+        || sim_link_memory_write (tgt->sl, addr, tgt->cfg.xlen, buff, (int)size, 0) < 0) {
+        return -1;
+    }
+    tgt->stats.mem_writes++;
+    return 0;
+}
+
+int
+target_check_debug (struct target *tgt, struct halt_info *info)
+{
+    int ret;
+
+    if (tgt == NULL || info == NULL) {
+        return -1;
+    }
+    sim_link_transfer (tgt->sl, 0);
+    tgt->stats.checks++;
+
+    /* The program runs until its next syscall.  */
+    if (!tgt->sl->halted && tgt->cfg.program) {
+        memset (&tgt->fileio, 0, sizeof (tgt->fileio));
+        ret = tgt->cfg.program (tgt->cfg.priv, tgt, &tgt->fileio);
+        if (ret != 0) {
+            tgt->sl->halted = 1;
+            tgt->answered = 0;
+            tgt->reason = ret > 0 ? DBG_REASON_FILEIO : DBG_REASON_BREAKPOINT;
+        }
+    }
+
+    memset (info, 0, sizeof (struct halt_info));
+    info->reason = tgt->sl->halted ? tgt->reason : DBG_REASON_RUNNING;
+    info->addr_len = tgt->cfg.xlen == 64 ? 8 : 4;
+    if (info->reason == DBG_REASON_FILEIO) {
+        info->data.fileio = tgt->fileio;
+    }
+    return 0;
+}
+
+int
+target_fileio_end (struct target *tgt, int retcode, int fileio_errno, int ctrl_c)
+{
+    if (tgt == NULL || !tgt->sl->halted || tgt->reason != DBG_REASON_FILEIO) {
+        return -1;
+    }
+    sim_link_transfer (tgt->sl, 0);
+    tgt->stats.fileio_ends++;
+    tgt->answered = 1;
+    tgt->retcode = retcode;
+    tgt->fileio_errno = fileio_errno;
+    if (ctrl_c) {
+        tgt->reason = DBG_REASON_DBGRQ;
+    }
+    return 0;
+}
+
+int
+target_resume (struct target *tgt)
+{
+    if (tgt == NULL) {
+        return -1;
+    }
+    sim_link_transfer (tgt->sl, 0);
+    tgt->sl->halted = 0;
+    tgt->sl->resumeack = 1;
+    return 0;
+}
+
+int
+target_halt (struct target *tgt)
+{
+    if (tgt == NULL) {
+        return -1;
+    }
+    sim_link_transfer (tgt->sl, 0);
+    if (!tgt->sl->halted) {
+        tgt->sl->halted = 1;
+        tgt->sl->resumeack = 0;
+        tgt->reason = DBG_REASON_DBGRQ;
+    }
+    return 0;
+}
+
+int
+target_config_target (struct target *tgt, enum target_config_type key, void *value)
+{
+    (void)key;
+    (void)value;
+    return tgt ? 0 : -1;
+}
+
+int
+target_get_target_config (struct target *tgt, enum target_get_config_type type, void *value)
+{
+    if (tgt == NULL || value == NULL) {
+        return -1;
+    }
+    if (type == TARGET_GET_XLEN) {
+        *(int *)value = tgt->cfg.xlen == 64 ? 64 : 32;
+        return 0;
+    }
+    return -1;
+}
+#endif /* SIM_LINK_TARGET */
+
+#ifdef SIM_LINK_EXPORT
+const struct link_ops *
+link_get_ops (unsigned int version)
+{
+    return version >= 1 ? &sim_link_ops : NULL;
+}
+
+const char *
+THE_NAME_OF_LINK (void)
+{
+    return sim_link_name ();
+}
+
+void *
+link_open (dbg_server_cfg_t *cfg, void *unique)
+{
+    return sim_link_open (cfg, unique);
+}
+
+void
+link_close (void *handle)
+{
+    sim_link_close (handle);
+}
+
+int
+link_config (void *handle, enum LINK_CONFIG_KEY key, unsigned int value)
+{
+    return sim_link_config (handle, key, value);
+}
+
+int
+link_memory_read (void *handle, uint64_t addr, int xlen, uint8_t *buff, int length, int mode)
+{
+    return sim_link_memory_read (handle, addr, xlen, buff, length, mode);
+}
+
+int
+link_memory_write (void *handle, uint64_t addr, int xlen, uint8_t *buff, int length, int mode)
+{
+    return sim_link_memory_write (handle, addr, xlen, buff, length, mode);
+}
+
+int
+link_register_read (void *handle, int regno, uint8_t *buff, int nbyte)
+{
+    return sim_link_register_read (handle, regno, buff, nbyte);
+}
+
+int
+link_register_write (void *handle, int regno, uint8_t *buff, int nbyte)
+{
+    return sim_link_register_write (handle, regno, buff, nbyte);
+}
+
+int
+link_jtag_operator (void *handle, int ir_len, unsigned char *ir, int dr_len,
+                    unsigned char *dr_r, unsigned char *dr_w, int read)
+{
+    return sim_link_jtag_operator (handle, ir_len, ir, dr_len, dr_r, dr_w, read);
+}
+
+int
+link_reset (void *handle, int hard)
+{
+    return sim_link_reset (handle, hard);
+}
+#endif
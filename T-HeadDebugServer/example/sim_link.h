@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: sim_link.h
+// function description: simulated link modelling a RISC-V DTM/DM or a C-SKY
+//                       HAD in host memory, with configurable latency. Built
+//                       with SIM_LINK_TARGET, it also provides the run control,
+//                       memory and File-I/O interfaces of libTarget on top of
+//                       the link, programs link it instead of libTarget.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_SIM_LINK_H__
+#define __DEBUGGER_SERVER_EXAMPLE_SIM_LINK_H__
+
+#include "dbg-target.h"
+#include "link_ops.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIM_LINK_NAME           "SimLink"
+#define SIM_LINK_IDCODE         0x10000b6f  ///< IDCODE of the RISC-V DTM
+#define SIM_LINK_HID            0x00000031  ///< HID of the C-SKY HAD
+#define SIM_LINK_ABITS          7           ///< The address bits of DMI
+#define SIM_LINK_DM_SIZE        0x60        ///< DMI ops from this address on fail
+
+/* The DM registers which are modelled.  */
+#define SIM_DM_DATA0            0x04
+#define SIM_DM_DATA1            0x05
+#define SIM_DM_DMCONTROL        0x10
+#define SIM_DM_DMSTATUS         0x11
+#define SIM_DM_HARTINFO         0x12
+#define SIM_DM_ABSTRACTCS       0x16
+#define SIM_DM_COMMAND          0x17
+#define SIM_DM_SBCS             0x38
+#define SIM_DM_SBADDRESS0       0x39
+#define SIM_DM_SBADDRESS1       0x3a
+#define SIM_DM_SBDATA0          0x3c
+#define SIM_DM_SBDATA1          0x3d
+
+/**
+\brief The architecture of the simulated link
+*/
+enum sim_link_arch
+{
+	SIM_LINK_RISCV = 0,     ///< DTM/DM over link_jtag_operator, memory over the system bus
+	SIM_LINK_CSKY,          ///< HAD registers over link_register_read/write
+};
+
+/**
+\brief The configuration of the simulated link, LINK_CONFIG_ISA_VER of
+       link_config changes arch and xlen as the real link does
+*/
+struct sim_link_cfg
+{
+    enum sim_link_arch arch;    ///< The architecture
+    int xlen;                   ///< 32 or 64
+    unsigned int mem_size;      ///< The size of memory from address 0
+    unsigned int latency_us;    ///< The cost of each USB transfer
+    unsigned int bytes_per_us;  ///< The bandwidth of memory access, zero for no limit
+    int dmi_idle;               ///< Run-Test/Idle cycles a DMI op takes in a batch, a DMI
+                                ///< scan coming earlier is busy. dtmcs.idle shows up to 7
+};
+
+/**
+\brief The statistics of the simulated link
+*/
+struct sim_link_stats
+{
+    unsigned int transfers;     ///< USB transfers, a batch counts once
+    unsigned int scans;         ///< JTAG scans
+    unsigned int dmi_busy;      ///< DMI scans answered busy
+    U64 bytes;                  ///< Memory bytes transferred
+    U64 link_us;                ///< Time spent in transfers
+};
+
+/**
+  \brief        The program running on the simulated target, it is called by
+                target_check_debug while the target is running
+  \param[in]    priv, the private data of the program
+  \param[in]    tgt, the handle of the simulated target
+  \param[out]   info, the File-I/O informations of the next syscall
+  \return       positive for a File-I/O halt, zero for keeping running,
+                negative for the program exited, the target halts with
+                DBG_REASON_BREAKPOINT
+*/
+typedef int (*sim_program_t) (void *priv, struct target *tgt, struct gdb_fileio_info *info);
+
+/**
+\brief The configuration of the simulated target, a RISC-V hart on a
+       simulated link
+*/
+struct sim_target_cfg
+{
+    unsigned int mem_size;      ///< The size of memory from address 0
+    int xlen;                   ///< 32 or 64
+    unsigned int latency_us;    ///< The cost of each link transaction
+    unsigned int bytes_per_us;  ///< The bandwidth of memory access, zero for no limit
+    sim_program_t program;      ///< The program, NULL for never halting by itself
+    void *priv;                 ///< The private data of the program
+};
+
+/**
+\brief The statistics of the simulated target
+*/
+struct sim_target_stats
+{
+    unsigned int transactions;  ///< Link transactions of all kinds
+    unsigned int checks;        ///< Calls of target_check_debug
+    unsigned int mem_reads;     ///< Calls of target_read_memory
+    unsigned int mem_writes;    ///< Calls of target_write_memory
+    unsigned int fileio_ends;   ///< Calls of target_fileio_end
+    U64 bytes;                  ///< Memory bytes transferred
+    U64 link_us;                ///< Time spent in link transactions
+};
+
+/**
+  \brief        Set the configuration of the links opened later, the default is
+                RISC-V, 64 bits, 1M memory and no latency
+  \param[in]    cfg, the configuration
+  \return       None
+*/
+void sim_link_set_cfg (const struct sim_link_cfg *cfg);
+
+/**
+  \brief        Get the function table of the simulated link
+  \return       The table
+*/
+const struct link_ops *sim_link_get_ops (void);
+
+/**
+  \brief        Get the statistics of a simulated link
+  \param[in]    handle, the handle of the open function in the table
+  \param[out]   stats, save the statistics
+  \return       None
+*/
+void sim_link_get_stats (void *handle, struct sim_link_stats *stats);
+
+/* The simulated target, only in sim_link.c built with SIM_LINK_TARGET.  */
+
+/**
+  \brief        Open a simulated target, it is halted after open
+  \param[in]    cfg, the configuration
+  \return       A handle for success, otherwise return NULL
+*/
+struct target *sim_target_open (const struct sim_target_cfg *cfg);
+
+/**
+  \brief        Close the simulated target
+  \param[in]    tgt, the handle of the simulated target
+  \return       None
+*/
+void sim_target_close (struct target *tgt);
+
+/**
+  \brief        Get the memory of the simulated target, for the program to
+                prepare and check its buffers
+  \param[in]    tgt, the handle of the simulated target
+  \param[out]   size, save the size of memory, could be NULL
+  \return       The memory
+*/
+unsigned char *sim_target_memory (struct target *tgt, unsigned int *size);
+
+/**
+  \brief        Get the answer of the last File-I/O syscall
+  \param[in]    tgt, the handle of the simulated target
+  \param[out]   retcode, save the return value
+  \param[out]   fileio_errno, save the errno, could be NULL
+  \return       zero for success, negative for no answer yet
+*/
+int sim_target_fileio_result (struct target *tgt, int *retcode, int *fileio_errno);
+
+/**
+  \brief        Get the statistics of the simulated target
+  \param[in]    tgt, the handle of the simulated target
+  \param[out]   stats, save the statistics
+  \return       None
+*/
+void sim_target_get_stats (struct target *tgt, struct sim_target_stats *stats);
+
+#ifdef SIM_LINK_EXPORT
+/**
+  \brief        The versioned entry when the simulated link is built as a
+                shared object, see link_get_ops_t
+*/
+LINK_OPS_API const struct link_ops *link_get_ops (unsigned int version);
+
+/* The functions of link.h, so the shared object stands in for Cklink.dll.  */
+LINK_OPS_API const char *THE_NAME_OF_LINK (void);
+LINK_OPS_API void *link_open (dbg_server_cfg_t *cfg, void *unique);
+LINK_OPS_API void link_close (void *handle);
+LINK_OPS_API int link_config (void *handle, enum LINK_CONFIG_KEY key, unsigned int value);
+LINK_OPS_API int link_memory_read (void *handle, uint64_t addr, int xlen, uint8_t *buff,
+                                   int length, int mode);
+LINK_OPS_API int link_memory_write (void *handle, uint64_t addr, int xlen, uint8_t *buff,
+                                    int length, int mode);
+LINK_OPS_API int link_register_read (void *handle, int regno, uint8_t *buff, int nbyte);
+LINK_OPS_API int link_register_write (void *handle, int regno, uint8_t *buff, int nbyte);
+LINK_OPS_API int link_jtag_operator (void *handle, int ir_len, unsigned char *ir, int dr_len,
+                                     unsigned char *dr_r, unsigned char *dr_w, int read);
+LINK_OPS_API int link_reset (void *handle, int hard);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_SIM_LINK_H__
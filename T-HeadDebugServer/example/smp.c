@@ -0,0 +1,310 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "smp.h"
+#include "rv_dm.h"
+#include "host_os.h"
+
+static struct smp_stats smp_stats;
+
+/* Mask of harts 0 to count - 1 in hart array window 0.  */
+static U32
+smp_hart_mask (int count)
+{
+    return count >= 32 ? 0xffffffffu : (1u << count) - 1;
+}
+
+/* With hasel the harts selected are the ones in hawindow and the one
+   at hartsel, point hartsel to the lowest hart in mask so no other
+   hart is selected.  */
+static U32
+smp_hartsel (U32 dmcontrol, U32 mask)
+{
+    int i;
+
+    for (i = 0; !(mask & (1u << i)); i++)
+        ;
+    return (dmcontrol & ~RV_DM_DMCONTROL_HARTSEL_MASK) | RV_DM_DMCONTROL_HARTSELLO (i);
+}
+
+/* haltsum0: bit i is set if hart i is halted.  */
+static int
+smp_states_by_haltsum (struct rv_dm *dm, enum target_state *states, int count)
+{
+    U32 haltsum;
+    int i;
+
+    if (rv_dm_read (dm, "haltsum0", &haltsum) < 0) {
+        return -1;
+    }
+    for (i = 0; i < count; i++) {
+        states[i] = haltsum & (1u << i) ? TARGET_HALTED : TARGET_RUNNING;
+    }
+    smp_stats.haltsum_reads++;
+    return 0;
+}
+
+/* Select all harts with the hart array window, dmstatus summarizes
+   them.  Only all halted or all running could be told.  */
+static int
+smp_states_by_window (struct rv_dm *dm, enum target_state *states, int count)
+{
+    U32 dmcontrol, dmstatus;
+    int i, ret;
+
+    if (rv_dm_read (dm, "dmcontrol", &dmcontrol) < 0) {
+        return -1;
+    }
+    dmcontrol &= ~(RV_DM_DMCONTROL_HALTREQ | RV_DM_DMCONTROL_RESUMEREQ
+                   | RV_DM_DMCONTROL_ACKHAVERESET);
+    if (rv_dm_write (dm, "hawindowsel", 0) < 0
+        || rv_dm_write (dm, "hawindow", smp_hart_mask (count)) < 0
+        || rv_dm_write (dm, "dmcontrol", smp_hartsel (dmcontrol, smp_hart_mask (count))
+                                         | RV_DM_DMCONTROL_HASEL) < 0) {
+        return -1;
+    }
+    ret = rv_dm_read (dm, "dmstatus", &dmstatus);
+    rv_dm_write (dm, "dmcontrol", dmcontrol & ~RV_DM_DMCONTROL_HASEL);
+    if (ret < 0) {
+        return -1;
+    }
+    smp_stats.window_reads++;
+
+    if (dmstatus & RV_DM_DMSTATUS_ALLHALTED) {
+        for (i = 0; i < count; i++) {
+            states[i] = TARGET_HALTED;
+        }
+        return 0;
+    }
+    if (dmstatus & RV_DM_DMSTATUS_ALLRUNNING) {
+        for (i = 0; i < count; i++) {
+            states[i] = TARGET_RUNNING;
+        }
+        return 0;
+    }
+    return -1;
+}
+
+static int
+smp_states_by_cpu (struct target *tgt, enum target_state *states, int count)
+{
+    int cur = target_get_current_cpu (tgt);
+    int i, failed = 0;
+
+    for (i = 0; i < count; i++) {
+        int state = i;
+
+        smp_stats.per_cpu_reads++;
+        if (target_select_cpu (tgt, i) < 0
+            || target_get_target_config (tgt, TARGET_GET_CPU_N_STATE, &state) < 0) {
+            states[i] = TARGET_UNKNOWN;
+            failed++;
+            continue;
+        }
+        states[i] = (enum target_state)state;
+    }
+    if (cur >= 0) {
+        target_select_cpu (tgt, cur);
+    }
+    return failed == count ? -1 : 0;
+}
+
+int
+target_get_all_cpu_states (struct target *tgt, enum target_state *states, int count)
+{
+    struct rv_dm dm;
+    int cpus, i;
+
+    if (tgt == NULL || states == NULL || count < 0) {
+        return -1;
+    }
+    cpus = target_get_cpu_count (tgt);
+    if (cpus <= 0) {
+        cpus = 1;
+    }
+    if (cpus > MAX_CPU_COUNT) {
+        cpus = MAX_CPU_COUNT;
+    }
+    for (i = cpus; i < count; i++) {
+        states[i] = TARGET_UNKNOWN;
+    }
+    if (count > cpus) {
+        count = cpus;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    if (rv_dm_init (&dm, tgt) == 0) {
+        if (smp_states_by_haltsum (&dm, states, count) == 0
+            || smp_states_by_window (&dm, states, count) == 0) {
+            return 0;
+        }
+    }
+    return smp_states_by_cpu (tgt, states, count);
+}
+
+int
+smp_get_group_mask (struct target *tgt, U32 *mask)
+{
+    int elements[MAX_CPU_COUNT];
+    int count = 0, i;
+
+    if (tgt == NULL || mask == NULL) {
+        return -1;
+    }
+    /* The elements are the indexes of cpus in the current group.  */
+    if (target_get_target_config (tgt, TARGET_GET_GROUP_CPU_COUNT, &count) < 0
+        || count <= 0 || count > MAX_CPU_COUNT
+        || target_get_target_config (tgt, TARGET_GET_GROUP_ELEMENTS, elements) < 0) {
+        return -1;
+    }
+    *mask = 0;
+    for (i = 0; i < count; i++) {
+        if (elements[i] >= 0 && elements[i] < MAX_CPU_COUNT) {
+            *mask |= 1u << elements[i];
+        }
+    }
+    return 0;
+}
+
+/* Send haltreq or resumereq to the harts in mask by the hart array
+   window, then wait until all of them have done it.  Return positive
+   if the DM could not do it, nothing is sent then.  */
+static int
+smp_group_request (struct rv_dm *dm, U32 mask, U32 req)
+{
+    U32 done = req == RV_DM_DMCONTROL_HALTREQ ? RV_DM_DMSTATUS_ALLHALTED
+                                              : RV_DM_DMSTATUS_ALLRESUMEACK;
+    U32 sel = RV_DM_DMCONTROL_HASEL | RV_DM_DMCONTROL_HARTSEL_MASK;
+    U32 dmcontrol, group, value, dmstatus = 0;
+    U64 start;
+    int ret = -1;
+
+    if (rv_dm_read (dm, "dmcontrol", &dmcontrol) < 0) {
+        return 1;
+    }
+    dmcontrol &= ~(RV_DM_DMCONTROL_HALTREQ | RV_DM_DMCONTROL_RESUMEREQ
+                   | RV_DM_DMCONTROL_ACKHAVERESET);
+    group = smp_hartsel (dmcontrol, mask) | RV_DM_DMCONTROL_HASEL;
+    if (rv_dm_write (dm, "hawindowsel", 0) < 0
+        || rv_dm_write (dm, "hawindow", mask) < 0
+        || rv_dm_write (dm, "dmcontrol", group) < 0) {
+        return 1;
+    }
+    /* hasel is optional, it reads 0 if not supported.  hartsel is WARL,
+       a hart outside mask would get the request if it does not stick.  */
+    if (rv_dm_read (dm, "dmcontrol", &value) < 0
+        || (value & sel) != (group & sel)) {
+        rv_dm_write (dm, "dmcontrol", dmcontrol);
+        return 1;
+    }
+
+    /* One write for all harts.  */
+    if (rv_dm_write (dm, "dmcontrol", group | req) == 0) {
+        start = host_time_us ();
+        do {
+            if (rv_dm_read (dm, "dmstatus", &dmstatus) < 0) {
+                break;
+            }
+            if (dmstatus & done) {
+                ret = 0;
+                break;
+            }
+        } while (host_time_us () - start < SMP_HALT_TIMEOUT_MS * 1000);
+    }
+
+    /* haltreq must be cleared, hasel too and hartsel restored for the
+       other interfaces.  */
+    rv_dm_write (dm, "dmcontrol", dmcontrol & ~RV_DM_DMCONTROL_HASEL);
+    return ret;
+}
+
+static int
+smp_cpus_one_by_one (struct target *tgt, U32 mask, int (*op) (struct target *))
+{
+    int cur = target_get_current_cpu (tgt);
+    int i, failed = 0;
+
+    for (i = 0; i < MAX_CPU_COUNT; i++) {
+        if (!(mask & (1u << i))) {
+            continue;
+        }
+        smp_stats.per_cpu_ops++;
+        if (target_select_cpu (tgt, i) < 0 || op (tgt) < 0) {
+            failed++;
+        }
+    }
+    if (cur >= 0) {
+        target_select_cpu (tgt, cur);
+    }
+    return failed ? -1 : 0;
+}
+
+static int
+smp_cpus_request (struct target *tgt, U32 mask, U32 req, int (*op) (struct target *))
+{
+    struct rv_dm dm;
+    int ret;
+
+    if (tgt == NULL) {
+        return -1;
+    }
+    if (mask == 0) {
+        return 0;
+    }
+    if (rv_dm_init (&dm, tgt) == 0) {
+        ret = smp_group_request (&dm, mask, req);
+        if (ret <= 0) {
+            smp_stats.group_ops++;
+            return ret;
+        }
+    }
+    return smp_cpus_one_by_one (tgt, mask, op);
+}
+
+int
+target_halt_cpus (struct target *tgt, U32 mask)
+{
+    return smp_cpus_request (tgt, mask, RV_DM_DMCONTROL_HALTREQ, target_halt);
+}
+
+int
+target_resume_cpus (struct target *tgt, U32 mask)
+{
+    return smp_cpus_request (tgt, mask, RV_DM_DMCONTROL_RESUMEREQ, target_resume);
+}
+
+int
+target_resume_cpus_one_by_one (struct target *tgt, U32 mask)
+{
+    if (tgt == NULL) {
+        return -1;
+    }
+    return smp_cpus_one_by_one (tgt, mask, target_resume);
+}
+
+void
+smp_get_stats (struct smp_stats *stats, int reset)
+{
+    if (stats) {
+        *stats = smp_stats;
+    }
+    if (reset) {
+        memset (&smp_stats, 0, sizeof (smp_stats));
+    }
+}
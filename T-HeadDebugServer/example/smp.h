@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ****************************************************************************
+// File name: smp.h
+// function description: helpers for multi-cores targets, the states of all
+//                       cpus are got from the DM summary registers, a group
+//                       of cpus is halted or resumed by the hart array mask.
+//
+// ****************************************************************************
+
+#ifndef __DEBUGGER_SERVER_EXAMPLE_SMP_H__
+#define __DEBUGGER_SERVER_EXAMPLE_SMP_H__
+
+#include "dbg-target.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SMP_HALT_TIMEOUT_MS     100     ///< Wait for the group to halt or resume
+
+/**
+\brief The statistics of smp helpers
+*/
+struct smp_stats
+{
+    unsigned int haltsum_reads;     ///< States got from haltsum0
+    unsigned int window_reads;      ///< States got from dmstatus with the hart array window
+    unsigned int per_cpu_reads;     ///< CPUs checked one by one
+    unsigned int group_ops;         ///< Halt/resume by the hart array mask
+    unsigned int per_cpu_ops;       ///< CPUs halted/resumed one by one
+};
+
+/**
+  \brief        Get the states of cpu 0 to count - 1. For RISC-V, the DM
+                register haltsum0 gives all of them in one read, otherwise
+                dmstatus with the hart array window tells whether all are
+                halted or running. The cpus are checked one by one with
+                TARGET_GET_CPU_N_STATE if both could not decide.
+  \param[in]    tgt, the handle of target
+  \param[out]   states, save the states, TARGET_HALTED or TARGET_RUNNING,
+                TARGET_UNKNOWN for cpus not existing
+  \param[in]    count, the count of states
+  \return       zero for success, negative for error
+*/
+int target_get_all_cpu_states (struct target *tgt, enum target_state *states, int count);
+
+/**
+  \brief        Get the cpus in the current group, see TARGET_GET_GROUP_ELEMENTS
+  \param[in]    tgt, the handle of target
+  \param[out]   mask, bit n is set for cpu n
+  \return       zero for success, negative for error
+*/
+int smp_get_group_mask (struct target *tgt, U32 *mask);
+
+/**
+  \brief        Halt the cpus together. For RISC-V, all of them are selected
+                by hasel and hawindow and one write of haltreq halts them,
+                otherwise they are halted one by one.
+  \param[in]    tgt, the handle of target
+  \param[in]    mask, bit n is set for cpu n
+  \return       zero for success, negative for error
+*/
+int target_halt_cpus (struct target *tgt, U32 mask);
+
+/**
+  \brief        Resume the cpus together, see target_halt_cpus. Registers and
+                breakpoints must be written to the target before, such as
+                by session_resume_cpus
+  \param[in]    tgt, the handle of target
+  \param[in]    mask, bit n is set for cpu n
+  \return       zero for success, negative for error
+*/
+int target_resume_cpus (struct target *tgt, U32 mask);
+
+/**
+  \brief        Resume the cpus one by one with target_resume, which flushes
+                the cache if target_enable_cache_flush is on. The resumereq
+                of target_resume_cpus does not flush
+  \param[in]    tgt, the handle of target
+  \param[in]    mask, bit n is set for cpu n
+  \return       zero for success, negative for error
+*/
+int target_resume_cpus_one_by_one (struct target *tgt, U32 mask);
+
+/**
+  \brief        Get the statistics of smp helpers
+  \param[out]   stats, save the statistics
+  \param[in]    reset, clear the statistics after reading
+  \return       None
+*/
+void smp_get_stats (struct smp_stats *stats, int reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DEBUGGER_SERVER_EXAMPLE_SMP_H__
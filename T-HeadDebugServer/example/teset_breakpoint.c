@@ -18,6 +18,9 @@
 #include <string.h>
 #include <stdlib.h>
 #include "dbg-target.h"
+#include "bkpt_index.h"
+#include "session.h"
+#include "host_os.h"
 
 int test_breakpoint (struct target *target)
 {
@@ -44,3 +47,280 @@ int test_breakpoint (struct target *target)
 	
 	return 0;
 }
+
+#define BKPT_BENCH_COUNT	10000
+#define BKPT_BENCH_READS	1000
+#define BKPT_BENCH_READ_SIZE	256
+
+static int bkpt_bench_count (void *priv, U64 address, void *data)
+{
+	(*(int *)priv)++;
+	return 0;
+}
+
+/* Find/insert/remove and masking cost at 10k breakpoints, the index
+   against the linked list of struct breakpoint.  */
+int test_breakpoint_index (struct target *target)
+{
+	struct breakpoint *bps, *head = NULL, *bp, **pbp;
+	struct bkpt_index *idx;
+	U64 t0, t_list[3], t_index[3];
+	int i, j, found_list = 0, found_index = 0, masked_list = 0, masked_index = 0;
+
+	printf ("=================== breakpoint index test ==================\n\n");
+
+	bps = calloc (BKPT_BENCH_COUNT, sizeof (struct breakpoint));
+	idx = bkpt_index_create ();
+	if (bps == NULL || idx == NULL) {
+		free (bps);
+		bkpt_index_destroy (idx);
+		return -1;
+	}
+	for (i = 0; i < BKPT_BENCH_COUNT; i++) {
+		bps[i].address = 0x10000 + (U64)i * 0x32;
+		bps[i].length = 2;
+	}
+
+	// Insert
+	t0 = host_time_us ();
+	for (i = 0; i < BKPT_BENCH_COUNT; i++) {
+		for (bp = head; bp; bp = bp->next) {
+			if (bp->address == bps[i].address) {
+				break;
+			}
+		}
+		if (bp == NULL) {
+			bps[i].next = head;
+			head = &bps[i];
+		}
+	}
+	t_list[0] = host_time_us () - t0;
+	t0 = host_time_us ();
+	for (i = 0; i < BKPT_BENCH_COUNT; i++) {
+		bkpt_index_insert (idx, bps[i].address, bps[i].length, &bps[i]);
+	}
+	t_index[0] = host_time_us () - t0;
+
+	// Find and mask a read, like a memory read with breakpoints
+	t0 = host_time_us ();
+	for (i = 0; i < BKPT_BENCH_READS; i++) {
+		U64 addr = 0x10000 + (U64)i * 0x1f3;
+
+		for (bp = head; bp; bp = bp->next) {
+			if (bp->address == addr) {
+				found_list++;
+			}
+			if (bp->address < addr + BKPT_BENCH_READ_SIZE && bp->address + bp->length > addr) {
+				masked_list++;
+			}
+		}
+	}
+	t_list[1] = host_time_us () - t0;
+	t0 = host_time_us ();
+	for (i = 0; i < BKPT_BENCH_READS; i++) {
+		U64 addr = 0x10000 + (U64)i * 0x1f3;
+
+		if (bkpt_index_find (idx, addr)) {
+			found_index++;
+		}
+		bkpt_index_foreach_range (idx, addr, BKPT_BENCH_READ_SIZE, bkpt_bench_count, &masked_index);
+	}
+	t_index[1] = host_time_us () - t0;
+
+	// Remove
+	t0 = host_time_us ();
+	for (i = 0; i < BKPT_BENCH_COUNT; i++) {
+		for (pbp = &head; *pbp; pbp = &(*pbp)->next) {
+			if ((*pbp)->address == bps[i].address) {
+				*pbp = (*pbp)->next;
+				break;
+			}
+		}
+	}
+	t_list[2] = host_time_us () - t0;
+	t0 = host_time_us ();
+	for (i = 0, j = 0; i < BKPT_BENCH_COUNT; i++) {
+		if (bkpt_index_remove (idx, bps[i].address)) {
+			j++;
+		}
+	}
+	t_index[2] = host_time_us () - t0;
+
+	bkpt_index_destroy (idx);
+	free (bps);
+	if (found_list != found_index || masked_list != masked_index || j != BKPT_BENCH_COUNT) {
+		printf ("breakpoint index mismatch\n\n");
+		return -1;
+	}
+
+	printf ("%d breakpoints, %d reads of %d bytes (us)\n", BKPT_BENCH_COUNT,
+			BKPT_BENCH_READS, BKPT_BENCH_READ_SIZE);
+	printf ("           insert   find+mask   remove\n");
+	printf ("list   %10u  %10u  %10u\n", (unsigned int)t_list[0],
+			(unsigned int)t_list[1], (unsigned int)t_list[2]);
+	printf ("index  %10u  %10u  %10u\n", (unsigned int)t_index[0],
+			(unsigned int)t_index[1], (unsigned int)t_index[2]);
+	printf ("breakpoint index successfully\n\n");
+	return 0;
+}
+
+#define BKPT_BATCH_TEST_COUNT	5000
+#define BKPT_BATCH_TEST_STEP	8
+
+int test_breakpoint_batch (struct target *target)
+{
+	struct dbg_session *session;
+	struct breakpoint *bps;
+	struct bkpt_mgr_stats stats;
+	unsigned char *orig, *rbuff;
+	unsigned int size = BKPT_BATCH_TEST_COUNT * BKPT_BATCH_TEST_STEP;
+	U64 *addrs, t0, t_add = 0, t_remove = 0;
+	int i, ret = -1;
+
+	printf ("=================== breakpoint batch test ==================\n\n");
+
+	session = session_create (target);
+	bps = calloc (BKPT_BATCH_TEST_COUNT, sizeof (struct breakpoint));
+	addrs = calloc (BKPT_BATCH_TEST_COUNT, sizeof (U64));
+	orig = malloc (size);
+	rbuff = malloc (size);
+	if (session == NULL || bps == NULL || addrs == NULL || orig == NULL || rbuff == NULL) {
+		goto out;
+	}
+	if (target_read_memory (target, 0x0, orig, size) < 0) {
+		printf ("failed to read memory\n");
+		goto out;
+	}
+
+	// Reverse order, the batch will sort them
+	for (i = 0; i < BKPT_BATCH_TEST_COUNT; i++) {
+		addrs[i] = (U64)(BKPT_BATCH_TEST_COUNT - 1 - i) * BKPT_BATCH_TEST_STEP;
+		bps[i].address = addrs[i];
+		bps[i].length = 2;
+		bps[i].type = BKPT_SOFT;
+	}
+	t0 = host_time_us ();
+	if (session_breakpoint_add_batch (session, bps, BKPT_BATCH_TEST_COUNT) < 0) {
+		printf ("failed to add breakpoints in batch\n");
+		goto out;
+	}
+	t_add = host_time_us () - t0;
+
+	// The breakpoints are hidden from memory reads
+	if (session_read_memory (session, 0x0, rbuff, size) < 0
+		|| memcmp (orig, rbuff, size) != 0) {
+		printf ("breakpoints are not masked\n");
+		goto out;
+	}
+
+	t0 = host_time_us ();
+	if (session_breakpoint_remove_batch (session, addrs, BKPT_BATCH_TEST_COUNT) < 0) {
+		printf ("failed to remove breakpoints in batch\n");
+		goto out;
+	}
+	t_remove = host_time_us () - t0;
+	if (target_read_memory (target, 0x0, rbuff, size) < 0
+		|| memcmp (orig, rbuff, size) != 0) {
+		printf ("original instructions are not restored\n");
+		goto out;
+	}
+	ret = 0;
+
+out:
+	if (session) {
+		session_get_stats (session, SESSION_STATS_BKPT, &stats);
+		session_destroy (session);
+	}
+	free (bps);
+	free (addrs);
+	free (orig);
+	free (rbuff);
+	if (ret < 0) {
+		printf ("breakpoint batch test failed\n\n");
+		return ret;
+	}
+	printf ("%d breakpoints, add %u us, remove %u us, %u reads, %u writes\n",
+			BKPT_BATCH_TEST_COUNT, (unsigned int)t_add, (unsigned int)t_remove,
+			stats.batch_reads, stats.batch_writes);
+	printf ("breakpoint batch successfully\n\n");
+	return 0;
+}
+
+int test_breakpoint_lazy (struct target *target)
+{
+	struct dbg_session *session;
+	struct bkpt_mgr_stats stats, before;
+	U64 addrs[] = {0x0, 0x10, 0x20};
+	int i, n = sizeof (addrs) / sizeof (addrs[0]), ret = 0;
+
+	printf ("=================== lazy breakpoint test ==================\n\n");
+
+	session = session_create (target);
+	if (session == NULL) {
+		return -1;
+	}
+	session_enable_lazy_breakpoints (session, 1);
+
+	// Nothing is written until sync(resume or single step)
+	for (i = 0; i < n && ret >= 0; i++) {
+		ret = session_breakpoint_add (session, addrs[i], 2, BKPT_SOFT);
+	}
+	if (ret >= 0 && bkpt_mgr_breakpoint_find (session->bpm, 0x0)->set) {
+		printf ("lazy breakpoint is set before sync\n");
+		ret = -1;
+	}
+	if (ret >= 0) {
+		ret = bkpt_mgr_sync (session->bpm);
+	}
+
+	// Remove and insert around a step like GDB, the target is not touched
+	bkpt_mgr_get_stats (session->bpm, &before);
+	if (ret >= 0) {
+		ret = session_breakpoint_remove_batch (session, addrs, n);
+	}
+	for (i = 0; i < n && ret >= 0; i++) {
+		ret = session_breakpoint_add (session, addrs[i], 2, BKPT_SOFT);
+	}
+	if (ret >= 0) {
+		ret = bkpt_mgr_sync (session->bpm);
+	}
+	bkpt_mgr_get_stats (session->bpm, &stats);
+	if (ret >= 0 && (stats.batch_writes != before.batch_writes || stats.synced != before.synced
+					 || stats.skipped != before.skipped + n)) {
+		printf ("lazy breakpoint written again, %u writes, %u skipped\n",
+				stats.batch_writes - before.batch_writes, stats.skipped - before.skipped);
+		ret = -1;
+	}
+
+	// A breakpoint may overlap one pending removal, sync removes it first
+	if (ret >= 0) {
+		ret = session_breakpoint_remove_batch (session, addrs, n);
+	}
+	if (ret >= 0) {
+		ret = session_breakpoint_add (session, addrs[1] - 2, 4, BKPT_SOFT);
+	}
+	if (ret >= 0) {
+		ret = bkpt_mgr_sync (session->bpm);
+	}
+	if (ret < 0) {
+		printf ("lazy breakpoint over a removed one failed\n");
+	}
+
+	// Remove them from the target
+	if (ret >= 0) {
+		ret = session_breakpoint_remove (session, addrs[1] - 2);
+	}
+	if (ret >= 0) {
+		ret = session_enable_lazy_breakpoints (session, 0);
+	}
+	session_get_stats (session, SESSION_STATS_BKPT, &stats);
+	session_destroy (session);
+	if (ret < 0) {
+		printf ("lazy breakpoint test failed\n\n");
+		return ret;
+	}
+
+	printf ("lazy breakpoint successfully, %u synced, %u skipped\n\n",
+			stats.synced, stats.skipped);
+	return 0;
+}
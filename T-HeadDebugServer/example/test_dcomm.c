@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "dbg-target.h"
+#include "dcomm_out.h"
+#include "dcomm_mux.h"
+
+#define DCOMM_TEST_BYTES	0x100000
+#define DCOMM_TEST_TIME_MS	200
+
+struct dcomm_test
+{
+	U64 bytes;
+	unsigned int outputs;
+	unsigned int lines;
+};
+
+static void dcomm_test_output (void *priv, const char *buf, size_t len)
+{
+	struct dcomm_test *t = priv;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		t->lines += buf[i] == '\n';
+	}
+	t->bytes += len;
+	t->outputs++;
+}
+
+// The hook set back after the test
+static int dcomm_test_putc (char ch)
+{
+	putchar (ch);
+	return 0;
+}
+
+int test_dcomm_output (struct target *target)
+{
+	struct dcomm_out_cfg cfg;
+	struct dcomm_out_stats stats;
+	struct dcomm_test t;
+	struct dcomm_out *dout;
+	hostMutex lock;
+	U64 start, host_us;
+	int i;
+
+	printf ("=================== dcomm output test ==================\n\n");
+
+	memset (&t, 0, sizeof (t));
+	memset (&cfg, 0, sizeof (cfg));
+	cfg.on_target_output = dcomm_test_output;
+	cfg.priv = &t;
+	cfg.prev_output = dcomm_test_putc;
+	if (host_mutex_init (&lock) < 0) {
+		return -1;
+	}
+	// The drain thread and this thread access the target by turns
+	dout = dcomm_out_create (target, &lock, &cfg);
+	if (dout == NULL) {
+		host_mutex_destroy (&lock);
+		return -1;
+	}
+
+	// The cost on the host of 1MB log, 64 bytes a line
+	start = host_time_us ();
+	for (i = 0; i < DCOMM_TEST_BYTES; i++) {
+		dcomm_out_putc ((i & 63) == 63 ? '\n' : 'a' + (i & 15));
+	}
+	dcomm_out_flush (dout);
+	host_us = host_time_us () - start;
+	if (t.bytes != DCOMM_TEST_BYTES || t.lines != DCOMM_TEST_BYTES / 64) {
+		printf ("dcomm output test failed, %llu bytes delivered\n\n", t.bytes);
+		dcomm_out_destroy (dout);
+		host_mutex_destroy (&lock);
+		return -1;
+	}
+	printf ("host: %d bytes in %u outputs, %.1f MB/s\n", DCOMM_TEST_BYTES, t.outputs,
+			host_us ? DCOMM_TEST_BYTES / (double)host_us : 0.0);
+
+	// The output of the running target
+	memset (&t, 0, sizeof (t));
+	target_set_remote_dcomm_output (target, dcomm_out_putc);
+	LOCK (&lock);
+	target_resume (target);
+	UNLOCK (&lock);
+	host_sleep_ms (DCOMM_TEST_TIME_MS);
+	LOCK (&lock);
+	target_halt (target);
+	UNLOCK (&lock);
+	dcomm_out_get_stats (dout, &stats);
+	dcomm_out_destroy (dout);
+	host_mutex_destroy (&lock);
+
+	printf ("dcomm output successfully, target %llu bytes/s in %u outputs, "
+			"%u polls (%u busy)\n\n", t.bytes * 1000 / DCOMM_TEST_TIME_MS, t.outputs,
+			stats.polls, stats.busy_polls);
+	return 0;
+}
+
+#define DCOMM_MUX_TEST_FRAMES	20000
+
+// Broken headers come out as text, and a file sink gets its frame
+static int dcomm_test_mux_resync (void)
+{
+	static const char expect[] = "a\xa5\x5a\x09" "b\xa5\x5a\x01\x64\x00" "c";
+	struct dcomm_mux_stats stats;
+	struct dcomm_sink sink;
+	struct dcomm_mux *mux;
+	char stream[64], text[64];
+	int len = 0, n;
+	FILE *fp;
+
+	fp = tmpfile ();
+	mux = dcomm_mux_create (0, 16);
+	if (fp == NULL || mux == NULL) {
+		if (fp) {
+			fclose (fp);
+		}
+		dcomm_mux_destroy (mux);
+		return -1;
+	}
+	memset (&sink, 0, sizeof (sink));
+	sink.type = DCOMM_SINK_FILE;
+	sink.fp = fp;
+	dcomm_mux_set_sink (mux, 3, &sink);
+
+	// A wrong channel, then a length over the max
+	memcpy (stream, expect, sizeof (expect) - 1);
+	len = sizeof (expect) - 1;
+	len += dcomm_mux_encode (3, "file", 4, stream + len);
+	dcomm_mux_on_output (mux, stream, len);
+	n = dcomm_mux_read (mux, 0, text, sizeof (text));
+	dcomm_mux_get_stats (mux, &stats);
+	dcomm_mux_destroy (mux);
+
+	rewind (fp);
+	len = (int)fread (stream, 1, sizeof (stream), fp);
+	fclose (fp);
+	if (n != sizeof (expect) - 1 || memcmp (text, expect, n) != 0 || stats.bad_frames != 2
+		|| stats.channel[3].frames != 1 || len != 4 || memcmp (stream, "file", 4) != 0) {
+		return -1;
+	}
+	return 0;
+}
+
+int test_dcomm_mux (struct target *target)
+{
+	struct dcomm_mux_stats stats;
+	struct dcomm_sink sink;
+	struct dcomm_test t;
+	struct dcomm_mux *mux;
+	char *stream, text[64];
+	int i, n, len = 0, chunk, ring_bytes = 0;
+	U64 start, us;
+
+	printf ("=================== dcomm mux test ==================\n\n");
+
+	// Text on channel 0, telemetry on channel 1 and RPC on channel 2
+	stream = malloc (DCOMM_MUX_TEST_FRAMES * 96);
+	mux = dcomm_mux_create (0, 0);
+	if (stream == NULL || mux == NULL) {
+		free (stream);
+		dcomm_mux_destroy (mux);
+		return -1;
+	}
+	for (i = 0; i < DCOMM_MUX_TEST_FRAMES; i++) {
+		U32 telemetry[8];
+
+		memset (telemetry, i & 0xff, sizeof (telemetry));
+		len += dcomm_mux_encode (1, (const char *)telemetry, sizeof (telemetry), stream + len);
+		if (i % 10 == 0) {
+			n = sprintf (text, "log %d\n", i);
+			memcpy (stream + len, text, n);
+			len += n;
+		}
+		if (i % 100 == 0) {
+			len += dcomm_mux_encode (2, "rpc", 3, stream + len);
+		}
+	}
+	// A broken frame is dropped
+	n = dcomm_mux_encode (1, "bad", 3, stream + len);
+	stream[len + n - 1] ^= 1;
+	len += n;
+
+	memset (&t, 0, sizeof (t));
+	memset (&sink, 0, sizeof (sink));
+	sink.type = DCOMM_SINK_CALLBACK;
+	sink.output = dcomm_test_output;
+	sink.priv = &t;
+	dcomm_mux_set_sink (mux, 1, &sink);
+
+	// Delivered in pieces of any size, as dcomm_out does
+	start = host_time_us ();
+	for (i = 0, chunk = 1; i < len; i += chunk, chunk = chunk * 3 % 4093 + 1) {
+		dcomm_mux_on_output (mux, stream + i, i + chunk > len ? len - i : chunk);
+		n = dcomm_mux_read (mux, 2, text, sizeof (text));
+		ring_bytes += n > 0 ? n : 0;
+	}
+	us = host_time_us () - start;
+	dcomm_mux_get_stats (mux, &stats);
+	dcomm_mux_destroy (mux);
+	free (stream);
+
+	if (stats.channel[1].frames != DCOMM_MUX_TEST_FRAMES || t.bytes != DCOMM_MUX_TEST_FRAMES * 32
+		|| stats.channel[0].bytes == 0 || ring_bytes != DCOMM_MUX_TEST_FRAMES / 100 * 3
+		|| stats.bad_frames != 1 || dcomm_test_mux_resync () < 0) {
+		printf ("dcomm mux test failed\n\n");
+		return -1;
+	}
+	printf ("dcomm mux successfully, %d bytes, %.1f MB/s, %u text runs, %u telemetry frames, "
+			"%u rpc frames\n\n", len, us ? len / (double)us : 0.0, stats.channel[0].frames,
+			stats.channel[1].frames, stats.channel[2].frames);
+	return 0;
+}
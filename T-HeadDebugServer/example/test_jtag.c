@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "dbg-target.h"
+#include "host_os.h"
+#include "jtag_queue.h"
+#include "sim_link.h"
+
+#define JTAG_TEST_LATENCY_US	100
+#define JTAG_TEST_OPS			2000
+
+/* Write and read back the DM registers, returns the time in us.  */
+static long long
+jtag_test_burst (struct jtag_queue *q, U32 *values, struct jtag_queue_stats *stats)
+{
+	U64 start = host_time_us ();
+	U32 addr;
+	int i;
+
+	for (i = 0; i < JTAG_TEST_OPS / 2; i++) {
+		addr = SIM_DM_DATA0 + i % 2;
+		if (jtag_queue_dmi_write (q, SIM_LINK_ABITS, addr, 0x5a000000 | i) < 0
+			|| jtag_queue_dmi_read (q, SIM_LINK_ABITS, addr, &values[i]) < 0) {
+			return -1;
+		}
+	}
+	if (jtag_queue_flush (q) < 0) {
+		return -1;
+	}
+	jtag_queue_get_stats (q, stats);
+	return (long long)(host_time_us () - start);
+}
+
+int test_jtag_queue (struct target *target)
+{
+	static U32 values[JTAG_TEST_OPS / 2];
+	struct jtag_queue_stats one_stats, batch_stats;
+	const struct link_ops *ops = sim_link_get_ops ();
+	struct jtag_queue *one, *batch;
+	struct sim_link_cfg cfg;
+	void *link;
+	unsigned char ir = JTAG_DTM_IR_IDCODE, dr_w[4] = {0}, idcode[4];
+	long long one_us, batch_us;
+	U32 bad;
+	int i;
+
+	printf ("=================== jtag queue test ==================\n\n");
+
+	// The DTM of the simulated link, one USB transfer costs JTAG_TEST_LATENCY_US
+	memset (&cfg, 0, sizeof (cfg));
+	cfg.arch = SIM_LINK_RISCV;
+	cfg.xlen = 64;
+	cfg.mem_size = 0x10000;
+	cfg.latency_us = JTAG_TEST_LATENCY_US;
+	sim_link_set_cfg (&cfg);
+	link = ops->open (NULL, NULL);
+	one = jtag_queue_create (ops->jtag_operator, NULL, link);
+	batch = jtag_queue_create (ops->jtag_operator, ops->jtag_batch, link);
+	if (link == NULL || one == NULL || batch == NULL) {
+		jtag_queue_destroy (one);
+		jtag_queue_destroy (batch);
+		ops->close (link);
+		return -1;
+	}
+
+	// Each scan is a transfer, as link_jtag_operator does
+	one_us = jtag_test_burst (one, values, &one_stats);
+	for (i = 0; i < JTAG_TEST_OPS / 2 && one_us >= 0; i++) {
+		if (values[i] != (0x5a000000 | (U32)i)) {
+			one_us = -1;
+		}
+	}
+
+	// Queued scans in one transfer per flush
+	memset (values, 0, sizeof (values));
+	batch_us = jtag_test_burst (batch, values, &batch_stats);
+	for (i = 0; i < JTAG_TEST_OPS / 2 && batch_us >= 0; i++) {
+		if (values[i] != (0x5a000000 | (U32)i)) {
+			batch_us = -1;
+		}
+	}
+
+	// A raw scan, then a DMI op out of the DM fails the flush
+	if (batch_us >= 0 && (jtag_queue_scan (batch, 1, &ir, 4, dr_w, idcode) < 0
+		|| jtag_queue_flush (batch) < 0
+		|| (idcode[0] | idcode[1] << 8 | idcode[2] << 16 | (U32)idcode[3] << 24) != SIM_LINK_IDCODE
+		|| jtag_queue_dmi_read (batch, SIM_LINK_ABITS, SIM_LINK_DM_SIZE, &bad) < 0
+		|| jtag_queue_flush (batch) >= 0)) {
+		batch_us = -1;
+	}
+	jtag_queue_destroy (one);
+	jtag_queue_destroy (batch);
+	ops->close (link);
+
+	if (one_us < 0 || batch_us < 0) {
+		printf ("jtag queue test failed\n\n");
+		return -1;
+	}
+	printf ("jtag queue successfully, %d DMI ops: %u transfers %lld us one by one, "
+			"%u transfers %lld us queued, %.1fx\n\n", JTAG_TEST_OPS, one_stats.transfers, one_us,
+			batch_stats.transfers, batch_us, batch_us ? (double)one_us / batch_us : 0.0);
+	return 0;
+}
@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "dbg-target.h"
+#include "host_os.h"
+#include "jtag_queue.h"
+#include "link_ops.h"
+#include "sim_link.h"
+#include "regNo.h"
+
+#define LINK_TEST_LATENCY_US	50
+#define LINK_TEST_WORDS			1024
+#define LINK_TEST_ADDR			0x1000
+#define LINK_TEST_DMI_IDLE		12
+
+// The simulated link built as README says
+#if defined _WIN32 && !defined (__CYGWIN)
+#define LINK_TEST_SIM_LIB		"SimLink.dll"
+#else
+#define LINK_TEST_SIM_LIB		"./libsimlink.so"
+#endif
+
+/* Halt the hart, write and read back a GPR, then access memory over the
+   system bus, all through queued DMI ops.  */
+static int
+link_test_riscv (const struct link_ops *ops, void *link, jtag_batch_t batch)
+{
+	static U32 words[LINK_TEST_WORDS];
+	struct jtag_queue *q;
+	unsigned char ir = JTAG_DTM_IR_IDCODE, dr[4] = {0}, idcode[4];
+	U32 dmstatus = 0, data0 = 0, sbcs = 0;
+	int i, ret = -1;
+
+	q = jtag_queue_create (ops->jtag_operator, batch, link);
+	if (q == NULL) {
+		return -1;
+	}
+	jtag_queue_scan (q, 1, &ir, 4, dr, idcode);
+	jtag_queue_dmi_write (q, SIM_LINK_ABITS, SIM_DM_DMCONTROL, 0x80000001);
+	jtag_queue_dmi_read (q, SIM_LINK_ABITS, SIM_DM_DMSTATUS, &dmstatus);
+	jtag_queue_dmi_write (q, SIM_LINK_ABITS, SIM_DM_DATA0, 0x12345678);
+	jtag_queue_dmi_write (q, SIM_LINK_ABITS, SIM_DM_COMMAND, 0x00231005);
+	jtag_queue_dmi_write (q, SIM_LINK_ABITS, SIM_DM_DATA0, 0);
+	jtag_queue_dmi_write (q, SIM_LINK_ABITS, SIM_DM_COMMAND, 0x00221005);
+	jtag_queue_dmi_read (q, SIM_LINK_ABITS, SIM_DM_DATA0, &data0);
+	if (jtag_queue_flush (q) < 0 || (idcode[0] | idcode[1] << 8 | idcode[2] << 16
+		| (U32)idcode[3] << 24) != SIM_LINK_IDCODE || !(dmstatus & (1 << 9))
+		|| data0 != 0x12345678) {
+		goto out;
+	}
+
+	// 32-bit accesses with autoincrement
+	jtag_queue_dmi_write (q, SIM_LINK_ABITS, SIM_DM_SBCS, 2 << 17 | 1 << 16);
+	jtag_queue_dmi_write (q, SIM_LINK_ABITS, SIM_DM_SBADDRESS0, LINK_TEST_ADDR);
+	for (i = 0; i < LINK_TEST_WORDS; i++) {
+		jtag_queue_dmi_write (q, SIM_LINK_ABITS, SIM_DM_SBDATA0, 0xa5000000 | i);
+	}
+	jtag_queue_dmi_write (q, SIM_LINK_ABITS, SIM_DM_SBCS, 1 << 20 | 2 << 17 | 1 << 16 | 1 << 15);
+	jtag_queue_dmi_write (q, SIM_LINK_ABITS, SIM_DM_SBADDRESS0, LINK_TEST_ADDR);
+	for (i = 0; i < LINK_TEST_WORDS; i++) {
+		jtag_queue_dmi_read (q, SIM_LINK_ABITS, SIM_DM_SBDATA0, &words[i]);
+	}
+	jtag_queue_dmi_read (q, SIM_LINK_ABITS, SIM_DM_SBCS, &sbcs);
+	if (jtag_queue_flush (q) < 0 || ((sbcs >> 12) & 0x7) != 0) {
+		goto out;
+	}
+	for (i = 0; i < LINK_TEST_WORDS; i++) {
+		if (words[i] != (0xa5000000 | (U32)i)) {
+			goto out;
+		}
+	}
+
+	// Resume
+	jtag_queue_dmi_write (q, SIM_LINK_ABITS, SIM_DM_DMCONTROL, 0x40000001);
+	jtag_queue_dmi_read (q, SIM_LINK_ABITS, SIM_DM_DMSTATUS, &dmstatus);
+	if (jtag_queue_flush (q) == 0 && (dmstatus & (1 << 11)) && (dmstatus & (1 << 17))) {
+		ret = 0;
+	}
+out:
+	jtag_queue_destroy (q);
+	return ret;
+}
+
+/* DMI ops need more idle cycles than dtmcs.idle shows, the queue gets busy
+   and replays with more.  */
+static int
+link_test_busy (const struct link_ops *ops, void *link)
+{
+	static U32 values[LINK_TEST_WORDS];
+	struct jtag_queue_stats stats;
+	struct sim_link_stats link_stats;
+	struct jtag_queue *q;
+	U32 dtmcs = 0;
+	int i, ret = -1;
+
+	q = jtag_queue_create (ops->jtag_operator, ops->jtag_batch, link);
+	if (q == NULL) {
+		return -1;
+	}
+	if (jtag_queue_read_dtmcs (q, &dtmcs) < 0 || JTAG_DTMCS_ABITS (dtmcs) != SIM_LINK_ABITS
+		|| JTAG_DTMCS_IDLE (dtmcs) != 7) {
+		goto out;
+	}
+	for (i = 0; i < LINK_TEST_WORDS; i++) {
+		jtag_queue_dmi_write (q, SIM_LINK_ABITS, SIM_DM_DATA0 + i % 2, 0x69000000 | i);
+		jtag_queue_dmi_read (q, SIM_LINK_ABITS, SIM_DM_DATA0 + i % 2, &values[i]);
+	}
+	if (jtag_queue_flush (q) < 0) {
+		goto out;
+	}
+	for (i = 0; i < LINK_TEST_WORDS; i++) {
+		if (values[i] != (0x69000000 | (U32)i)) {
+			goto out;
+		}
+	}
+	jtag_queue_get_stats (q, &stats);
+	sim_link_get_stats (link, &link_stats);
+	if (stats.busy_retries > 0 && stats.idle >= LINK_TEST_DMI_IDLE && link_stats.dmi_busy > 0) {
+		ret = 0;
+	}
+out:
+	jtag_queue_destroy (q);
+	return ret;
+}
+
+/* Halt by HCR, registers over the HAD, download by DDC.  */
+static int
+link_test_csky (const struct link_ops *ops, void *link)
+{
+	U32 hid = 0, hsr = 0, pc = 0x8000, word = 0, value;
+	int i;
+
+	if (ops->config (link, LINK_CONFIG_ISA_VER, 3) < 0
+		|| ops->register_read (link, HID, (uint8_t *)&hid, 4) < 0 || hid != SIM_LINK_HID) {
+		return -1;
+	}
+	value = 0x8000;
+	if (ops->register_write (link, HCR, (uint8_t *)&value, 4) < 0
+		|| ops->register_read (link, HSR, (uint8_t *)&hsr, 4) < 0 || !(hsr & HSR_BIT_DRO)
+		|| ops->register_write (link, SCRPC, (uint8_t *)&pc, 4) < 0) {
+		return -1;
+	}
+	pc = 0;
+	value = LINK_TEST_ADDR;
+	if (ops->register_read (link, SCRPC, (uint8_t *)&pc, 4) < 0 || pc != 0x8000
+		|| ops->register_write (link, DDCADDR, (uint8_t *)&value, 4) < 0) {
+		return -1;
+	}
+	for (i = 0; i < 16; i++) {
+		value = 0x3c000000 | i;
+		if (ops->register_write (link, DDCDATA, (uint8_t *)&value, 4) < 0) {
+			return -1;
+		}
+	}
+	if (ops->memory_read (link, LINK_TEST_ADDR + 15 * 4, 32, (uint8_t *)&word, 4, M_WORD) < 0
+		|| word != 0x3c00000f) {
+		return -1;
+	}
+	value = GOBIT | EXBIT;
+	if (ops->register_write (link, HACR, (uint8_t *)&value, 4) < 0
+		|| ops->register_read (link, SCRPC, (uint8_t *)&pc, 4) == 0) {
+		return -1;
+	}
+	return 0;
+}
+
+/* Load the simulated link shared object through LINK_OPS_ENTRY, it has the
+   link.h names as Cklink.dll does too. Skipped if it is not built.  */
+static int
+link_test_load (void)
+{
+	const char *(*name) (void);
+	struct link_ops ops;
+	void *lib, *link;
+	int ret = -1;
+
+	lib = host_lib_open (LINK_TEST_SIM_LIB);
+	if (lib == NULL) {
+		printf ("%s is not found, loading is skipped, build it as README says\n",
+				LINK_TEST_SIM_LIB);
+		return 1;
+	}
+	host_lib_close (lib);
+	lib = link_ops_load (LINK_TEST_SIM_LIB, &ops);
+	if (lib == NULL) {
+		return -1;
+	}
+	// The table is from the entry, the link.h names have no jtag_batch
+	*(void **)&name = host_lib_symbol (lib, "THE_NAME_OF_LINK");
+	if (host_lib_symbol (lib, LINK_OPS_ENTRY) == NULL || ops.version != LINK_OPS_VERSION
+		|| ops.jtag_batch == NULL || strcmp (ops.name (), SIM_LINK_NAME) != 0
+		|| name == NULL || strcmp (name (), SIM_LINK_NAME) != 0
+		|| host_lib_symbol (lib, "link_open") == NULL
+		|| host_lib_symbol (lib, "link_jtag_operator") == NULL) {
+		link_ops_unload (lib);
+		return -1;
+	}
+	if (ops.init == NULL || ops.init (NULL) == 0) {
+		link = ops.open (NULL, NULL);
+		if (link) {
+			ret = link_test_riscv (&ops, link, ops.jtag_batch);
+			ops.close (link);
+		}
+	}
+	link_ops_unload (lib);
+	return ret;
+}
+
+int test_link_ops (struct target *target)
+{
+	struct sim_link_stats one_stats, batch_stats;
+	struct sim_link_cfg cfg;
+	struct link_ops ops;
+	void *link;
+	U64 start, one_us, batch_us;
+	int loaded;
+
+	printf ("=================== link ops test ==================\n\n");
+
+	if (link_ops_load ("no_such_link", &ops) != NULL
+		|| link_ops_copy (&ops, sim_link_get_ops ()) < 0) {
+		printf ("link ops test failed\n\n");
+		return -1;
+	}
+	memset (&cfg, 0, sizeof (cfg));
+	cfg.arch = SIM_LINK_RISCV;
+	cfg.xlen = 64;
+	cfg.mem_size = 1024 * 1024;
+	cfg.latency_us = LINK_TEST_LATENCY_US;
+	sim_link_set_cfg (&cfg);
+
+	// RISC-V DM, scans one by one and then in batches
+	link = ops.open (NULL, NULL);
+	start = host_time_us ();
+	if (link == NULL || link_test_riscv (&ops, link, NULL) < 0) {
+		printf ("link ops test failed on RISC-V, one by one\n\n");
+		ops.close (link);
+		return -1;
+	}
+	one_us = host_time_us () - start;
+	sim_link_get_stats (link, &one_stats);
+	ops.close (link);
+
+	link = ops.open (NULL, NULL);
+	start = host_time_us ();
+	if (link == NULL || link_test_riscv (&ops, link, ops.jtag_batch) < 0) {
+		printf ("link ops test failed on RISC-V, batched\n\n");
+		ops.close (link);
+		return -1;
+	}
+	batch_us = host_time_us () - start;
+	sim_link_get_stats (link, &batch_stats);
+
+	// C-SKY HAD on the same link
+	if (link_test_csky (&ops, link) < 0) {
+		printf ("link ops test failed on C-SKY\n\n");
+		ops.close (link);
+		return -1;
+	}
+	ops.close (link);
+
+	// Busy DMI ops are replayed with more idle cycles
+	cfg.dmi_idle = LINK_TEST_DMI_IDLE;
+	sim_link_set_cfg (&cfg);
+	link = ops.open (NULL, NULL);
+	if (link == NULL || link_test_busy (&ops, link) < 0) {
+		printf ("link ops test failed on busy DMI ops\n\n");
+		ops.close (link);
+		return -1;
+	}
+	ops.close (link);
+	cfg.dmi_idle = 0;
+	sim_link_set_cfg (&cfg);
+
+	loaded = link_test_load ();
+	if (loaded < 0) {
+		printf ("link ops test failed, %s\n\n", LINK_TEST_SIM_LIB);
+		return -1;
+	}
+
+	printf ("link ops successfully%s, %s, %u scans: %u transfers %llu us one by one, "
+			"%u transfers %llu us batched\n\n", loaded ? " without loading" : "", ops.name (),
+			one_stats.scans, one_stats.transfers, (unsigned long long)one_us, batch_stats.transfers,
+			(unsigned long long)batch_us);
+	return 0;
+}
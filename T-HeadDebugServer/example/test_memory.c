@@ -17,6 +17,10 @@
 #include <stdio.h>
 #include <string.h>
 #include "dbg-target.h"
+#include "mem_access.h"
+#include "mem_iov.h"
+#include "session.h"
+#include "mem_download.h"
 
 int test_memory (struct target *target)
 {
@@ -55,3 +59,243 @@ int test_memory (struct target *target)
 	printf ("memory read/write successfully\n\n");
 	return 0;
 }
+
+int test_memory_v (struct target *target)
+{
+	unsigned char wbuff[256];
+	unsigned char rbuff[256];
+	struct mem_iov iov[4];
+	struct mem_iov_stats stats;
+	int i, ret = 0;
+
+	printf ("=================== vectored memory read test ==================\n\n");
+
+	for (i = 0; i < (int)sizeof (wbuff); i++) {
+		wbuff[i] = (unsigned char)i;
+	}
+	ret = target_write_memory(target, 0x0, wbuff, sizeof (wbuff));
+	if (ret < 0) {
+		return ret;
+	}
+
+	// unordered, adjacent and overlapping segments
+	memset (rbuff, 0, sizeof (rbuff));
+	iov[0].addr = 0x80; iov[0].buff = rbuff + 0x80; iov[0].size = 0x40;
+	iov[1].addr = 0x00; iov[1].buff = rbuff + 0x00; iov[1].size = 0x40;
+	iov[2].addr = 0x40; iov[2].buff = rbuff + 0x40; iov[2].size = 0x40;
+	iov[3].addr = 0xa0; iov[3].buff = rbuff + 0xa0; iov[3].size = 0x60;
+
+	mem_iov_get_stats (NULL, 1);
+	ret = target_read_memory_v (target, iov, 4);
+	if (ret < 0) {
+		return ret;
+	}
+	mem_iov_get_stats (&stats, 1);
+
+	if (memcmp (wbuff, rbuff, sizeof (wbuff)) != 0) {
+		printf ("vectored memory read failed\n\n");
+		return -1;
+	}
+
+	// the four segments cover 0x0-0x100 without a gap, one transfer
+	if (stats.segments != 4 || stats.transfers != 1) {
+		printf ("vectored memory read failed, %u segments in %u transfers\n\n",
+				stats.segments, stats.transfers);
+		return -1;
+	}
+
+	printf ("vectored memory read successfully, %u segments in %u transfers\n\n",
+			stats.segments, stats.transfers);
+	return 0;
+}
+
+int test_memory_cache (struct target *target)
+{
+	unsigned char wbuff[64];
+	unsigned char rbuff[64];
+	struct dbg_session *session;
+	struct mem_cache_stats stats;
+	int ret = 0;
+
+	printf ("=================== memory cache test ==================\n\n");
+
+	session = session_create (target);
+	if (session == NULL) {
+		return -1;
+	}
+	session_enable_mem_cache (session, 1);
+
+	// the second read should be served from the cache
+	ret = session_read_memory (session, 0x10, rbuff, sizeof (rbuff));
+	if (ret == 0) {
+		ret = session_read_memory (session, 0x10, rbuff, sizeof (rbuff));
+	}
+
+	// write through, then read back from the cache
+	memset (wbuff, 'c', sizeof (wbuff));
+	if (ret == 0) {
+		ret = session_write_memory (session, 0x20, wbuff, sizeof (wbuff));
+	}
+	if (ret == 0) {
+		ret = session_read_memory (session, 0x20, rbuff, sizeof (rbuff));
+	}
+	session_get_stats (session, SESSION_STATS_MEM_CACHE, &stats);
+	session_destroy (session);
+
+	if (ret < 0 || memcmp (wbuff, rbuff, sizeof (wbuff)) != 0) {
+		printf ("memory cache failed\n\n");
+		return -1;
+	}
+
+	// 0x10-0x60 is in one page, it is read from the target once
+	if (stats.hits != 2 || stats.misses != 1 || stats.bypasses != 0) {
+		printf ("memory cache failed, %u hits, %u misses, %u bypasses\n\n",
+				stats.hits, stats.misses, stats.bypasses);
+		return -1;
+	}
+
+	printf ("memory cache successfully, %u hits, %u misses\n\n",
+			stats.hits, stats.misses);
+	return 0;
+}
+
+#define DOWNLOAD_TEST_SIZE 0x18000
+
+static int download_test_fill (void *priv, U64 offset, unsigned char *buff, unsigned int size)
+{
+	unsigned int i;
+
+	if (offset >= DOWNLOAD_TEST_SIZE) {
+		return 0;
+	}
+	if (size > DOWNLOAD_TEST_SIZE - offset) {
+		size = (unsigned int)(DOWNLOAD_TEST_SIZE - offset);
+	}
+	for (i = 0; i < size; i++) {
+		buff[i] = (unsigned char)((offset + i) * 7);
+	}
+	return size;
+}
+
+int test_memory_download (struct target *target)
+{
+	unsigned char rbuff[128];
+	struct download_stats stats;
+	unsigned int i;
+	int ret = 0;
+
+	printf ("=================== memory download test ==================\n\n");
+
+	ret = mem_download (target, 0x0, download_test_fill, NULL, 1, &stats);
+	if (ret < 0) {
+		printf ("memory download failed\n\n");
+		return ret;
+	}
+
+	// check the tail of the image, it crosses the chunk boundary
+	ret = target_read_memory (target, DOWNLOAD_TEST_SIZE - sizeof (rbuff), rbuff, sizeof (rbuff));
+	if (ret < 0) {
+		return ret;
+	}
+	for (i = 0; i < sizeof (rbuff); i++) {
+		if (rbuff[i] != (unsigned char)((DOWNLOAD_TEST_SIZE - sizeof (rbuff) + i) * 7)) {
+			printf ("memory download verify failed\n\n");
+			return -1;
+		}
+	}
+
+	printf ("memory download successfully, %u bytes in %u chunks, %.2f MB/s\n\n",
+			(unsigned int)stats.bytes, stats.chunks, stats.mbps);
+	return 0;
+}
+
+int test_memory_access (struct target *target)
+{
+	unsigned char wbuff[64];
+	unsigned char rbuff[64];
+	struct mem_access_stats stats;
+	int i, ret = 0;
+
+	printf ("=================== widest memory access test ==================\n\n");
+
+	ret = mem_access_init (target);
+	if (ret < 0) {
+		return ret;
+	}
+	for (i = 0; i < (int)sizeof (wbuff); i++) {
+		wbuff[i] = (unsigned char)(0xa0 + i);
+	}
+
+	// unaligned head, aligned body and unaligned tail
+	mem_access_get_stats (NULL, 1);
+	ret = mem_access_write (target, 0x3, wbuff + 0x3, 0x35);
+	if (ret < 0) {
+		mem_access_exit (target);
+		return ret;
+	}
+	memset (rbuff, 0, sizeof (rbuff));
+	ret = mem_access_read (target, 0x3, rbuff + 0x3, 0x35);
+	if (ret < 0) {
+		mem_access_exit (target);
+		return ret;
+	}
+	mem_access_get_stats (&stats, 1);
+	mem_access_exit (target);
+
+	if (memcmp (wbuff + 0x3, rbuff + 0x3, 0x35) != 0) {
+		printf ("widest memory access failed\n\n");
+		return -1;
+	}
+
+	printf ("widest memory access successfully, %u requests in %u segments\n\n",
+			stats.requests, stats.segments);
+	return 0;
+}
+
+int test_memory_region (struct target *target)
+{
+	unsigned char rbuff[0x180];
+	struct dbg_session *session;
+	struct rv_mem_region_stats stats;
+	int ret = 0;
+
+	if (target_get_debug_arch_type (target) != DEBUG_ARCH_RISCV) {
+		return 0;
+	}
+	printf ("=================== memory access region test ==================\n\n");
+
+	session = session_create (target);
+	if (session == NULL) {
+		return -1;
+	}
+	// progbuf, abscmd, and sysbus out of the regions
+	ret = session_set_mem_regions (session, "0x0-0x80:progbuf,0x80-0x100:abscmd");
+	if (ret == 0) {
+		ret = session_set_mem_mode (session, RV_MEM_ACCESS_SYSBUS);
+	}
+	if (ret == 0) {
+		ret = session_read_memory (session, 0x0, rbuff, sizeof (rbuff));
+	}
+	session_get_stats (session, SESSION_STATS_MEM_REGION, &stats);
+	session_destroy (session);
+
+	if (ret < 0) {
+		printf ("memory access region failed\n\n");
+		return -1;
+	}
+	if (stats.accesses[RV_MEM_ACCESS_PROGBUF] != 1 || stats.accesses[RV_MEM_ACCESS_ABSCMD] != 1
+		|| stats.accesses[RV_MEM_ACCESS_SYSBUS] != 1 || stats.fallbacks != 0) {
+		printf ("memory access region failed, regions are not served in their modes\n\n");
+		return -1;
+	}
+	// the abscmd region is longer than RV_MEM_BURST_MIN
+	if (stats.bursts + stats.burst_fallbacks != 1) {
+		printf ("memory access region failed, the abscmd access is not a burst\n\n");
+		return -1;
+	}
+
+	printf ("memory access region successfully, sysbus %u, abscmd %u(%u bursts, %u fallbacks), progbuf %u, fallbacks %u\n\n",
+			stats.accesses[RV_MEM_ACCESS_SYSBUS], stats.accesses[RV_MEM_ACCESS_ABSCMD],
+			stats.bursts, stats.burst_fallbacks, stats.accesses[RV_MEM_ACCESS_PROGBUF], stats.fallbacks);
+	return 0;
+}
@@ -20,6 +20,9 @@
 #include "dbg-target.h"
 #include "dataType.h"
 #include "regNo.h"
+#include "rv_gdb_regs.h"
+#include "reg_batch.h"
+#include "session.h"
 
 
 int test_register (struct target *target)
@@ -63,3 +66,113 @@ int test_register (struct target *target)
 	
 	return 0;
 }
+
+int test_register_batch (struct target *target)
+{
+	struct reg regs[CSKY_R15_REGNUM - CSKY_R0_REGNUM + 3];
+	struct reg_batch_stats stats;
+	int pc = CSKY_PC_REGNUM, r0 = CSKY_R0_REGNUM;
+	int i, n = 0, ret = 0;
+
+	printf ("=================== register batch test ==================\n\n");
+
+	// r0-r15 are a run of abstract commands on riscv
+	if (target_get_debug_arch_type (target) == DEBUG_ARCH_RISCV) {
+		pc = RV_GDB_REGNO_PC;
+		r0 = RV_GDB_REGNO_ZERO;
+	}
+
+	// PC first and r1 twice, r1 is read once
+	memset (regs, 0, sizeof (regs));
+	regs[n++].num = pc;
+	for (i = r0; i <= r0 + 15; i++) {
+		regs[n++].num = i;
+	}
+	regs[n++].num = r0 + 1;
+
+	reg_batch_get_stats (NULL, 1);
+	ret = reg_batch_read (target, regs, n);
+	reg_batch_get_stats (&stats, 1);
+	if (ret < 0) {
+		printf ("failed to read %d registers in batch\n\n", -ret);
+		return ret;
+	}
+	if (stats.accessed + stats.run_regs != (unsigned int)n - 1
+		|| regs[n - 1].value.val32 != regs[2].value.val32) {
+		printf ("register batch error, %u registers in %u accesses and %u runs\n\n",
+				stats.requested, stats.accessed, stats.runs);
+		return -1;
+	}
+
+	for (i = 1; i < n - 1; i++) {
+		printf ("r%d: 0x%x\n", regs[i].num - r0, regs[i].value.val32);
+	}
+	printf ("PC: 0x%x\n", regs[0].value.val32);
+	printf ("register batch successfully, %u registers in %u accesses and %u runs(%u registers)\n\n",
+			stats.requested, stats.accessed, stats.runs, stats.run_regs);
+	return 0;
+}
+
+int test_register_cache (struct target *target)
+{
+	struct dbg_session *session;
+	struct reg_cache_stats stats;
+	struct reg rn, saved;
+	int ret;
+
+	printf ("=================== register cache test ==================\n\n");
+
+	session = session_create (target);
+	if (session == NULL) {
+		printf ("failed to create session\n\n");
+		return -1;
+	}
+	session_enable_reg_cache (session, 1);
+
+	// The second read is served from the cache
+	memset (&saved, 0, sizeof (saved));
+	saved.num = CSKY_R0_REGNUM + 1;
+	ret = session_read_cpu_reg (session, &saved);
+	if (ret >= 0) {
+		rn = saved;
+		ret = session_read_cpu_reg (session, &rn);
+	}
+
+	// Write is deferred, read back from the cache
+	if (ret >= 0) {
+		rn.value.val32 = saved.value.val32 ^ 0x5a5a5a5a;
+		ret = session_write_cpu_reg (session, &rn);
+	}
+	// Read back through a struct reg with another type, only the number is the key
+	if (ret >= 0) {
+		rn.type = rn.type == REGISTER_TYPE_FR ? REGISTER_TYPE_GR : REGISTER_TYPE_FR;
+		rn.value.val32 = 0;
+		ret = session_read_cpu_reg (session, &rn);
+	}
+	if (ret >= 0 && rn.value.val32 != (saved.value.val32 ^ 0x5a5a5a5a)) {
+		printf ("register cache read back error\n");
+		ret = -1;
+	}
+
+	// Restore, it is written back when the cache is disabled
+	if (ret >= 0) {
+		ret = session_write_cpu_reg (session, &saved);
+	}
+	if (ret >= 0) {
+		ret = session_enable_reg_cache (session, 0);
+	}
+	session_get_stats (session, SESSION_STATS_REG_CACHE, &stats);
+	session_destroy (session);
+	if (ret >= 0 && (stats.misses != 1 || stats.flushed != 1)) {
+		printf ("register cache error, %u misses, %u flushed\n", stats.misses, stats.flushed);
+		ret = -1;
+	}
+	if (ret < 0) {
+		printf ("register cache test failed\n\n");
+		return ret;
+	}
+
+	printf ("register cache successfully, %u hits, %u misses, %u flushed\n\n",
+			stats.hits, stats.misses, stats.flushed);
+	return 0;
+}
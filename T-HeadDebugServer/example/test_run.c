@@ -0,0 +1,327 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "dbg-target.h"
+#include "session.h"
+#include "smp.h"
+#include "link_sched.h"
+#include "mem_access.h"
+#include "sim_link.h"
+
+
+int test_halt_wait (struct target *target)
+{
+	struct dbg_session *session;
+	struct halt_poller_stats stats;
+	struct halt_info info;
+	int ret;
+
+	printf ("=================== halt wait test ==================\n\n");
+
+	session = session_create (target);
+	if (session == NULL) {
+		return -1;
+	}
+
+	ret = session_resume (session);
+	if (ret < 0) {
+		printf ("failed to resume\n\n");
+		session_destroy (session);
+		return ret;
+	}
+
+	// The target keeps running, it times out
+	ret = session_wait_halt (session, &info, 200);
+	if (ret == 0) {
+		printf ("target halted by itself, pc 0x%llx\n", info.addr);
+	} else if (ret > 0) {
+		session_halt (session);
+		ret = session_wait_halt (session, &info, 1000);
+	}
+	session_get_stats (session, SESSION_STATS_HALT_POLLER, &stats);
+	session_destroy (session);
+	if (ret != 0) {
+		printf ("halt is not detected\n\n");
+		return -1;
+	}
+
+	printf ("halt wait successfully, pc 0x%llx, %u polls\n\n", info.addr, stats.polls);
+	return 0;
+}
+
+int test_cpu_states (struct target *target)
+{
+	enum target_state states[MAX_CPU_COUNT];
+	struct smp_stats stats;
+	int i, count, ret;
+
+	printf ("=================== cpu states test ==================\n\n");
+
+	count = target_get_cpu_count (target);
+	if (count <= 0 || count > MAX_CPU_COUNT) {
+		count = 1;
+	}
+	smp_get_stats (NULL, 1);
+	ret = target_get_all_cpu_states (target, states, count);
+	smp_get_stats (&stats, 1);
+	if (ret < 0) {
+		printf ("failed to get cpu states\n\n");
+		return ret;
+	}
+
+	for (i = 0; i < count; i++) {
+		printf ("cpu%d: %s\n", i, states[i] == TARGET_HALTED ? "halted"
+				: states[i] == TARGET_RUNNING ? "running" : "unknown");
+	}
+	printf ("cpu states successfully, haltsum %u, window %u, per cpu %u\n\n",
+			stats.haltsum_reads, stats.window_reads, stats.per_cpu_reads);
+	return 0;
+}
+
+int test_cpu_group (struct target *target)
+{
+	struct dbg_session *session;
+	enum target_state states[MAX_CPU_COUNT];
+	struct smp_stats stats;
+	U32 mask, one = 0;
+	int i, count, ret;
+
+	printf ("=================== cpu group test ==================\n\n");
+
+	count = target_get_cpu_count (target);
+	if (count <= 0 || count > MAX_CPU_COUNT) {
+		count = 1;
+	}
+	if (smp_get_group_mask (target, &mask) < 0) {
+		mask = count >= 32 ? 0xffffffff : (1u << count) - 1;
+	}
+
+	session = session_create (target);
+	if (session == NULL) {
+		return -1;
+	}
+	smp_get_stats (NULL, 1);
+	ret = session_resume_cpus (session, mask);
+	if (ret >= 0) {
+		ret = session_halt_cpus (session, mask);
+	}
+	// The poller of the session may be using the target
+	if (ret >= 0) {
+		session_lock (session);
+		ret = target_get_all_cpu_states (target, states, count);
+		session_unlock (session);
+	}
+	for (i = 0; i < count && ret >= 0; i++) {
+		if ((mask & (1u << i)) && states[i] != TARGET_HALTED) {
+			printf ("cpu%d is not halted\n", i);
+			ret = -1;
+		}
+	}
+
+	// Resume one cpu which is not the current one, the others stay halted
+	session_lock (session);
+	for (i = 0; i < count; i++) {
+		if ((mask & (1u << i)) && i != target_get_current_cpu (target)) {
+			one = 1u << i;
+		}
+	}
+	session_unlock (session);
+	if (ret >= 0 && one) {
+		ret = session_resume_cpus (session, one);
+		if (ret >= 0) {
+			session_lock (session);
+			ret = target_get_all_cpu_states (target, states, count);
+			session_unlock (session);
+		}
+		for (i = 0; i < count && ret >= 0; i++) {
+			if ((mask & ~one & (1u << i)) && states[i] != TARGET_HALTED) {
+				printf ("cpu%d is resumed with mask 0x%x\n", i, one);
+				ret = -1;
+			}
+		}
+		if (session_halt_cpus (session, one) < 0) {
+			ret = -1;
+		}
+	}
+	smp_get_stats (&stats, 1);
+	session_destroy (session);
+	if (ret < 0) {
+		printf ("cpu group test failed\n\n");
+		return ret;
+	}
+
+	printf ("cpu group successfully, mask 0x%x, %u group ops, %u per cpu ops\n\n",
+			mask, stats.group_ops, stats.per_cpu_ops);
+	return 0;
+}
+
+#define LINK_TEST_BULK_SIZE		0x10000
+#define LINK_TEST_SMALL_SIZE	0x40
+#define LINK_TEST_TIME_MS		200
+#define LINK_TEST_LATENCY_US	20
+
+struct link_test_client
+{
+	struct link_sched *ls;
+	int cpu;
+	volatile int *stop;
+	int failed;
+};
+
+/* Memory of the target goes over the simulated link, so the cost of
+   each access is known.  */
+static int link_test_sim_xfer (void *priv, struct target *tgt, U64 addr,
+		unsigned char *buff, unsigned int size, int write)
+{
+	const struct link_ops *ops = sim_link_get_ops ();
+
+	if (write) {
+		return ops->memory_write (priv, addr, 64, buff, (int)size, M_WORD);
+	}
+	return ops->memory_read (priv, addr, 64, buff, (int)size, M_WORD);
+}
+
+static void *link_test_client_thread (void *arg)
+{
+	struct link_test_client *client = arg;
+	unsigned char *buff;
+	int i;
+
+	buff = malloc (LINK_TEST_BULK_SIZE);
+	if (buff == NULL) {
+		client->failed = 1;
+		return NULL;
+	}
+	// One bulk read, then some small ones
+	while (!*client->stop) {
+		if (link_sched_read_memory (client->ls, client->cpu, 0, buff, LINK_TEST_BULK_SIZE) < 0) {
+			client->failed = 1;
+			break;
+		}
+		for (i = 0; i < 8; i++) {
+			if (link_sched_read_memory (client->ls, client->cpu, i * LINK_TEST_SMALL_SIZE,
+					buff + i * LINK_TEST_SMALL_SIZE, LINK_TEST_SMALL_SIZE) < 0) {
+				client->failed = 1;
+				break;
+			}
+		}
+	}
+	free (buff);
+	return NULL;
+}
+
+int test_link_sched (struct target *target)
+{
+	struct link_test_client clients[4];
+	hostThread threads[4];
+	struct link_sched *ls;
+	struct link_sched_stats stats;
+	struct link_sched_latency *run;
+	struct sim_link_cfg cfg;
+	struct sim_link_stats link_stats;
+	mem_access_backend_t backend;
+	void *link, *priv;
+	volatile int stop = 0;
+	double sum = 0, sum2 = 0;
+	int i, count, halts = 0, ret = 0;
+	U64 start;
+
+	printf ("=================== link scheduler test ==================\n\n");
+
+	count = target_get_cpu_count (target);
+	if (count <= 0) {
+		count = 1;
+	} else if (count > 4) {
+		count = 4;
+	}
+
+	memset (&cfg, 0, sizeof (cfg));
+	cfg.arch = SIM_LINK_RISCV;
+	cfg.xlen = 64;
+	cfg.mem_size = LINK_TEST_BULK_SIZE;
+	cfg.latency_us = LINK_TEST_LATENCY_US;
+	sim_link_set_cfg (&cfg);
+	link = sim_link_get_ops ()->open (NULL, NULL);
+	if (link == NULL) {
+		return -1;
+	}
+	backend = mem_access_get_backend (target, &priv);
+	if (mem_access_set_backend (target, link_test_sim_xfer, link) < 0) {
+		sim_link_get_ops ()->close (link);
+		return -1;
+	}
+
+	ls = link_sched_create (target, NULL);
+	if (ls == NULL) {
+		mem_access_set_backend (target, backend, priv);
+		sim_link_get_ops ()->close (link);
+		return -1;
+	}
+	for (i = 0; i < count; i++) {
+		clients[i].ls = ls;
+		clients[i].cpu = i;
+		clients[i].stop = &stop;
+		clients[i].failed = 0;
+		if (host_thread_create (&threads[i], link_test_client_thread, &clients[i]) < 0) {
+			count = i;
+			ret = -1;
+			break;
+		}
+	}
+
+	// Halt requests go before the bulk reads of all cpus
+	start = host_time_us ();
+	while (ret == 0 && host_time_us () - start < LINK_TEST_TIME_MS * 1000) {
+		if (link_sched_run_control (ls, halts % (count ? count : 1), LINK_REQ_HALT) < 0) {
+			ret = -1;
+		}
+		halts++;
+		host_sleep_ms (5);
+	}
+	stop = 1;
+	for (i = 0; i < count; i++) {
+		host_thread_join (threads[i]);
+		if (clients[i].failed) {
+			ret = -1;
+		}
+	}
+	link_sched_get_stats (ls, &stats, 1);
+	link_sched_destroy (ls);
+	sim_link_get_stats (link, &link_stats);
+	mem_access_set_backend (target, backend, priv);
+	sim_link_get_ops ()->close (link);
+	if (ret < 0) {
+		printf ("link scheduler test failed\n\n");
+		return ret;
+	}
+
+	for (i = 0; i < count; i++) {
+		printf ("cpu%d: %u requests, %.1f KB/s\n", i, stats.cpu[i].requests,
+				stats.cpu[i].bytes * 1000.0 / 1024 / LINK_TEST_TIME_MS);
+		sum += (double)stats.cpu[i].bytes;
+		sum2 += (double)stats.cpu[i].bytes * stats.cpu[i].bytes;
+	}
+	run = &stats.prio[LINK_PRIO_RUN];
+	printf ("fairness %.3f, %u batches, %u merged, %u chunks, %u cpu switches, %u link transfers\n",
+			sum2 > 0 ? sum * sum / (count * sum2) : 1.0,
+			stats.batches, stats.merged, stats.chunks, stats.cpu_switches, link_stats.transfers);
+	printf ("link scheduler successfully, %u halts, latency avg %llu us, max %llu us\n\n",
+			run->requests, run->requests ? run->sum_us / run->requests : 0, run->max_us);
+	return 0;
+}
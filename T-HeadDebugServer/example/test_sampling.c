@@ -0,0 +1,350 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "dbg-target.h"
+#include "pc_stream.h"
+#include "pc_profile.h"
+#include "proc_profile.h"
+#include "sample_file.h"
+
+#define PC_STREAM_TEST_TIME_MS	200
+
+struct pc_stream_test
+{
+	U64 samples;
+	U64 last_us;
+	int disordered;
+};
+
+static void pc_stream_test_cb (void *priv, const struct pc_sample *samples, int count)
+{
+	struct pc_stream_test *t = priv;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (samples[i].time_us < t->last_us) {
+			t->disordered++;
+		}
+		t->last_us = samples[i].time_us;
+	}
+	t->samples += count;
+}
+
+static int sampling_supported (struct target *target, int feature)
+{
+	int support = 0;
+
+	if (target_get_target_config (target, TARGET_GET_SAMMPLING_SUPPORT, &support) < 0) {
+		return 0;
+	}
+	return (support & feature) != 0;
+}
+
+int test_pc_stream (struct target *target)
+{
+	struct pc_stream_cfg cfg;
+	struct pc_stream_stats stats;
+	struct pc_stream_test t;
+	struct pc_stream *ps;
+	unsigned int freq;
+
+	printf ("=================== pc stream test ==================\n\n");
+
+	if (!sampling_supported (target, TARGET_PC_SAMPLING_FEATURE | TARGET_PC_SAMPLING_FEATURE_LINK)) {
+		printf ("pc sampling is not supported\n\n");
+		return 0;
+	}
+
+	memset (&t, 0, sizeof (t));
+	memset (&cfg, 0, sizeof (cfg));
+	cfg.cpu = target_get_current_cpu (target);
+	cfg.freq = 50000;
+	cfg.on_samples = pc_stream_test_cb;
+	cfg.priv = &t;
+
+	if (target_resume (target) < 0) {
+		printf ("failed to resume\n\n");
+		return -1;
+	}
+	ps = pc_stream_create (target, NULL, &cfg);
+	if (ps == NULL) {
+		printf ("failed to start pc sampling\n\n");
+		target_halt (target);
+		return -1;
+	}
+	freq = pc_stream_get_freq (ps);
+	host_sleep_ms (PC_STREAM_TEST_TIME_MS);
+	// The samples left in the ring are delivered before it returns
+	pc_stream_stop (ps);
+	pc_stream_get_stats (ps, &stats);
+	pc_stream_destroy (ps);
+	target_halt (target);
+
+	if (t.samples != stats.delivered || stats.delivered != stats.samples - stats.dropped
+		|| t.disordered) {
+		printf ("pc stream test failed, %llu delivered, %llu samples, %llu dropped, %d out of order\n\n",
+				t.samples, stats.samples, stats.dropped, t.disordered);
+		return -1;
+	}
+	printf ("%u dumps, %llu samples, %llu dropped, %u full dumps\n",
+			stats.dumps, stats.samples, stats.dropped, stats.link_full);
+	printf ("pc stream successfully, %u Hz limited, %llu samples/s delivered\n\n",
+			freq, t.samples * 1000 / PC_STREAM_TEST_TIME_MS);
+	return 0;
+}
+
+int test_pc_profile (struct target *target)
+{
+	struct pc_profile_entry entries[4];
+	struct pc_profile_stats stats;
+	struct pc_stream_cfg cfg;
+	struct pc_profile *pp;
+	struct pc_stream *ps;
+	struct elf_syms *syms;
+	U64 sum = 0;
+	int i, count;
+
+	printf ("=================== pc profile test ==================\n\n");
+
+	// Resolve known PCs by symbols: func_i has i * 100 samples
+	syms = elf_syms_create ();
+	pp = pc_profile_create (syms);
+	if (syms == NULL || pp == NULL) {
+		pc_profile_destroy (pp);
+		elf_syms_destroy (syms);
+		return -1;
+	}
+	for (i = 0; i < 8; i++) {
+		char name[16];
+
+		sprintf (name, "func_%d", i);
+		elf_syms_add (syms, name, 0x1000 + i * 0x100, i == 7 ? 0x100 : 0);
+		pc_profile_add (pp, 0x1000 + i * 0x100 + (i * 2 % 0x100), i * 50);
+		pc_profile_add (pp, 0x1000 + i * 0x100 + 0x80, i * 50);
+	}
+	pc_profile_add (pp, 0x10, 10);
+	count = pc_profile_flat (pp, entries, 4);
+	pc_profile_get_stats (pp, &stats);
+	if (count != 4 || entries[0].name == NULL || strcmp (entries[0].name, "func_7") != 0
+		|| entries[0].count != 700 || stats.samples != 2810) {
+		printf ("pc profile test failed\n\n");
+		pc_profile_destroy (pp);
+		elf_syms_destroy (syms);
+		return -1;
+	}
+	pc_profile_export (pp, stdout, 4);
+	pc_profile_destroy (pp);
+	elf_syms_destroy (syms);
+
+	if (!sampling_supported (target, TARGET_PC_SAMPLING_FEATURE | TARGET_PC_SAMPLING_FEATURE_LINK)) {
+		printf ("pc sampling is not supported\n\n");
+		return 0;
+	}
+
+	// Profile the running target by PC, exported every 100ms
+	pp = pc_profile_create (NULL);
+	if (pp == NULL) {
+		return -1;
+	}
+	pc_profile_set_export (pp, stdout, 100, 5);
+	memset (&cfg, 0, sizeof (cfg));
+	cfg.cpu = target_get_current_cpu (target);
+	cfg.freq = 20000;
+	cfg.on_samples = pc_profile_on_samples;
+	cfg.priv = pp;
+
+	target_resume (target);
+	ps = pc_stream_create (target, NULL, &cfg);
+	if (ps == NULL) {
+		printf ("failed to start pc sampling\n\n");
+		target_halt (target);
+		pc_profile_destroy (pp);
+		return -1;
+	}
+	host_sleep_ms (PC_STREAM_TEST_TIME_MS + 100);
+	pc_stream_destroy (ps);
+	target_halt (target);
+
+	pc_profile_get_stats (pp, &stats);
+	count = pc_profile_flat (pp, entries, 4);
+	for (i = 0; i < count; i++) {
+		sum += entries[i].count;
+	}
+	pc_profile_destroy (pp);
+	if (count < 0 || sum > stats.samples) {
+		printf ("pc profile test failed\n\n");
+		return -1;
+	}
+	printf ("pc profile successfully, %llu samples, %u pcs, %u exports\n\n",
+			stats.samples, stats.pcs, stats.exports);
+	return 0;
+}
+
+int test_proc_profile (struct target *target)
+{
+	struct proc_profile_info infos[4];
+	struct proc_profile_stats stats;
+	struct pc_sample samples[64];
+	struct pc_stream_cfg cfg;
+	struct proc_profile *pp;
+	struct pc_stream *ps;
+	int i, count;
+
+	printf ("=================== proc profile test ==================\n\n");
+
+	// Context ID 3 has half of samples, 2 a third and 1 the rest
+	pp = proc_profile_create (NULL);
+	if (pp == NULL) {
+		return -1;
+	}
+	proc_profile_set_process (pp, 3, "daemon", NULL);
+	memset (samples, 0, sizeof (samples));
+	for (i = 0; i < 60; i++) {
+		samples[i].cpu = i % 2;
+		samples[i].contextid = i % 6 < 3 ? 3 : (i % 6 < 5 ? 2 : 1);
+		samples[i].pc = 0x10000 + samples[i].contextid * 0x100 + (i % 4) * 4;
+	}
+	proc_profile_on_samples (pp, samples, 60);
+	count = proc_profile_list (pp, infos, 4);
+	if (count != 3 || infos[0].contextid != 3 || strcmp (infos[0].name, "daemon") != 0
+		|| infos[0].samples != 30 || infos[1].samples != 20 || infos[2].samples != 10
+		|| infos[0].cpu_samples[0] + infos[0].cpu_samples[1] != 30) {
+		printf ("proc profile test failed\n\n");
+		proc_profile_destroy (pp);
+		return -1;
+	}
+	proc_profile_export (pp, stdout, 2);
+	proc_profile_destroy (pp);
+
+	if (!sampling_supported (target, TARGET_CONTEXTID_SAMPLING_FEATURE | TARGET_CONTEXTID_SAMPLING_FEATURE_LINK)) {
+		printf ("context id sampling is not supported\n\n");
+		return 0;
+	}
+
+	// Profile the running target by process
+	pp = proc_profile_create (NULL);
+	if (pp == NULL) {
+		return -1;
+	}
+	memset (&cfg, 0, sizeof (cfg));
+	cfg.mode = PC_STREAM_MODE_CONTEXTID;
+	cfg.cpu = target_get_current_cpu (target);
+	cfg.freq = 20000;
+	cfg.on_samples = proc_profile_on_samples;
+	cfg.priv = pp;
+
+	target_resume (target);
+	ps = pc_stream_create (target, NULL, &cfg);
+	if (ps == NULL) {
+		printf ("failed to start context id sampling\n\n");
+		target_halt (target);
+		proc_profile_destroy (pp);
+		return -1;
+	}
+	host_sleep_ms (PC_STREAM_TEST_TIME_MS);
+	pc_stream_destroy (ps);
+	target_halt (target);
+
+	proc_profile_export (pp, stdout, 3);
+	proc_profile_get_stats (pp, &stats);
+	proc_profile_destroy (pp);
+	printf ("proc profile successfully, %llu samples, %u processes\n\n",
+			stats.samples, stats.processes);
+	return 0;
+}
+
+#define SAMPLE_FILE_TEST_PATH	"pc_samples.bin"
+#define SAMPLE_FILE_TEST_FOLDED	"pc_samples.folded"
+#define SAMPLE_FILE_TEST_COUNT	100000
+
+static void sample_file_test_make (struct pc_sample *s, int i)
+{
+	// Two cpus in loops of 64 instructions, a context switch every 10000 samples
+	s->cpu = i % 2;
+	s->contextid = 100 + (i / 10000) % 3;
+	s->pc = 0x80000000ull + s->contextid * 0x10000 + (i * 7 % 64) * 4;
+	s->time_us = 1000000ull + i * 20ull;
+}
+
+int test_sample_file (struct target *target)
+{
+	struct sample_writer_stats stats;
+	struct sample_writer *w = NULL;
+	struct sample_reader *r;
+	struct pc_sample s, e;
+	FILE *folded;
+	U64 converted = 0;
+	int i, ret;
+
+	printf ("=================== sample file test ==================\n\n");
+
+	remove (SAMPLE_FILE_TEST_PATH);
+	// Written in two runs, the second one appends
+	for (i = 0; i < SAMPLE_FILE_TEST_COUNT; i++) {
+		if (i == 0 || i == SAMPLE_FILE_TEST_COUNT / 2) {
+			if (i) {
+				sample_writer_close (w);
+			}
+			w = sample_writer_open (SAMPLE_FILE_TEST_PATH);
+			if (w == NULL) {
+				printf ("failed to open %s\n\n", SAMPLE_FILE_TEST_PATH);
+				return -1;
+			}
+		}
+		sample_file_test_make (&s, i);
+		sample_writer_add (w, &s, 1);
+	}
+	sample_writer_get_stats (w, &stats);
+	sample_writer_close (w);
+
+	r = sample_reader_open (SAMPLE_FILE_TEST_PATH);
+	if (r == NULL) {
+		remove (SAMPLE_FILE_TEST_PATH);
+		return -1;
+	}
+	for (i = 0; (ret = sample_reader_next (r, &s)) > 0; i++) {
+		sample_file_test_make (&e, i);
+		if (s.cpu != e.cpu || s.contextid != e.contextid || s.pc != e.pc || s.time_us != e.time_us) {
+			break;
+		}
+	}
+	sample_reader_close (r);
+	if (ret != 0 || i != SAMPLE_FILE_TEST_COUNT) {
+		printf ("sample file test failed at sample %d\n\n", i);
+		remove (SAMPLE_FILE_TEST_PATH);
+		return -1;
+	}
+
+	folded = fopen (SAMPLE_FILE_TEST_FOLDED, "w");
+	if (folded) {
+		ret = sample_file_to_collapsed (SAMPLE_FILE_TEST_PATH, folded, NULL, &converted);
+		fclose (folded);
+	}
+	remove (SAMPLE_FILE_TEST_PATH);
+	remove (SAMPLE_FILE_TEST_FOLDED);
+	if (folded == NULL || ret < 0 || converted != SAMPLE_FILE_TEST_COUNT) {
+		printf ("failed to convert the sample file\n\n");
+		return -1;
+	}
+
+	printf ("sample file successfully, %d samples, %.2f bytes per sample, %llu collapsed\n\n",
+			SAMPLE_FILE_TEST_COUNT, (double)stats.bytes / (SAMPLE_FILE_TEST_COUNT / 2),
+			(unsigned long long)converted);
+	return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2021 T-HEAD Semiconductor Co.,Ltd. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "dbg-target.h"
+#include "host_os.h"
+#include "semihost.h"
+
+#define SEMIHOST_TEST_TIME_MS	2000
+
+// Vectored write table as it is in target memory, no target is needed
+int test_semihost_iov (struct target *target)
+{
+	static const struct semihost_iov expect[] = {
+		{3, 0x12345678, 0x8000000012345678ULL},
+		{SEMIHOST_MAX_FILES - 1, 0xfffffffe, 0xfedcba9876543210ULL},
+		{1, 0, 0x10},
+	};
+	int n = sizeof (expect) / sizeof (expect[0]);
+	unsigned char table[sizeof (expect)];
+	struct semihost_iov segs[sizeof (expect) / sizeof (expect[0])];
+	int i, j;
+
+	printf ("=================== semihost iov test ==================\n\n");
+
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < 4; j++) {
+			table[i * 16 + j] = (unsigned char)(expect[i].fd >> (j * 8));
+			table[i * 16 + 4 + j] = (unsigned char)(expect[i].len >> (j * 8));
+		}
+		for (j = 0; j < 8; j++) {
+			table[i * 16 + 8 + j] = (unsigned char)(expect[i].addr >> (j * 8));
+		}
+	}
+	semihost_iov_decode (table, n, segs);
+	for (i = 0; i < n; i++) {
+		if (segs[i].fd != expect[i].fd || segs[i].len != expect[i].len
+			|| segs[i].addr != expect[i].addr) {
+			printf ("semihost iov %d decoded as fd %u, len 0x%x, addr 0x%llx\n\n", i,
+					segs[i].fd, segs[i].len, (unsigned long long)segs[i].addr);
+			return -1;
+		}
+	}
+	printf ("semihost iov successfully, %d segments\n\n", n);
+	return 0;
+}
+
+int test_semihost (struct target *target)
+{
+	struct semihost_stats stats;
+	struct halt_info info;
+	struct semihost *sh;
+	U64 start, us;
+	int ret = 0;
+
+	printf ("=================== semihost test ==================\n\n");
+
+	sh = semihost_create (target, NULL);
+	if (sh == NULL) {
+		printf ("semihost create failed\n\n");
+		return -1;
+	}
+
+	// Serve the File-I/O halts of the program on the target for a while
+	target_resume (target);
+	start = host_time_us ();
+	while ((us = host_time_us () - start) < SEMIHOST_TEST_TIME_MS * 1000ULL) {
+		if (target_check_debug (target, &info) < 0) {
+			ret = -1;
+			break;
+		}
+		if (info.reason == DBG_REASON_RUNNING) {
+			continue;
+		}
+		if (info.reason != DBG_REASON_FILEIO) {
+			break;
+		}
+		if (semihost_handle (sh, &info) < 0) {
+			ret = -1;
+			break;
+		}
+	}
+	target_halt (target);
+	semihost_flush (sh);
+	semihost_get_stats (sh, &stats);
+	semihost_destroy (sh);
+
+	if (ret < 0) {
+		printf ("semihost test failed\n\n");
+		return -1;
+	}
+	if (stats.calls == 0) {
+		printf ("no semihosting calls from the program on the target\n\n");
+		return 0;
+	}
+	printf ("semihost successfully, %u calls in %llu ms, %.1f calls/s, %u writes (%u segments), "
+			"%.2f MB/s written, %u target accesses\n\n", stats.calls,
+			(unsigned long long)(us / 1000), stats.calls * 1000000.0 / us, stats.writes,
+			stats.segments, (double)stats.bytes_written / us, stats.transfers);
+	return 0;
+}